@@ -18,10 +18,12 @@
 // Globals would be fine for this example, but SDL gives you a way to pipe a data structure
 // through the functions too, so we'll use that.
 //
-// For now, we need to keep track of the window we're creating and the GPU driver device.
+// For now, we need to keep track of the window we're creating and the GPU driver device,
+// and whether the window needs drawing again.
 typedef struct AppContext {
     SDL_Window* window;
     SDL_GPUDevice* device;
+    bool needsRedraw;
 } AppContext;
 
 // SDL_AppInit is the first function that will be called. This is where you initialize SDL,
@@ -83,8 +85,15 @@ SDL_AppResult SDL_AppInit(
     AppContext* context = SDL_malloc(sizeof(AppContext));
     context->window = window;
     context->device = device;
+    context->needsRedraw = true;
     *appState = context;
 
+    // All we ever draw is a solid color, so once it's on screen there's no reason to keep
+    // drawing it over and over. This hint tells SDL to only call SDL_AppIterate after
+    // events come in, rather than as fast as it can, so we're not burning CPU (and GPU)
+    // time on identical frames.
+    SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, "waitevent");
+
     // And that's it for initialization.
     return SDL_APP_CONTINUE;
 }
@@ -97,6 +106,12 @@ SDL_AppResult SDL_AppIterate(void* appState)
     // Generally speaking, this is where you'd track frame times, update your game state, etc.
     // I'll be doing that in later posts.
 
+    // Most events don't change what's on screen, so skip the frame unless one did.
+    if (!context->needsRedraw) {
+        return SDL_APP_CONTINUE;
+    }
+    context->needsRedraw = false;
+
     // Once you're ready to start drawing, begin by grabbing a command buffer and a reference to the
     // swapchain texture.
     SDL_GPUCommandBuffer* cmdBuf;
@@ -153,6 +168,14 @@ SDL_AppResult SDL_AppIterate(void* appState)
 
 SDL_AppResult SDL_AppEvent(void* appState, SDL_Event* event)
 {
+    // The window's contents need drawing again when it's resized, or uncovered after
+    // being hidden or minimized.
+    AppContext* context = (AppContext*)appState;
+    if (event->type == SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED || event->type == SDL_EVENT_WINDOW_EXPOSED ||
+        event->type == SDL_EVENT_WINDOW_SHOWN || event->type == SDL_EVENT_WINDOW_RESTORED) {
+        context->needsRedraw = true;
+    }
+
     // SDL_EVENT_QUIT is sent when the main (last?) application window closes.
     if (event->type == SDL_EVENT_QUIT) {
         // SDL_APP_SUCCESS means we're making a clean exit.
@@ -13,10 +13,12 @@
 // example's source file and move things we've already seen out of the way
 // to keep the file easy to read. Common stuff has been moved out to GBECommon.
 #include <GBECommon/GBE_Init.h>
+#include <GBECommon/GBE_Frame.h>
 
 // Loading shaders is, unfortunately, somewhat involved. I'll cover further
 // what's going on here in a follow-up post.
 #include <GBECommon/GBE_Shaders.h>
+#include <GBECommon/GBE_PipelineCache.h>
 
 // Our app context structure this time needs to keep track of a pipeline and
 // vertex buffer.
@@ -49,119 +51,32 @@ const Vertex kVertices[] = {
 
 static SDL_AppResult BuildPipeline(AppContext* context)
 {
-    GBE_LoadShaderInfo vertexShaderInfo = {
-        .path = "PositionColor",
-        .stage = SDL_GPU_SHADERSTAGE_VERTEX,
-        .samplerCount = 0,
-        .uniformBufferCount = 0,
-        .storageBufferCount = 0,
-        .storageTextureCount = 0
-    };
-
-    SDL_GPUShader* vertexShader = GBE_LoadShader(&context->common, &vertexShaderInfo);
-    if (vertexShader == NULL) {
-        return SDL_APP_FAILURE;
-    }
-
-    GBE_LoadShaderInfo fragmentShaderInfo = {
-        .path = "Color",
-        .stage = SDL_GPU_SHADERSTAGE_FRAGMENT,
-        .samplerCount = 0,
-        .uniformBufferCount = 0,
-        .storageBufferCount = 0,
-        .storageTextureCount = 0
-    };
-
-    SDL_GPUShader* fragmentShader = GBE_LoadShader(&context->common, &fragmentShaderInfo);
-    if (fragmentShader == NULL) {
-        SDL_ReleaseGPUShader(context->common.device, vertexShader);
-        return SDL_APP_FAILURE;
-    }
-
-    // Lots of stuff here! Let's take it one chunk at a time. First, we describe the
-    // render target, which includes both a target pixel format and how we want to
-    // blend colors into it.
-    SDL_GPUTextureFormat targetFormat = SDL_GetGPUSwapchainTextureFormat(context->common.device, context->common.window);
-
-    SDL_GPUGraphicsPipelineTargetInfo targetInfo = {
-        .num_color_targets = 1,
-        .color_target_descriptions = (SDL_GPUColorTargetDescription[]) {{
-            .format = targetFormat,
-            .blend_state = {
-                .enable_blend = true,
-                .color_blend_op = SDL_GPU_BLENDOP_ADD,
-                .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
-                .src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
-                .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
-                .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
-                .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA
-            }
-        }}
-    };
-
-    // Then, how we want our primitives rasterized.
-    SDL_GPURasterizerState rasterizerState = {
-        // We want to draw the interiors of the primitives, not just outlines
-        .fill_mode = SDL_GPU_FILLMODE_FILL,
-
-        // Don't draw primitives that are facing away from the screen
-        .cull_mode = SDL_GPU_CULLMODE_BACK,
-
-        // Our vertices are provided in counter-clockwise order
-        .front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE
-    };
+    // A pipeline bundles up everything about how to draw: which shaders to run, what
+    // shape the vertex data is in, how to rasterize primitives and how to blend the
+    // results into the render target. GBECommon describes all of that with a
+    // GBE_PipelineDesc, which starts out from a preset. We blend colors into the target
+    // by their alpha, so that's the alpha blended preset. The preset also sets up the
+    // usual rasterizer state: filled triangle lists, with the ones facing away from the
+    // screen culled, where our vertices are provided in counter-clockwise order.
+    GBE_PipelineDesc desc;
+    GBE_InitPipelineDesc(&desc, GBE_PIPELINE_ALPHA_BLEND, GBE_GetTargetFormat(&context->common), SDL_GPU_TEXTUREFORMAT_INVALID);
+
+    // The shaders get loaded when the pipeline's created, for whichever backend we're on.
+    desc.vertexShader.path = "PositionColor";
+    desc.fragmentShader.path = "Color";
 
     // We need to tell the pipeline exactly what shape our input data is going to be
     // in. Metal will let us get away without this and still work fine! Vulkan and
     // Direct3D12 will not.
-    SDL_GPUVertexInputState vertexInputState = {
-        .num_vertex_buffers = 1,
-        .vertex_buffer_descriptions = (SDL_GPUVertexBufferDescription[]){{
-            .slot = 0,
-            .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-            .instance_step_rate = 0,
-            .pitch = sizeof(Vertex)
-        }},
-        .num_vertex_attributes = 2,
-        .vertex_attributes = (SDL_GPUVertexAttribute[]){{
-            .buffer_slot = 0,
-            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-            .location = 0,
-            .offset = 0
-        }, {
-            .buffer_slot = 0,
-            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
-            .location = 1,
-            .offset = sizeof(float) * 2
-        }}
-    };
-
-    // That should be enough to create a pipeline! We provide the target info and
-    // rasterizer state defined above, we want to draw triangles, and we want to
-    // do it using the vertex and fragment shaders we loaded.
-    SDL_GPUGraphicsPipelineCreateInfo pipelineCreateInfo = {
-        .target_info = targetInfo,
-        .rasterizer_state = rasterizerState,
-        .vertex_input_state = vertexInputState,
-        .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-        .vertex_shader = vertexShader,
-        .fragment_shader = fragmentShader
-    };
-
-    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(context->common.device, &pipelineCreateInfo);
-    if (pipeline == NULL) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create graphics pipeline: %s", SDL_GetError());
-    }
-
-    // Now that the pipeline has been created, it's holding on to references to the shaders, so we
-    // don't need to keep them around anymore. (I think they're reference counted, and the pipeline
-    // retained them.)
-    SDL_ReleaseGPUShader(context->common.device, vertexShader);
-    SDL_ReleaseGPUShader(context->common.device, fragmentShader);
-
-    // Store the created pipeline (or the NULL if it failed) in our application context and be done.
-    context->pipeline = pipeline;
-    return pipeline != NULL ? SDL_APP_CONTINUE : SDL_APP_FAILURE;
+    GBE_AddPipelineVertexBuffer(&desc, 0, sizeof(Vertex), SDL_GPU_VERTEXINPUTRATE_VERTEX);
+    GBE_AddPipelineVertexAttribute(&desc, 0, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2, 0);
+    GBE_AddPipelineVertexAttribute(&desc, 0, 1, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4, sizeof(float) * 2);
+
+    // Pipelines are expensive to create, so they're shared through a cache: asking for
+    // one that's already been created hands back the same one. Each acquire needs a
+    // matching GBE_ReleaseCachedPipeline.
+    context->pipeline = GBE_AcquireCachedPipeline(&context->common, &desc);
+    return context->pipeline != NULL ? SDL_APP_CONTINUE : SDL_APP_FAILURE;
 }
 
 static SDL_AppResult BuildVertexBuffer(AppContext* context)
@@ -216,11 +131,23 @@ SDL_AppResult SDL_AppInit(void** appState, int argc, char** argv)
     SDL_SetAppMetadata("GPU by Example - Drawing Primitives", "0.0.1", "net.jonathanfischer.GpuByExample2");
 
     AppContext* appContext = SDL_calloc(sizeof(AppContext), 1);
-    SDL_AppResult rc = GBE_CommonInit(&appContext->common, "GPU by Example - Drawing Primitives");
+    *appState = appContext;
+
+    // Command line options let us run headless, at a fixed size, for a fixed number of
+    // frames, etc.; handy for automated test and benchmark runs.
+    GBE_InitConfig config;
+    GBE_DefaultInitConfig(&config, "GPU by Example - Drawing Primitives");
+
+    // Our triangle never moves, so there's no point drawing it again until something
+    // makes us: the window being resized or uncovered, say. --on-demand does just that,
+    // and SDL sits and waits for events in between instead of calling SDL_AppIterate as
+    // fast as it can. It's left off by default so --frames counts every frame.
+    GBE_ApplyCommandLine(&config, argc, argv);
+
+    SDL_AppResult rc = GBE_CommonInitWithConfig(&appContext->common, &config);
     if (rc != SDL_APP_CONTINUE) {
         return rc;
     }
-    *appState = appContext;
 
     rc = BuildPipeline(appContext);
     if (rc != SDL_APP_CONTINUE) {
@@ -234,23 +161,20 @@ SDL_AppResult SDL_AppInit(void** appState, int argc, char** argv)
 SDL_AppResult SDL_AppIterate(void* appState)
 {
     AppContext* context = (AppContext*)appState;
-
-    SDL_GPUCommandBuffer* cmdBuf;
-    cmdBuf = SDL_AcquireGPUCommandBuffer(context->common.device);
-    if (cmdBuf == NULL) {
-        SDL_Log("SDL_AcquireGPUCommandBuffer failed: %s", SDL_GetError());
-        return SDL_APP_FAILURE;
+    if (!GBE_ShouldRender(&context->common)) {
+        return SDL_APP_CONTINUE;
     }
 
-    SDL_GPUTexture* swapchainTexture;
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdBuf, context->common.window, &swapchainTexture, NULL, NULL)) {
-        SDL_Log("SDL_WaitAndAcquireGPUSwapchainTexture: %s", SDL_GetError());
-        return SDL_APP_FAILURE;
+    GBE_Frame frame;
+    SDL_AppResult rc = GBE_BeginFrame(&context->common, &frame);
+    if (rc != SDL_APP_CONTINUE) {
+        return rc;
     }
 
-    if (swapchainTexture != NULL) {
+    SDL_GPUCommandBuffer* cmdBuf = frame.commandBuffer;
+    if (frame.target != NULL) {
         SDL_GPUColorTargetInfo targetInfo = {
-            .texture = swapchainTexture,
+            .texture = frame.target,
             .cycle = false,
             .load_op = SDL_GPU_LOADOP_CLEAR,
             .store_op = SDL_GPU_STOREOP_STORE,
@@ -277,14 +201,15 @@ SDL_AppResult SDL_AppIterate(void* appState)
         SDL_EndGPURenderPass(renderPass);
     }
 
-    SDL_SubmitGPUCommandBuffer(cmdBuf);
-
     // That's it for this frame.
-    return SDL_APP_CONTINUE;
+    return GBE_EndFrame(&context->common, &frame);
 }
 
 SDL_AppResult SDL_AppEvent(void* appState, SDL_Event* event)
 {
+    AppContext* context = (AppContext*)appState;
+    GBE_HandleEvent(&context->common, event);
+
     if (event->type == SDL_EVENT_QUIT) {
         return SDL_APP_SUCCESS;
     }
@@ -303,9 +228,7 @@ void SDL_AppQuit(void* appState, SDL_AppResult result)
         SDL_ReleaseGPUBuffer(context->common.device, context->vertexBuffer);
     }
 
-    if (context->pipeline != NULL) {
-        SDL_ReleaseGPUGraphicsPipeline(context->common.device, context->pipeline);
-    }
+    GBE_ReleaseCachedPipeline(&context->common, context->pipeline);
 
     GBE_Quit(&context->common);
     SDL_free(context);
@@ -0,0 +1,71 @@
+// FrustumCull.comp.hlsl
+//
+// Tests every cube's bounding sphere against the camera's frustum and
+// writes the transforms of the ones that survive, packed together, for
+// the STORAGE_TRANSFORMS variant of SpinningCube to draw. The number of
+// survivors goes straight into the arguments of an indirect draw, so the
+// CPU never needs to know how many there were.
+//
+// Compile this for Direct3D 12 with:
+// dxc -T cs_6_0 FrustumCull.comp.hlsl -Fo FrustumCull.comp.dxil
+//
+// or for Vulkan with:
+// dxc -spirv -T cs_6_0 FrustumCull.comp.hlsl -Fo FrustumCull.comp.spv
+
+// Compute shaders take read-only storage buffers in space0, read-write
+// ones in space1 and uniforms in space2.
+
+// Each cube's position; w is unused.
+StructuredBuffer<float4> Objects : register(t0, space0);
+
+RWStructuredBuffer<float4x4> VisibleTransforms : register(u0, space1);
+
+// An SDL_GPUIndexedIndirectDrawCommand: num_indices, num_instances,
+// first_index, vertex_offset, first_instance. num_instances starts each
+// frame at 0 and counts up.
+RWStructuredBuffer<uint> DrawArguments : register(u1, space1);
+
+// Which cube each survivor is, in the same order as VisibleTransforms, so
+// the results can be checked against the CPU's.
+RWStructuredBuffer<uint> VisibleObjects : register(u2, space1);
+
+cbuffer CullUniforms : register(b0, space2)
+{
+    // Every cube shares the same rotation and scale, then gets moved to
+    // its own position and through the camera.
+    float4x4 ModelMatrix;
+    float4x4 ViewProjectionMatrix;
+
+    // Inward facing, normalized, in world space.
+    float4 FrustumPlanes[6];
+
+    uint ObjectCount;
+    float ObjectRadius;
+};
+
+[numthreads(64, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    uint index = id.x;
+    if (index >= ObjectCount) {
+        return;
+    }
+
+    float3 center = Objects[index].xyz;
+    for (int i = 0; i < 6; i++) {
+        if (dot(FrustumPlanes[i].xyz, center) + FrustumPlanes[i].w < -ObjectRadius) {
+            return;
+        }
+    }
+
+    float4x4 translation = float4x4(
+        1, 0, 0, center.x,
+        0, 1, 0, center.y,
+        0, 0, 1, center.z,
+        0, 0, 0, 1);
+
+    uint slot;
+    InterlockedAdd(DrawArguments[1], 1, slot);
+    VisibleTransforms[slot] = mul(ViewProjectionMatrix, mul(translation, ModelMatrix));
+    VisibleObjects[slot] = index;
+}
@@ -8,11 +8,23 @@
 //
 // or for Vulkan with:
 // dxc -spirv -T vs_6_0 SpinningCube.vert.hlsl -Fo SpinningCube.vert.spv
+//
+// The variants listed in SpinningCube.vert.permutations are built with
+// Tools/compile-shader-permutations.sh instead.
 
 struct InputVertex
 {
     float4 Position : TEXCOORD0;
     float4 Color : TEXCOORD1;
+#if INSTANCED
+    // These come from the per-instance vertex buffer: the cube's transform, one row at
+    // a time, and its color.
+    float4 TransformRow0 : TEXCOORD2;
+    float4 TransformRow1 : TEXCOORD3;
+    float4 TransformRow2 : TEXCOORD4;
+    float4 TransformRow3 : TEXCOORD5;
+    float4 InstanceColor : TEXCOORD6;
+#endif
 };
 
 struct OutputVertex
@@ -21,6 +33,35 @@ struct OutputVertex
     float4 Color : TEXCOORD0;
 };
 
+#if INSTANCED
+OutputVertex main(InputVertex vertex_in)
+{
+    // The rows come in the same order a uniform buffer would hold them, and a uniform
+    // buffer's matrix is read column by column, so build the matrix from the rows and
+    // multiply from the other side to match.
+    float4x4 transform = float4x4(vertex_in.TransformRow0, vertex_in.TransformRow1,
+                                  vertex_in.TransformRow2, vertex_in.TransformRow3);
+
+    OutputVertex vertex_out;
+    vertex_out.Position = mul(vertex_in.Position, transform);
+    vertex_out.Color = vertex_in.Color * vertex_in.InstanceColor;
+    return vertex_out;
+}
+
+#elif STORAGE_TRANSFORMS
+// Every cube's transform, in one buffer, drawn with a single instanced draw call.
+// Vertex stage storage buffers live in space0.
+StructuredBuffer<float4x4> Transforms : register(t0, space0);
+
+OutputVertex main(InputVertex vertex_in, uint instance : SV_InstanceID)
+{
+    OutputVertex vertex_out;
+    vertex_out.Position = mul(Transforms[instance], vertex_in.Position);
+    vertex_out.Color = vertex_in.Color;
+    return vertex_out;
+}
+
+#else
 cbuffer UniformBlock : register(b0, space1)
 {
     float4x4 ModelViewProjectionMatrix : packoffset(c0);
@@ -33,4 +74,4 @@ OutputVertex main(InputVertex vertex_in)
     vertex_out.Color = vertex_in.Color;
     return vertex_out;
 }
-
+#endif
@@ -10,8 +10,20 @@
 #include <SDL3/SDL_main.h>
 #include <GBECommon/GBE_3DMath.h>
 #include <GBECommon/GBE_Init.h>
+#include <GBECommon/GBE_Frame.h>
 #include <GBECommon/GBE_Context.h>
 #include <GBECommon/GBE_Shaders.h>
+#include <GBECommon/GBE_PipelineCache.h>
+#include <GBECommon/GBE_RenderPass.h>
+#include <GBECommon/GBE_DrawList.h>
+#include <GBECommon/GBE_BufferArena.h>
+#include <GBECommon/GBE_FrameClock.h>
+#include <GBECommon/GBE_ParallelRecorder.h>
+#include <GBECommon/GBE_Jobs.h>
+#include <GBECommon/GBE_TripleBuffer.h>
+#include <GBECommon/GBE_UploadQueue.h>
+#include <GBECommon/GBE_ReleaseQueue.h>
+#include <GBECommon/GBE_StagingRing.h>
 
 // Why in the world does Visual Studio not define M_PI and the like
 // without this extra bit?
@@ -27,21 +39,199 @@ typedef struct Uniforms {
     GBE_Matrix4x4 modelViewProjectionMatrix;
 } Uniforms;
 
+// What the instanced pipeline reads from its second vertex buffer, once per cube rather
+// than once per vertex.
+typedef struct CubeInstance {
+    GBE_Matrix4x4 modelViewProjectionMatrix;
+    GBE_Vector4 color;
+} CubeInstance;
+
+// How each cube's transform gets to the vertex shader.
+//
+// - TRANSFORMS_PUSH pushes it as uniform data right before drawing that cube, so N cubes
+//   is N pushes and N draws. That's how Example 3 started out.
+// - TRANSFORMS_STORAGE writes all of them into one storage buffer, uploads it once per
+//   frame, and draws every cube in one instanced draw; the shader picks its transform
+//   out of the buffer by instance ID.
+// - TRANSFORMS_INSTANCED puts each cube's transform and color in a second vertex buffer
+//   that advances once per instance instead of once per vertex, and also draws every
+//   cube in one instanced draw.
+// - TRANSFORMS_GPU_CULLED leaves the CPU out of it entirely: a compute shader tests each
+//   cube against the camera's frustum, writes the transforms of the visible ones into
+//   the storage buffer, and fills in the arguments of an indirect draw that draws just
+//   those. The CPU's work stays the same however many cubes there are.
+typedef enum TransformMode {
+    TRANSFORMS_PUSH,
+    TRANSFORMS_STORAGE,
+    TRANSFORMS_INSTANCED,
+    TRANSFORMS_GPU_CULLED
+} TransformMode;
+
+// What FrustumCull.comp gets as uniforms. Keep this in sync with the shader.
+typedef struct CullUniforms {
+    GBE_Matrix4x4 modelMatrix;
+    GBE_Matrix4x4 viewProjectionMatrix;
+    GBE_Vector4 frustumPlanes[6];
+    Uint32 objectCount;
+    float objectRadius;
+    float padding[2];
+} CullUniforms;
+
+// Has to match the numthreads in FrustumCull.comp.
+#define CULL_THREAD_COUNT 64
+
+// Shader feature bits; see SpinningCube.vert.permutations.
+#define CUBE_FEATURE_STORAGE_TRANSFORMS (1u << 0)
+#define CUBE_FEATURE_INSTANCED          (1u << 1)
+
+// Everything a frame is drawn from, worked out by frameStep: this frame's camera and the
+// rotation and scale every cube shares (in GPU culled mode these are all the CPU works
+// out; the compute shader does the rest), and each cube's transform. `stamp` hashes the
+// two matrices, so a frame can tell when nothing's moved, and `simulatedNS` is when it was
+// worked out.
+//
+// Normally there's just the one. With --pipelined, a simulation thread works out the
+// next frame's while the render thread draws this one, handing them over in a triple
+// buffer; there, each slot is a Scene followed by its transforms.
+typedef struct Scene {
+    GBE_Matrix4x4 cubeModelMatrix;
+    GBE_Matrix4x4 viewProjectionMatrix;
+    float cubeRadius;
+    Uint64 stamp;
+    Uint64 simulatedNS;
+    GBE_Matrix4x4* cubeTransforms;
+} Scene;
+
+// Where a triple buffer slot's transforms start, after its Scene.
+#define SCENE_HEADER_SIZE ((sizeof(Scene) + 15) & ~(size_t)15)
+
+// Everything the simulation moves along; each frame's scene is worked out from it.
+typedef struct SimulationState {
+    double elapsedSeconds;
+    float rotationX;
+    float rotationY;
+} SimulationState;
+
 typedef struct AppContext {
     GBE_Context context;
 
     SDL_GPUGraphicsPipeline* pipeline;
-    SDL_GPUBuffer* vertexBuffer;
-    SDL_GPUBuffer* indexBuffer;
 
-    Uint64 lastFrameTime;
-    Uint64 elapsedTime;
-    float rotationX;
-    float rotationY;
+    // The cube's vertices and indices are both ranges of one shared buffer, so every draw
+    // says where in it they start with first_index and vertex_offset.
+    GBE_BufferArena meshArena;
+    GBE_BufferRange cubeVertices;
+    GBE_BufferRange cubeIndices;
+
+    // Everything the cubes are drawn from goes up through this at startup; see BuildBuffers.
+    GBE_UploadQueue uploadQueue;
+
+    // --cubes N draws a grid of N cubes instead of just the one, so the different ways
+    // of getting transforms to the GPU can be compared as the count goes up.
+    Uint32 numCubes;
+    TransformMode transformMode;
+
+    // --stacked lines the cubes up one behind the other, each filling most of the screen,
+    // to measure fill rate instead; --blend picks the pipeline preset to draw them with.
+    bool stacked;
+    GBE_PipelinePreset blendPreset;
+    GBE_Vector3* cubePositions;
+    GBE_Vector4* cubeColors;
+    SDL_GPUBuffer* transformBuffer;
+    SDL_GPUBuffer* instanceBuffer;
+    GBE_StagingRing stagingRing;
+
+    // The scene this frame is drawn from: `ownScene`, or the newest one the simulation
+    // thread's finished with --pipelined.
+    Scene ownScene;
+    const Scene* scene;
+
+    // GPU culled mode: each cube's position for the compute shader, and the indirect draw
+    // arguments and list of surviving cubes it writes. With --validate-cull, the GPU's
+    // results are checked against the same test done on the CPU every so often.
+    SDL_GPUComputePipeline* cullPipeline;
+    SDL_GPUBuffer* objectBuffer;
+    SDL_GPUBuffer* drawArgumentsBuffer;
+    SDL_GPUBuffer* visibleCubesBuffer;
+    bool validateCulling;
+
+    // How long recording each frame's commands has taken on the CPU, how long the frames
+    // took overall, and how many binds and pushes reached SDL or were filtered out as
+    // redundant (all of them reach it with --no-state-filter), for the summary logged at
+    // exit.
+    Uint64 recordingNS;
+    Uint64 firstFrameNS;
+    Uint64 framesRecorded;
+    bool filterState;
+    Uint64 stateCallsIssued;
+    Uint64 stateCallsSkipped;
+
+    // Push mode options: --mixed-pipelines alternates the cubes between two pipelines, and
+    // --draw-list records the cubes' draws into a draw list and sorts them (by pipeline,
+    // then front to back) before replaying them, rather than issuing them in grid order.
+    bool mixedPipelines;
+    SDL_GPUGraphicsPipeline* secondPipeline;
+    bool useDrawList;
+    GBE_DrawList drawList;
+    Uint64 drawListSortNS;
+    Uint64 drawListReplayNS;
+
+    // --static stops the cubes spinning and the camera moving. The transforms are then only
+    // worked out again when the scene's stamp changes, e.g. when the window's resized, and
+    // in push mode the draw list is kept and baked instead of recorded every frame;
+    // `drawListRecordings` counts how often it wasn't.
+    bool staticScene;
+    Uint64 drawListRecordings;
+
+    // --record-threads N records push mode's draws on N threads at once, each with its own
+    // command buffer (see GBE_ParallelRecorder.h); `slowestThreadNS` adds up the longest
+    // any one of them took each frame.
+    int recordThreads;
+    GBE_ParallelRecorder recorder;
+    Uint64 slowestThreadNS;
+
+    // --jobs N works out the cubes' transforms on N threads with the job system (0 for
+    // one per core).
+    bool useJobs;
+    int jobThreads;
+    GBE_JobSystem jobs;
+
+    // --pipelined runs frameStep on a simulation thread, one frame ahead of the render
+    // thread. It waits on `sceneTaken` once it's a frame ahead, so it runs at the render
+    // rate, and finds out how big the
+    // target is from `targetSize` (width << 16 | height), since the render thread owns
+    // the context. `scenesRepeated` counts frames drawn from a scene that had already been
+    // drawn, because the next one wasn't ready, and `sceneAgeNS` adds up how long ago each
+    // frame's scene was worked out by the time it was submitted.
+    bool pipelined;
+    GBE_TripleBuffer sceneBuffer;
+    SDL_Thread* simulationThread;
+    SDL_Semaphore* sceneTaken;
+    SDL_Semaphore* firstScene;
+    SDL_AtomicInt quitSimulation;
+    SDL_AtomicInt simulationFailed;
+    SDL_AtomicU32 targetSize;
+    Uint64 scenesRepeated;
+    Uint64 sceneAgeNS;
+
+    // Only touched by whichever thread runs frameStep. `--sim-rate HZ` moves the
+    // simulation along in fixed steps at that rate, and each frame blends the last two
+    // states; otherwise it takes one step a frame, as long as the smoothed frame time.
+    GBE_FrameClock clock;
+    Uint32 simulationRate;
+    SimulationState previousState;
+    SimulationState currentState;
 
     Uniforms uniforms;
 } AppContext;
 
+// How far apart the cubes are when there's more than one, in a grid or stacked.
+static const float kCubeSpacing = 3.0f;
+static const float kStackSpacing = 0.05f;
+
+// How much the upload queue puts in each transfer buffer it submits.
+static const Uint32 kUploadBatchSize = 1024 * 1024;
+
 static const Uint32 kNumVertices = 8;
 static const Uint32 kNumIndices = 36;
 static const Vertex kVertices[] = {
@@ -64,214 +254,623 @@ static const Uint16 kIndices[] = {
     7, 6, 5, 5, 4, 7
 };
 
+static const char* GetTransformModeName(TransformMode mode)
+{
+    switch (mode) {
+    case TRANSFORMS_STORAGE:
+        return "storage buffer";
+    case TRANSFORMS_INSTANCED:
+        return "instanced vertex buffer";
+    case TRANSFORMS_GPU_CULLED:
+        return "GPU culled";
+    default:
+        return "pushed uniform";
+    }
+}
+
+static const char* GetBlendPresetName(GBE_PipelinePreset preset)
+{
+    switch (preset) {
+    case GBE_PIPELINE_ALPHA_BLEND:
+        return "alpha blended";
+    case GBE_PIPELINE_ADDITIVE:
+        return "additive";
+    default:
+        return "opaque";
+    }
+}
+
 static SDL_AppResult BuildPipeline(AppContext* context)
 {
-    GBE_LoadShaderInfo vertexShaderInfo = {
-        .path = "SpinningCube",
-        .stage = SDL_GPU_SHADERSTAGE_VERTEX,
-        .samplerCount = 0,
-        .uniformBufferCount = 1,
-        .storageBufferCount = 0,
-        .storageTextureCount = 0
-    };
+    // The cubes are solid, so they get the opaque preset (unless --blend says otherwise):
+    // no blending, and depth testing and writing against the frame's depth buffer, so
+    // hidden parts of cubes are thrown out before they're shaded and it doesn't matter
+    // which order the cubes are drawn in. It fills in the rest of the usual settings too:
+    // filled triangle lists, with back faces (counter-clockwise is front) culled.
+    GBE_PipelineDesc desc;
+    GBE_InitPipelineDesc(&desc, context->blendPreset, GBE_GetTargetFormat(&context->context), GBE_GetDepthFormat(&context->context));
+
+    desc.vertexShader.path = "SpinningCube";
+    desc.vertexShader.uniformBufferCount = 1;
+    desc.fragmentShader.path = "Color";
+
+    // The storage buffer variant reads its transforms from a buffer instead of a uniform.
+    // GPU culling fills that same buffer in with a compute shader.
+    if (context->transformMode == TRANSFORMS_STORAGE || context->transformMode == TRANSFORMS_GPU_CULLED) {
+        desc.vertexShader.features = CUBE_FEATURE_STORAGE_TRANSFORMS;
+        desc.vertexShader.uniformBufferCount = 0;
+        desc.vertexShader.storageBufferCount = 1;
+    }
+    else if (context->transformMode == TRANSFORMS_INSTANCED) {
+        desc.vertexShader.features = CUBE_FEATURE_INSTANCED;
+        desc.vertexShader.uniformBufferCount = 0;
+    }
+
+    // We need to tell the pipeline exactly what shape our input data is going to be
+    // in. Metal will let us get away without this and still work fine! Vulkan and
+    // Direct3D12 will not.
+    GBE_AddPipelineVertexBuffer(&desc, 0, sizeof(Vertex), SDL_GPU_VERTEXINPUTRATE_VERTEX);
+    GBE_AddPipelineVertexAttribute(&desc, 0, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4, 0);
+    GBE_AddPipelineVertexAttribute(&desc, 0, 1, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4, sizeof(float) * 4);
+
+    // The instanced pipeline has a second buffer, stepped once per instance: a 4x4
+    // matrix goes in as 4 float4 attributes, followed by the cube's color.
+    if (context->transformMode == TRANSFORMS_INSTANCED) {
+        GBE_AddPipelineVertexBuffer(&desc, 1, sizeof(CubeInstance), SDL_GPU_VERTEXINPUTRATE_INSTANCE);
+        for (Uint32 i = 0; i < 5; i++) {
+            GBE_AddPipelineVertexAttribute(&desc, 1, 2 + i, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4, sizeof(float) * 4 * i);
+        }
+    }
+
+    // Pipelines come from the context's cache, which hands back the same one to anything
+    // that describes it the same way.
+    SDL_GPUGraphicsPipeline* pipeline = GBE_AcquireCachedPipeline(&context->context, &desc);
+    if (pipeline != NULL && context->transformMode == TRANSFORMS_GPU_CULLED) {
+        GBE_LoadComputePipelineInfo cullInfo = {
+            .path = "FrustumCull",
+            .readonlyStorageBufferCount = 1,
+            .readwriteStorageBufferCount = 3,
+            .uniformBufferCount = 1,
+            .threadCountX = CULL_THREAD_COUNT,
+            .threadCountY = 1,
+            .threadCountZ = 1
+        };
+        context->cullPipeline = GBE_LoadComputePipeline(&context->context, &cullInfo);
+        if (context->cullPipeline == NULL) {
+            GBE_ReleaseCachedPipeline(&context->context, pipeline);
+            pipeline = NULL;
+        }
+        GBE_TrackResource(&context->context, GBE_RESOURCE_COMPUTE_PIPELINE, context->cullPipeline, "frustum cull");
+    }
+
+    // Falling back to pushing uniforms would quietly measure something other than what
+    // was asked for, so a missing variant is fatal.
+    if (pipeline == NULL && context->transformMode != TRANSFORMS_PUSH) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't load the shaders for %s transforms. On Vulkan and Direct3D 12 they're "
+            "compiled with dxc when building with CMake, or by Tools/compile-shader-permutations.sh.",
+            GetTransformModeName(context->transformMode));
+    }
+
+    // --mixed-pipelines gives every other cube a second pipeline, standing in for a second
+    // material. It only differs in not culling back faces, which a closed cube doesn't
+    // need anyway, so it looks the same.
+    if (pipeline != NULL && context->mixedPipelines && context->transformMode == TRANSFORMS_PUSH) {
+        desc.rasterizerState.cull_mode = SDL_GPU_CULLMODE_NONE;
+        context->secondPipeline = GBE_AcquireCachedPipeline(&context->context, &desc);
+        if (context->secondPipeline == NULL) {
+            GBE_ReleaseCachedPipeline(&context->context, pipeline);
+            pipeline = NULL;
+        }
+    }
 
-    SDL_GPUShader* vertexShader = GBE_LoadShader(&context->context, &vertexShaderInfo);
-    if (vertexShader == NULL) {
+    // Store the pipeline (or the NULL if it failed) in our application context and be done.
+    context->pipeline = pipeline;
+    return pipeline != NULL ? SDL_APP_CONTINUE : SDL_APP_FAILURE;
+}
+
+static void FreeUploadedData(void* userdata, SDL_GPUBuffer* buffer, Uint32 offset, Uint32 size, bool succeeded)
+{
+    SDL_free(userdata);
+}
+
+static SDL_AppResult BuildBuffers(AppContext* context)
+{
+    // Rather than a vertex buffer and an index buffer of its own, the cube gets a range of
+    // a buffer arena for each. A real scene would have lots of meshes sharing the arena;
+    // here the indices just end up after the vertices, which is enough to see the draws
+    // finding them by first_index instead of assuming they start at 0. Index buffers use
+    // a different usage type than vertex buffers, so the arena's buffer has both.
+    if (!GBE_CreateBufferArena(&context->context, SDL_GPU_BUFFERUSAGE_VERTEX | SDL_GPU_BUFFERUSAGE_INDEX, 64 * 1024, &context->meshArena) ||
+        !GBE_BufferArenaAlloc(&context->meshArena, kNumVertices, sizeof(Vertex), &context->cubeVertices) ||
+        !GBE_BufferArenaAlloc(&context->meshArena, kNumIndices, sizeof(Uint16), &context->cubeIndices)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't make room for the cube in the mesh arena.");
         return SDL_APP_FAILURE;
     }
 
-    GBE_LoadShaderInfo fragmentShaderInfo = {
-        .path = "Color",
-        .stage = SDL_GPU_SHADERSTAGE_FRAGMENT,
-        .samplerCount = 0,
-        .uniformBufferCount = 0,
-        .storageBufferCount = 0,
-        .storageTextureCount = 0
-    };
+    // Example 2 walked through creating a transfer buffer, copying into it, and asking the
+    // GPU to copy from there into a vertex buffer. Doing that separately for every buffer
+    // means a transfer buffer, a copy pass and a trip to the GPU each, so everything the
+    // cubes are drawn from goes into an upload queue instead. It packs as much as fits
+    // into each transfer buffer it submits, and calls back as each piece lands.
+    if (!GBE_CreateUploadQueue(&context->context, kUploadBatchSize, &context->uploadQueue) ||
+        !GBE_QueueUpload(&context->uploadQueue, kVertices, context->cubeVertices.size, context->meshArena.buffer, context->cubeVertices.offset, NULL, NULL) ||
+        !GBE_QueueUpload(&context->uploadQueue, kIndices, context->cubeIndices.size, context->meshArena.buffer, context->cubeIndices.offset, NULL, NULL)) {
+        return SDL_APP_FAILURE;
+    }
 
-    SDL_GPUShader* fragmentShader = GBE_LoadShader(&context->context, &fragmentShaderInfo);
-    if (fragmentShader == NULL) {
-        SDL_ReleaseGPUShader(context->context.device, vertexShader);
+    // The cubes are laid out in a square grid, centered on the origin, or stacked up going
+    // away from the camera, nearest first.
+    context->cubePositions = SDL_malloc(sizeof(GBE_Vector3) * context->numCubes);
+    context->ownScene.cubeTransforms = SDL_malloc(sizeof(GBE_Matrix4x4) * context->numCubes);
+    context->scene = &context->ownScene;
+    if (context->cubePositions == NULL || context->ownScene.cubeTransforms == NULL) {
         return SDL_APP_FAILURE;
     }
 
-    // Lots of stuff here! Let's take it one chunk at a time. First, we describe the
-    // render target, which includes both a target pixel format and how we want to
-    // blend colors into it.
-    SDL_GPUTextureFormat targetFormat = SDL_GetGPUSwapchainTextureFormat(context->context.device, context->context.window);
-
-    SDL_GPUGraphicsPipelineTargetInfo targetInfo = {
-        .num_color_targets = 1,
-        .color_target_descriptions = (SDL_GPUColorTargetDescription[]) {{
-            .format = targetFormat,
-            .blend_state = {
-                .enable_blend = true,
-                .color_blend_op = SDL_GPU_BLENDOP_ADD,
-                .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
-                .src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
-                .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
-                .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
-                .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA
-            }
-        }}
-    };
+    Uint32 gridSize = (Uint32)SDL_ceil(SDL_sqrt((double)context->numCubes));
+    float gridExtent = (gridSize - 1) * kCubeSpacing / 2;
+    for (Uint32 i = 0; i < context->numCubes; i++) {
+        if (context->stacked) {
+            context->cubePositions[i] = (GBE_Vector3) { 0, 0, -(float)i * kStackSpacing };
+            continue;
+        }
+
+        context->cubePositions[i] = (GBE_Vector3) {
+            (i % gridSize) * kCubeSpacing - gridExtent,
+            (i / gridSize) * kCubeSpacing - gridExtent,
+            0
+        };
+    }
 
-    // Then, how we want our primitives rasterized.
-    SDL_GPURasterizerState rasterizerState = {
-        // We want to draw the interiors of the primitives, not just outlines
-        .fill_mode = SDL_GPU_FILLMODE_FILL,
+    // Storage buffer mode rewrites every cube's transform each frame: written linearly
+    // into the staging ring, then copied into the storage buffer in one go. GPU culled
+    // mode has the compute shader write them instead.
+    bool culled = context->transformMode == TRANSFORMS_GPU_CULLED;
+    if (context->transformMode == TRANSFORMS_STORAGE || culled) {
+        Uint32 transformsSize = (Uint32)(sizeof(GBE_Matrix4x4) * context->numCubes);
+        SDL_GPUBufferCreateInfo createInfo = {
+            .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ | (culled ? SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE : 0),
+            .size = transformsSize
+        };
+        context->transformBuffer = SDL_CreateGPUBuffer(context->context.device, &createInfo);
+        if (context->transformBuffer == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create transform buffer: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+        GBE_TrackResource(&context->context, GBE_RESOURCE_BUFFER, context->transformBuffer, "cube transforms");
+
+        // The culling pass only needs the staging ring to reset its draw arguments.
+        Uint32 stagingSize = culled ? (Uint32)sizeof(SDL_GPUIndexedIndirectDrawCommand) : transformsSize;
+        if (!GBE_CreateStagingRing(&context->context, stagingSize, &context->stagingRing)) {
+            return SDL_APP_FAILURE;
+        }
+    }
 
-        // Don't draw primitives that are facing away from the screen
-        .cull_mode = SDL_GPU_CULLMODE_BACK,
+    // The cubes never move from their spots in the grid, so the compute shader gets their
+    // positions once, up front.
+    if (culled) {
+        GBE_Vector4* objects = SDL_malloc(sizeof(GBE_Vector4) * context->numCubes);
+        if (objects == NULL) {
+            return SDL_APP_FAILURE;
+        }
+        for (Uint32 i = 0; i < context->numCubes; i++) {
+            GBE_Vector3 position = context->cubePositions[i];
+            objects[i] = (GBE_Vector4) { position.x, position.y, position.z, 1 };
+        }
+
+        SDL_GPUBufferCreateInfo objectInfo = {
+            .usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ,
+            .size = (Uint32)(sizeof(GBE_Vector4) * context->numCubes)
+        };
+        context->objectBuffer = SDL_CreateGPUBuffer(context->context.device, &objectInfo);
+        if (context->objectBuffer == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create cube position buffer: %s", SDL_GetError());
+            SDL_free(objects);
+            return SDL_APP_FAILURE;
+        }
+        GBE_TrackResource(&context->context, GBE_RESOURCE_BUFFER, context->objectBuffer, "cube positions");
+
+        // The queue doesn't copy the positions, so they're freed once it calls back.
+        if (!GBE_QueueUpload(&context->uploadQueue, objects, objectInfo.size, context->objectBuffer, 0, FreeUploadedData, objects)) {
+            SDL_free(objects);
+            return SDL_APP_FAILURE;
+        }
+
+        SDL_GPUBufferCreateInfo createInfo = {
+            .usage = SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+            .size = sizeof(SDL_GPUIndexedIndirectDrawCommand)
+        };
+        context->drawArgumentsBuffer = SDL_CreateGPUBuffer(context->context.device, &createInfo);
+        if (context->drawArgumentsBuffer == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create draw arguments buffer: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+        GBE_TrackResource(&context->context, GBE_RESOURCE_BUFFER, context->drawArgumentsBuffer, "cull draw arguments");
+
+        // Which cube each drawn instance is. Drawing doesn't need it, but it's what lets
+        // --validate-cull check exactly which cubes survived.
+        createInfo.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
+        createInfo.size = (Uint32)(sizeof(Uint32) * context->numCubes);
+        context->visibleCubesBuffer = SDL_CreateGPUBuffer(context->context.device, &createInfo);
+        if (context->visibleCubesBuffer == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create visible cubes buffer: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+        GBE_TrackResource(&context->context, GBE_RESOURCE_BUFFER, context->visibleCubesBuffer, "visible cubes");
+    }
 
-        // Our vertices are provided in counter-clockwise order
-        .front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE
-    };
+    // Instanced mode rewrites its per-instance vertex buffer each frame the same way. The
+    // colors don't change, so work them out once: a gradient across the grid.
+    if (context->transformMode == TRANSFORMS_INSTANCED) {
+        context->cubeColors = SDL_malloc(sizeof(GBE_Vector4) * context->numCubes);
+        if (context->cubeColors == NULL) {
+            return SDL_APP_FAILURE;
+        }
+
+        for (Uint32 i = 0; i < context->numCubes; i++) {
+            float t = context->numCubes > 1 ? (float)i / (context->numCubes - 1) : 1.0f;
+            context->cubeColors[i] = (GBE_Vector4) { 1.0f - t * 0.5f, 0.5f + t * 0.5f, 1.0f, 1.0f };
+        }
+
+        Uint32 instancesSize = (Uint32)(sizeof(CubeInstance) * context->numCubes);
+        SDL_GPUBufferCreateInfo createInfo = {
+            .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+            .size = instancesSize
+        };
+        context->instanceBuffer = SDL_CreateGPUBuffer(context->context.device, &createInfo);
+        if (context->instanceBuffer == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create instance buffer: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+        GBE_TrackResource(&context->context, GBE_RESOURCE_BUFFER, context->instanceBuffer, "cube instances");
+
+        if (!GBE_CreateStagingRing(&context->context, instancesSize, &context->stagingRing)) {
+            return SDL_APP_FAILURE;
+        }
+    }
 
-    // We need to tell the pipeline exactly what shape our input data is going to be
-    // in. Metal will let us get away without this and still work fine! Vulkan and
-    // Direct3D12 will not.
-    SDL_GPUVertexInputState vertexInputState = {
-        .num_vertex_buffers = 1,
-        .vertex_buffer_descriptions = (SDL_GPUVertexBufferDescription[]){{
-            .slot = 0,
-            .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-            .instance_step_rate = 0,
-            .pitch = sizeof(Vertex)
-        }},
-        .num_vertex_attributes = 2,
-        .vertex_attributes = (SDL_GPUVertexAttribute[]){{
-            .buffer_slot = 0,
-            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
-            .location = 0,
-            .offset = 0
-        }, {
-            .buffer_slot = 0,
-            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
-            .location = 1,
-            .offset = sizeof(float) * 4
-        }}
-    };
+    if (context->transformMode == TRANSFORMS_PUSH && context->useDrawList &&
+        !GBE_CreateDrawList(context->numCubes, (Uint32)(context->numCubes * 2 * sizeof(Uniforms)), &context->drawList)) {
+        return SDL_APP_FAILURE;
+    }
 
-    // That should be enough to create a pipeline! We provide the target info and
-    // rasterizer state defined above, we want to draw triangles, and we want to
-    // do it using the vertex and fragment shaders we loaded.
-    SDL_GPUGraphicsPipelineCreateInfo pipelineCreateInfo = {
-        .target_info = targetInfo,
-        .rasterizer_state = rasterizerState,
-        .vertex_input_state = vertexInputState,
-        .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-        .vertex_shader = vertexShader,
-        .fragment_shader = fragmentShader
-    };
+    // The first frame can't draw anything without all of it, so rather than letting it
+    // trickle out a batch per frame, send it all now and wait, like a load screen would.
+    GBE_FlushUploadQueue(&context->uploadQueue);
+    bool uploaded = !GBE_UploadQueueBusy(&context->uploadQueue);
+    GBE_DestroyUploadQueue(&context->uploadQueue);
+    if (!uploaded) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't upload the cubes' buffers.");
+        return SDL_APP_FAILURE;
+    }
 
-    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(context->context.device, &pipelineCreateInfo);
-    if (pipeline == NULL) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create graphics pipeline: %s", SDL_GetError());
+    return SDL_APP_CONTINUE;
+}
+
+// Our own options, on top of the ones GBE_ApplyCommandLine understands.
+static void ApplyExampleOptions(AppContext* appContext, int argc, char** argv)
+{
+    appContext->numCubes = 1;
+    appContext->transformMode = TRANSFORMS_PUSH;
+    appContext->blendPreset = GBE_PIPELINE_OPAQUE;
+    appContext->filterState = true;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (SDL_strcmp(argv[i], "--validate-cull") == 0) {
+            appContext->validateCulling = true;
+        }
+        else if (SDL_strcmp(argv[i], "--mixed-pipelines") == 0) {
+            appContext->mixedPipelines = true;
+        }
+        else if (SDL_strcmp(argv[i], "--draw-list") == 0) {
+            appContext->useDrawList = true;
+        }
+        else if (SDL_strcmp(argv[i], "--pipelined") == 0) {
+            appContext->pipelined = true;
+        }
+        else if (SDL_strcmp(argv[i], "--static") == 0) {
+            appContext->staticScene = true;
+        }
+        else if (SDL_strcmp(argv[i], "--no-state-filter") == 0) {
+            appContext->filterState = false;
+        }
+        else if (SDL_strcmp(argv[i], "--stacked") == 0) {
+            appContext->stacked = true;
+        }
+        else if (SDL_strcmp(argv[i], "--blend") == 0 && hasValue) {
+            const char* preset = argv[++i];
+            if (SDL_strcmp(preset, "opaque") == 0) {
+                appContext->blendPreset = GBE_PIPELINE_OPAQUE;
+            }
+            else if (SDL_strcmp(preset, "alpha") == 0) {
+                appContext->blendPreset = GBE_PIPELINE_ALPHA_BLEND;
+            }
+            else if (SDL_strcmp(preset, "additive") == 0) {
+                appContext->blendPreset = GBE_PIPELINE_ADDITIVE;
+            }
+            else {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Ignoring --blend %s; expected opaque, alpha or additive.", preset);
+            }
+        }
+        else if (SDL_strcmp(argv[i], "--jobs") == 0 && hasValue) {
+            appContext->jobThreads = SDL_clamp(SDL_atoi(argv[++i]), 0, GBE_MAX_JOB_THREADS);
+            appContext->useJobs = true;
+        }
+        else if (SDL_strcmp(argv[i], "--sim-rate") == 0 && hasValue) {
+            appContext->simulationRate = (Uint32)SDL_strtoul(argv[++i], NULL, 10);
+        }
+        else if (SDL_strcmp(argv[i], "--record-threads") == 0 && hasValue) {
+            appContext->recordThreads = SDL_clamp(SDL_atoi(argv[++i]), 1, GBE_MAX_RECORD_THREADS);
+        }
+        else if (SDL_strcmp(argv[i], "--cubes") == 0 && hasValue) {
+            appContext->numCubes = SDL_max((Uint32)SDL_strtoul(argv[++i], NULL, 10), 1);
+        }
+        else if (SDL_strcmp(argv[i], "--transforms") == 0 && hasValue) {
+            const char* mode = argv[++i];
+            if (SDL_strcmp(mode, "push") == 0) {
+                appContext->transformMode = TRANSFORMS_PUSH;
+            }
+            else if (SDL_strcmp(mode, "storage") == 0) {
+                appContext->transformMode = TRANSFORMS_STORAGE;
+            }
+            else if (SDL_strcmp(mode, "instanced") == 0) {
+                appContext->transformMode = TRANSFORMS_INSTANCED;
+            }
+            else if (SDL_strcmp(mode, "gpu-culled") == 0) {
+                appContext->transformMode = TRANSFORMS_GPU_CULLED;
+            }
+            else {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Ignoring --transforms %s; expected push, storage, instanced or gpu-culled.", mode);
+            }
+        }
+    }
+
+    // A static scene is kept in a draw list from one frame to the next.
+    if (appContext->staticScene) {
+        appContext->useDrawList = true;
     }
+}
 
-    // Now that the pipeline has been created, it's holding on to references to the shaders, so we
-    // don't need to keep them around anymore. (I think they're reference counted, and the pipeline
-    // retained them.)
-    SDL_ReleaseGPUShader(context->context.device, vertexShader);
-    SDL_ReleaseGPUShader(context->context.device, fragmentShader);
+typedef struct TransformWork {
+    const AppContext* appContext;
+    Scene* scene;
+} TransformWork;
 
-    // Store the created pipeline (or the NULL if it failed) in our application context and be done.
-    context->pipeline = pipeline;
-    return pipeline != NULL ? SDL_APP_CONTINUE : SDL_APP_FAILURE;
+// Works out the transforms of cubes `begin` up to `end` from the scene's model and camera
+// matrices. With --jobs, several threads do this at once for different ranges.
+static void ComputeCubeTransforms(void* data, Uint32 begin, Uint32 end)
+{
+    const TransformWork* work = data;
+    Scene* scene = work->scene;
+    for (Uint32 i = begin; i < end; i++) {
+        GBE_Matrix4x4 cubeMatrix = GBE_Matrix4x4Multiply(scene->cubeModelMatrix, GBE_Matrix4x4Translation(work->appContext->cubePositions[i]));
+        scene->cubeTransforms[i] = GBE_Matrix4x4Multiply(cubeMatrix, scene->viewProjectionMatrix);
+    }
 }
 
-static SDL_AppResult BuildVertexBuffer(AppContext* context)
+// Moves everything along by dt seconds: one fixed step, or a whole frame when there's no
+// fixed step.
+static void Simulate(SimulationState* state, double dt)
 {
-    // Creating a vertex buffer is easy: all we really need to tell it is what
-    // we're going to use it for and how much space to allocate.
-    SDL_GPUBufferCreateInfo bufferCreateInfo = {
-        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
-        .size = (Uint32)(sizeof(Vertex) * kNumVertices)
-    };
-    SDL_GPUBuffer *vertexBuffer = SDL_CreateGPUBuffer(context->context.device, &bufferCreateInfo);
-
-    // Getting data _into_ the vertex buffer is way more work. We can't just copy data in, we
-    // have to create a Transfer Buffer, copy memory into that, and then ask the GPU API to
-    // copy the data from the transfer buffer into the vertex buffer.
-    SDL_GPUTransferBufferCreateInfo transferBufferCreateInfo = {
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = (Uint32)(sizeof(Vertex) * kNumVertices)
-    };
-    SDL_GPUTransferBuffer* transferBuffer = SDL_CreateGPUTransferBuffer(context->context.device, &transferBufferCreateInfo);
+    state->elapsedSeconds += dt;
+    state->rotationX += (float)(dt * (M_PI / 2));
+    state->rotationY += (float)(dt * (M_PI / 3));
+}
 
-    Vertex* vertexPtr = SDL_MapGPUTransferBuffer(context->context.device, transferBuffer, false);
-    SDL_memcpy(vertexPtr, kVertices, sizeof(Vertex) * kNumVertices);
-    SDL_UnmapGPUTransferBuffer(context->context.device, transferBuffer);
-    vertexPtr = NULL;
+// Moves the simulation along by however long it's been since the last frame, and returns
+// the state to draw this frame.
+static SimulationState AdvanceSimulation(AppContext* appContext)
+{
+    GBE_FrameClock* clock = &appContext->clock;
+    GBE_TickFrameClock(clock);
 
-    // Copy the data into the buffer
-    SDL_GPUCommandBuffer* cmdBuf = SDL_AcquireGPUCommandBuffer(context->context.device);
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
-    SDL_GPUTransferBufferLocation sourceBuffer = {
-        .transfer_buffer = transferBuffer,
-        .offset = 0
-    };
-    SDL_GPUBufferRegion targetBuffer = {
-        .buffer = vertexBuffer,
-        .offset = 0,
-        .size = (Uint32)(sizeof(Vertex) * kNumVertices)
+    // Keep the cube spinning along, unless the scene's meant to stay put.
+    if (appContext->staticScene) {
+        return appContext->currentState;
+    }
+
+    if (clock->fixedStepNS == 0) {
+        Simulate(&appContext->currentState, GBE_GetSmoothedDeltaSeconds(clock));
+        return appContext->currentState;
+    }
+
+    while (GBE_NextFixedStep(clock)) {
+        appContext->previousState = appContext->currentState;
+        Simulate(&appContext->currentState, GBE_GetFixedStepSeconds(clock));
+    }
+
+    // The state is drawn up to one step behind the newest, blended between the last two.
+    const SimulationState* previous = &appContext->previousState;
+    const SimulationState* current = &appContext->currentState;
+    float alpha = GBE_GetFrameClockAlpha(clock);
+    SimulationState blended = {
+        .elapsedSeconds = previous->elapsedSeconds + (current->elapsedSeconds - previous->elapsedSeconds) * alpha,
+        .rotationX = previous->rotationX + (current->rotationX - previous->rotationX) * alpha,
+        .rotationY = previous->rotationY + (current->rotationY - previous->rotationY) * alpha
     };
+    return blended;
+}
 
-    SDL_UploadToGPUBuffer(copyPass, &sourceBuffer, &targetBuffer, true);
-    SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPUCommandBuffer(cmdBuf);
+// Works out a frame's scene for a target of the given size: moves the simulation along,
+// then builds the camera and the cubes' shared model matrix from where it's got to, and
+// every cube's transform from those (unless the GPU works them out, or nothing's moved).
+static void frameStep(AppContext* appContext, Scene* scene, Uint32 viewportWidth, Uint32 viewportHeight)
+{
+    SimulationState state = AdvanceSimulation(appContext);
 
-    SDL_ReleaseGPUTransferBuffer(context->context.device, transferBuffer);
+    float scaleFactor = sinf(5 * (float)state.elapsedSeconds) * 0.25f + 1;
+    GBE_Vector3 xAxis = { 1, 0, 0 };
+    GBE_Vector3 yAxis = { 0, 1, 0 };
+    GBE_Matrix4x4 xRot = GBE_Matrix4x4RotateAxisAngle(xAxis, state.rotationX);
+    GBE_Matrix4x4 yRot = GBE_Matrix4x4RotateAxisAngle(yAxis, state.rotationY);
+    GBE_Matrix4x4 scale = GBE_Matrix4x4UniformScale(scaleFactor);
+    GBE_Matrix4x4 modelMatrix = GBE_Matrix4x4Multiply(GBE_Matrix4x4Multiply(xRot, yRot), scale);
 
-    context->vertexBuffer = vertexBuffer;
-    return SDL_APP_CONTINUE;
+    // With more than one cube, the camera backs off far enough to fit the whole grid on
+    // screen. GPU culling has nothing to do in that case, so in that mode the camera moves
+    // in closer and pans from side to side, leaving most of the grid out of view.
+    Uint32 gridSize = (Uint32)SDL_ceil(SDL_sqrt((double)appContext->numCubes));
+    float gridExtent = (gridSize - 1) * kCubeSpacing / 2;
+    float fov = (float)(2 * M_PI) / 5;
+    float cameraDistance = 5 + gridExtent / SDL_tanf(fov / 2);
+    float cameraPan = 0;
+    float near = 1;
+    float far = cameraDistance + 100;
+    if (appContext->stacked) {
+        // Close enough that the nearest cube's front face just about fills the screen.
+        cameraDistance = 2.5f;
+        near = 0.1f;
+        far = cameraDistance + appContext->numCubes * kStackSpacing + 10;
+    }
+    else if (appContext->transformMode == TRANSFORMS_GPU_CULLED) {
+        cameraDistance = 5 + gridExtent / SDL_tanf(fov / 2) / 4;
+        cameraPan = sinf((float)state.elapsedSeconds / 3) * gridExtent * 0.75f;
+        far = cameraDistance + 100;
+    }
+
+    GBE_Vector3 cameraTranslation = { -cameraPan, 0, -cameraDistance };
+    GBE_Matrix4x4 viewMatrix = GBE_Matrix4x4Translation(cameraTranslation);
+
+    float aspect = (float)viewportWidth / SDL_max(viewportHeight, 1);
+    GBE_Matrix4x4 projectionMatrix = GBE_Matrix4x4Perspective(aspect, fov, near, far);
+
+    // Every cube's transform comes from these two matrices, so if they're what they were
+    // the last time this scene was worked out, so are the transforms.
+    GBE_Matrix4x4 viewProjectionMatrix = GBE_Matrix4x4Multiply(viewMatrix, projectionMatrix);
+    Uint64 stamp = GBE_HashStamp(0, &modelMatrix, sizeof(GBE_Matrix4x4));
+    stamp = GBE_HashStamp(stamp, &viewProjectionMatrix, sizeof(GBE_Matrix4x4));
+    bool unchanged = appContext->staticScene && stamp == scene->stamp;
+
+    scene->cubeModelMatrix = modelMatrix;
+    scene->viewProjectionMatrix = viewProjectionMatrix;
+    scene->cubeRadius = SDL_sqrtf(3.0f) * scaleFactor;
+    scene->stamp = stamp;
+
+    if (appContext->transformMode != TRANSFORMS_GPU_CULLED && !unchanged) {
+        TransformWork work = { appContext, scene };
+        if (appContext->useJobs) {
+            GBE_ParallelFor(&appContext->jobs, appContext->numCubes, 1024, ComputeCubeTransforms, &work);
+        }
+        else {
+            ComputeCubeTransforms(&work, 0, appContext->numCubes);
+        }
+    }
+
+    scene->simulatedNS = SDL_GetTicksNS();
 }
 
-static SDL_AppResult BuildIndexBuffer(AppContext* context)
+static void ResetClock(AppContext* appContext)
 {
-    // This is pretty much the same thing as BuildVertexBuffer, except we're working with
-    // Uint16 instead of Vertex.
-    SDL_GPUBufferCreateInfo createInfo = {
-        // NOTE: Index buffers use a different usage type than vertex buffers
-        .usage = SDL_GPU_BUFFERUSAGE_INDEX,
-        .size = sizeof(Uint16) * kNumIndices
-    };
-    SDL_GPUBuffer* indexBuffer = SDL_CreateGPUBuffer(context->context.device, &createInfo);
+    Uint64 fixedStepNS = appContext->simulationRate > 0 ? SDL_NS_PER_SECOND / appContext->simulationRate : 0;
+    GBE_ResetFrameClock(&appContext->clock, fixedStepNS);
+}
 
-    // Copying data in works the same way.
-    SDL_GPUTransferBufferCreateInfo transferBufferCreateInfo = {
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = sizeof(Uint16) * kNumIndices
-    };
-    SDL_GPUTransferBuffer* indexTransferBuffer = SDL_CreateGPUTransferBuffer(context->context.device, &transferBufferCreateInfo);
+static Uint32 PackTargetSize(GBE_Context* context)
+{
+    Uint32 width, height;
+    GBE_GetTargetSize(context, &width, &height);
+    return SDL_min(width, 0xffff) << 16 | SDL_min(height, 0xffff);
+}
 
-    // Copy our static indices over into GPU memory.
-    Uint16* indexPtr = SDL_MapGPUTransferBuffer(context->context.device, indexTransferBuffer, false);
-    SDL_memcpy(indexPtr, kIndices, sizeof(Uint16) * kNumIndices);
-    SDL_UnmapGPUTransferBuffer(context->context.device, indexTransferBuffer);
-    indexPtr = NULL;
+// --pipelined's simulation thread. It works out the first scene straight away, so there's
+// one to draw by the time the first frame comes along, then keeps one scene ahead of the
+// render thread: it works out the next one while the render thread draws the last, then
+// waits for the render thread to take it. That wait deliberately throttles the simulation
+// to the render rate, one scene per frame drawn; with a fixed step, each scene still runs
+// every step that's come due since the last (see AdvanceSimulation).
+//
+// Jobs can only be started from the job system's own threads, so with --jobs this thread
+// creates it.
+static int SDLCALL RunSimulation(void* data)
+{
+    AppContext* appContext = data;
+    bool started = true;
+    if (appContext->useJobs) {
+        started = GBE_CreateJobSystem(appContext->jobThreads, &appContext->jobs);
+    }
+    if (!started) {
+        SDL_SetAtomicInt(&appContext->simulationFailed, 1);
+        SDL_SignalSemaphore(appContext->firstScene);
+        GBE_DestroyJobSystem(&appContext->jobs);
+        return 0;
+    }
 
-    SDL_GPUCommandBuffer* cmdBuf = SDL_AcquireGPUCommandBuffer(context->context.device);
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
-    SDL_GPUTransferBufferLocation sourceBuffer = {
-        .transfer_buffer = indexTransferBuffer,
-        .offset = 0
-    };
-    SDL_GPUBufferRegion targetBuffer = {
-        .buffer = indexBuffer,
-        .offset = 0,
-        .size = (Uint32)(sizeof(Uint16) * kNumIndices)
-    };
+    ResetClock(appContext);
+    bool first = true;
+    while (SDL_GetAtomicInt(&appContext->quitSimulation) == 0) {
+        Uint8* slot = GBE_GetTripleBufferWriteSlot(&appContext->sceneBuffer);
+        Scene* scene = (Scene*)slot;
+        scene->cubeTransforms = (GBE_Matrix4x4*)(slot + SCENE_HEADER_SIZE);
+
+        Uint32 targetSize = SDL_GetAtomicU32(&appContext->targetSize);
+        frameStep(appContext, scene, targetSize >> 16, targetSize & 0xffff);
+        GBE_PublishTripleBuffer(&appContext->sceneBuffer);
+
+        if (first) {
+            SDL_SignalSemaphore(appContext->firstScene);
+            first = false;
+        }
+        SDL_WaitSemaphore(appContext->sceneTaken);
+    }
 
-    SDL_UploadToGPUBuffer(copyPass, &sourceBuffer, &targetBuffer, true);
-    SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPUCommandBuffer(cmdBuf);
+    GBE_DestroyJobSystem(&appContext->jobs);
+    return 0;
+}
 
-    SDL_ReleaseGPUTransferBuffer(context->context.device, indexTransferBuffer);
-    context->indexBuffer = indexBuffer;
+static bool StartSimulation(AppContext* appContext)
+{
+    size_t slotSize = SCENE_HEADER_SIZE + sizeof(GBE_Matrix4x4) * appContext->numCubes;
+    if (!GBE_CreateTripleBuffer(slotSize, &appContext->sceneBuffer)) {
+        return false;
+    }
 
-    return SDL_APP_CONTINUE;
+    appContext->sceneTaken = SDL_CreateSemaphore(0);
+    appContext->firstScene = SDL_CreateSemaphore(0);
+    SDL_SetAtomicU32(&appContext->targetSize, PackTargetSize(&appContext->context));
+    if (appContext->sceneTaken != NULL && appContext->firstScene != NULL) {
+        appContext->simulationThread = SDL_CreateThread(RunSimulation, "Simulation", appContext);
+    }
+    if (appContext->simulationThread == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to start the simulation thread: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_WaitSemaphore(appContext->firstScene);
+    return SDL_GetAtomicInt(&appContext->simulationFailed) == 0;
+}
+
+static void StopSimulation(AppContext* appContext)
+{
+    if (appContext->simulationThread != NULL) {
+        SDL_SetAtomicInt(&appContext->quitSimulation, 1);
+        SDL_SignalSemaphore(appContext->sceneTaken);
+        SDL_WaitThread(appContext->simulationThread, NULL);
+        appContext->simulationThread = NULL;
+    }
+    if (appContext->sceneTaken != NULL) {
+        SDL_DestroySemaphore(appContext->sceneTaken);
+    }
+    if (appContext->firstScene != NULL) {
+        SDL_DestroySemaphore(appContext->firstScene);
+    }
+    GBE_DestroyTripleBuffer(&appContext->sceneBuffer);
+}
+
+// Picks up the newest scene the simulation thread has finished, and lets it start on the
+// next one. If it hasn't finished one since last frame, this frame draws the same scene.
+static void TakeScene(AppContext* appContext)
+{
+    SDL_SetAtomicU32(&appContext->targetSize, PackTargetSize(&appContext->context));
+
+    bool fresh;
+    appContext->scene = GBE_ReadTripleBuffer(&appContext->sceneBuffer, &fresh);
+    if (fresh) {
+        SDL_SignalSemaphore(appContext->sceneTaken);
+    }
+    else {
+        appContext->scenesRepeated++;
+    }
 }
 
 SDL_AppResult SDL_AppInit(void** appState, int argc, char** argv)
@@ -279,134 +878,593 @@ SDL_AppResult SDL_AppInit(void** appState, int argc, char** argv)
     SDL_SetAppMetadata("GPU by Example - Uniforms", "0.0.1", "net.jonathanfischer.GpuByExample3");
 
     AppContext* appContext = SDL_calloc(1, sizeof(AppContext));
-    SDL_AppResult rc = GBE_CommonInit(&appContext->context, "GPU by Example - Uniforms");
+    *appState = appContext;
+
+    // Command line options let us run headless, at a fixed size, for a fixed number of
+    // frames, etc.; handy for automated test and benchmark runs.
+    GBE_InitConfig config;
+    GBE_DefaultInitConfig(&config, "GPU by Example - Uniforms");
+    config.depthBuffer = true;
+    GBE_ApplyCommandLine(&config, argc, argv);
+    ApplyExampleOptions(appContext, argc, argv);
+    if (appContext->validateCulling && appContext->transformMode != TRANSFORMS_GPU_CULLED) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "--validate-cull checks GPU culling, so it needs --transforms gpu-culled.");
+        return SDL_APP_FAILURE;
+    }
+
+    SDL_AppResult rc = GBE_CommonInitWithConfig(&appContext->context, &config);
     if (rc != SDL_APP_CONTINUE) {
         return rc;
     }
-    *appState = appContext;
+
+    // With --on-demand, only a static scene ever stops drawing.
+    GBE_SetAnimating(&appContext->context, !appContext->staticScene);
 
     rc = BuildPipeline(appContext);
     if (rc != SDL_APP_CONTINUE) {
         return SDL_APP_FAILURE;
     }
 
-    rc = BuildVertexBuffer(appContext);
+    rc = BuildBuffers(appContext);
     if (rc != SDL_APP_CONTINUE) {
+        return rc;
+    }
+
+    // Only push mode has enough draws to be worth splitting up; the other modes draw
+    // everything with one call.
+    if (appContext->recordThreads > 0 && appContext->transformMode != TRANSFORMS_PUSH) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Ignoring --record-threads; it only applies to pushed uniform transforms.");
+        appContext->recordThreads = 0;
+    }
+    if (appContext->recordThreads > 0 && !GBE_CreateParallelRecorder(&appContext->context, appContext->recordThreads, &appContext->recorder)) {
+        return SDL_APP_FAILURE;
+    }
+
+    if (appContext->pipelined) {
+        return StartSimulation(appContext) ? SDL_APP_CONTINUE : SDL_APP_FAILURE;
+    }
+
+    if (appContext->useJobs && !GBE_CreateJobSystem(appContext->jobThreads, &appContext->jobs)) {
         return SDL_APP_FAILURE;
     }
 
-    rc = BuildIndexBuffer(appContext);
-    appContext->lastFrameTime = SDL_GetTicks();
+    ResetClock(appContext);
 
     return rc;
 }
 
-static void frameStep(AppContext* appContext)
+// Which pipeline a cube is drawn with in push mode.
+static SDL_GPUGraphicsPipeline* GetCubePipeline(const AppContext* context, Uint32 cube)
 {
-    // Calculate how many milliseconds have passed since the last time we did this.
-    Uint64 currentFrameTime = SDL_GetTicks();
-    Uint64 deltaFrameTime = currentFrameTime - appContext->lastFrameTime;
+    return context->secondPipeline != NULL && cube % 2 == 1 ? context->secondPipeline : context->pipeline;
+}
 
-    // If somehow we're running too slowly to maintain a decent frame time (or more likely,
-    // we spent time paused in a debugger), cap the amount of time we consider to have
-    // passed to 1/5 of a second so we don't have any weird jumps.
-    if (deltaFrameTime > 200) {
-        deltaFrameTime = 200;
+// Records a packet for every cube's draw into the draw list, then sorts them: grouped by
+// pipeline first, then nearest first, so the depth test gets to throw away as much as
+// it can. Clip space w is the distance in front of the camera, so that's the depth.
+//
+// A static scene's list is only recorded when something it was built from has changed:
+// the transforms (which the scene stamp covers), or the pipelines and buffers. Otherwise
+// last frame's list, already sorted and baked, gets replayed as is.
+//
+// Returns false if the list couldn't grow to fit every cube. A static list is left
+// invalidated then, so a list missing some cubes is never replayed.
+static bool RecordCubeDrawList(AppContext* context, const SDL_GPUBufferBinding* vertexBinding, const SDL_GPUBufferBinding* indexBinding)
+{
+    if (context->staticScene) {
+        Uint64 stamp = context->scene->stamp;
+        SDL_GPUGraphicsPipeline* pipelines[] = { context->pipeline, context->secondPipeline };
+        SDL_GPUBuffer* buffers[] = { vertexBinding->buffer, indexBinding->buffer };
+        stamp = GBE_HashStamp(stamp, pipelines, sizeof(pipelines));
+        stamp = GBE_HashStamp(stamp, buffers, sizeof(buffers));
+        if (!GBE_BeginStaticDrawList(&context->drawList, stamp)) {
+            return true;
+        }
+    }
+    else {
+        GBE_ResetDrawList(&context->drawList);
     }
 
-    // And keep track of how much time has passed overall; we'll use it below when
-    // calculating how much to scale the cube by.
-    appContext->elapsedTime += deltaFrameTime;
+    context->drawListRecordings++;
+    for (Uint32 i = 0; i < context->numCubes; i++) {
+        SDL_GPUGraphicsPipeline* pipeline = GetCubePipeline(context, i);
+        GBE_DrawPacket packet = {
+            .key = GBE_MakeDrawKey(0, pipeline == context->pipeline ? 0 : 1, 0, context->scene->cubeTransforms[i].m44, false),
+            .pipeline = pipeline,
+            .vertexBuffer = *vertexBinding,
+            .indexBuffer = *indexBinding,
+            .indexElementSize = SDL_GPU_INDEXELEMENTSIZE_16BIT,
+            .count = kNumIndices,
+            .numInstances = 1,
+            .first = context->cubeIndices.firstElement,
+            .vertexOffset = (Sint32)context->cubeVertices.firstElement
+        };
 
-    // Keep the cube spinning along
-    float dt = deltaFrameTime / 1000.0f;
-    appContext->rotationX += (float)(dt * (M_PI / 2));
-    appContext->rotationY += (float)(dt * (M_PI / 3));
+        context->uniforms.modelViewProjectionMatrix = context->scene->cubeTransforms[i];
+        if (!GBE_AddDraw(&context->drawList, &packet, &context->uniforms, sizeof(Uniforms))) {
+            GBE_InvalidateDrawList(&context->drawList);
+            return false;
+        }
+    }
 
-    float scaleFactor = sinf(5 * appContext->elapsedTime / 1000.0f) * 0.25f + 1;
-    GBE_Vector3 xAxis = { 1, 0, 0 };
-    GBE_Vector3 yAxis = { 0, 1, 0 };
-    GBE_Matrix4x4 xRot = GBE_Matrix4x4RotateAxisAngle(xAxis, appContext->rotationX);
-    GBE_Matrix4x4 yRot = GBE_Matrix4x4RotateAxisAngle(yAxis, appContext->rotationY);
-    GBE_Matrix4x4 scale = GBE_Matrix4x4UniformScale(scaleFactor);
-    GBE_Matrix4x4 modelMatrix = GBE_Matrix4x4Multiply(GBE_Matrix4x4Multiply(xRot, yRot), scale);
+    // A list that couldn't be baked still replays, through the render pass's filtering,
+    // and is recorded again next frame.
+    Uint64 sortBegan = SDL_GetTicksNS();
+    if (context->staticScene) {
+        GBE_BakeDrawList(&context->drawList);
+    }
+    else {
+        GBE_SortDrawList(&context->drawList);
+    }
+    context->drawListSortNS += SDL_GetTicksNS() - sortBegan;
+    return true;
+}
 
-    GBE_Vector3 cameraTranslation = { 0, 0, -5 };
-    GBE_Matrix4x4 viewMatrix = GBE_Matrix4x4Translation(cameraTranslation);
+// Records push mode's draws for cubes `first` up to `first + count`. With a draw list
+// that's a slice of the sorted list; otherwise each cube binds everything it's drawn
+// with, like objects with their own materials and meshes would. They mostly share them
+// here, so with filtering on only the binds that change something reach SDL.
+//
+// With --record-threads this runs on several threads at once, each with its own render
+// pass, so it only reads from the context.
+static void RecordCubeRange(void* userData, GBE_RenderPass* renderPass, Uint32 first, Uint32 count)
+{
+    const AppContext* context = userData;
+    if (context->useDrawList) {
+        GBE_ReplayDrawListRange(&context->drawList, renderPass, first, count);
+        return;
+    }
 
-    int viewportWidth, viewportHeight;
-    SDL_GetWindowSize(appContext->context.window, &viewportWidth, &viewportHeight);
-    float aspect = (float)viewportWidth / viewportHeight;
-    float fov = (float)(2 * M_PI) / 5;
-    float near = 1;
-    float far = 100;
-    GBE_Matrix4x4 projectionMatrix = GBE_Matrix4x4Perspective(aspect, fov, near, far);
+    SDL_GPUBufferBinding vertexBufferBinding = {
+        .buffer = context->meshArena.buffer,
+        .offset = 0
+    };
+    SDL_GPUBufferBinding indexBinding = {
+        .buffer = context->meshArena.buffer,
+        .offset = 0
+    };
 
-    appContext->uniforms.modelViewProjectionMatrix = GBE_Matrix4x4Multiply(GBE_Matrix4x4Multiply(modelMatrix, viewMatrix), projectionMatrix);
+    for (Uint32 i = first; i < first + count; i++) {
+        GBE_BindPipeline(renderPass, GetCubePipeline(context, i));
+        GBE_BindVertexBuffers(renderPass, 0, &vertexBufferBinding, 1);
+        GBE_BindIndexBuffer(renderPass, &indexBinding, SDL_GPU_INDEXELEMENTSIZE_16BIT);
 
-    appContext->lastFrameTime = currentFrameTime;
+        Uniforms uniforms = { .modelViewProjectionMatrix = context->scene->cubeTransforms[i] };
+        GBE_PushVertexUniforms(renderPass, 0, &uniforms, sizeof(Uniforms));
+        GBE_DrawIndexedPrimitives(renderPass, kNumIndices, 1, context->cubeIndices.firstElement, (Sint32)context->cubeVertices.firstElement, 0);
+    }
+}
+
+// Records the frame's cubes on --record-threads threads, each into its own command
+// buffer, and has the recorder copy the result into the frame's target.
+static bool RecordFrameInParallel(AppContext* context, GBE_Frame* frame)
+{
+    if (context->useDrawList) {
+        SDL_GPUBufferBinding vertexBufferBinding = { .buffer = context->meshArena.buffer, .offset = 0 };
+        SDL_GPUBufferBinding indexBinding = { .buffer = context->meshArena.buffer, .offset = 0 };
+        if (!RecordCubeDrawList(context, &vertexBufferBinding, &indexBinding)) {
+            return false;
+        }
+    }
+
+    SDL_FColor clearColor = { 0.12f, 0.12f, 0.12f, 1.0f };
+    bool recorded = GBE_RecordInParallel(&context->recorder, frame, clearColor, context->filterState, context->numCubes, RecordCubeRange, context);
+
+    context->stateCallsIssued += context->recorder.issued;
+    context->stateCallsSkipped += context->recorder.skipped;
+    context->slowestThreadNS += context->recorder.slowestChunkNS;
+    return recorded;
+}
+
+// Records the compute pass that works out which cubes are visible: reset the indirect
+// draw's instance count to 0, then test every cube on the GPU, appending the survivors'
+// transforms to transformBuffer and their indices to visibleCubesBuffer, and counting
+// them in drawArgumentsBuffer. Returns false if the arguments couldn't be staged, in
+// which case nothing's been recorded.
+static bool RecordCulling(AppContext* context, SDL_GPUCommandBuffer* cmdBuf)
+{
+    SDL_GPUIndexedIndirectDrawCommand resetArguments = {
+        .num_indices = kNumIndices,
+        .num_instances = 0,
+        .first_index = context->cubeIndices.firstElement,
+        .vertex_offset = (Sint32)context->cubeVertices.firstElement,
+        .first_instance = 0
+    };
+    if (!GBE_StagingRingUpload(&context->stagingRing, &resetArguments, sizeof(resetArguments), context->drawArgumentsBuffer, 0, true)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't stage the culling pass's draw arguments.");
+        return false;
+    }
+
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
+    GBE_StagingRingFlush(&context->stagingRing, copyPass);
+    SDL_EndGPUCopyPass(copyPass);
+
+    // The transforms and cube indices are all rewritten, so they can be cycled; the draw
+    // arguments were just reset, so they can't.
+    SDL_GPUStorageBufferReadWriteBinding outputs[] = {{
+        .buffer = context->transformBuffer,
+        .cycle = true
+    }, {
+        .buffer = context->drawArgumentsBuffer,
+        .cycle = false
+    }, {
+        .buffer = context->visibleCubesBuffer,
+        .cycle = true
+    }};
+
+    CullUniforms uniforms = {
+        .modelMatrix = context->scene->cubeModelMatrix,
+        .viewProjectionMatrix = context->scene->viewProjectionMatrix,
+        .objectCount = context->numCubes,
+        .objectRadius = context->scene->cubeRadius
+    };
+    GBE_Frustum frustum = GBE_FrustumFromMatrix(context->scene->viewProjectionMatrix);
+    SDL_memcpy(uniforms.frustumPlanes, frustum.planes, sizeof(frustum.planes));
+
+    SDL_GPUComputePass* computePass = SDL_BeginGPUComputePass(cmdBuf, NULL, 0, outputs, SDL_arraysize(outputs));
+    SDL_BindGPUComputePipeline(computePass, context->cullPipeline);
+    SDL_BindGPUComputeStorageBuffers(computePass, 0, &context->objectBuffer, 1);
+    SDL_PushGPUComputeUniformData(cmdBuf, 0, &uniforms, sizeof(uniforms));
+    SDL_DispatchGPUCompute(computePass, (context->numCubes + CULL_THREAD_COUNT - 1) / CULL_THREAD_COUNT, 1, 1);
+    SDL_EndGPUComputePass(computePass);
+}
+
+// Runs the culling pass on its own, reads back what it produced, and checks it against
+// the same test done on the CPU: exactly the same cubes have to survive (in whatever
+// order the GPU got to them), each with the transform the CPU works out for it.
+static bool ValidateCulling(AppContext* context)
+{
+    SDL_GPUDevice* device = context->context.device;
+    Uint32 transformsSize = (Uint32)(sizeof(GBE_Matrix4x4) * context->numCubes);
+    Uint32 indicesSize = (Uint32)(sizeof(Uint32) * context->numCubes);
+    Uint32 readbackSize = (Uint32)sizeof(SDL_GPUIndexedIndirectDrawCommand) + transformsSize + indicesSize;
+
+    SDL_GPUTransferBufferCreateInfo readbackInfo = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+        .size = readbackSize
+    };
+    SDL_GPUTransferBuffer* readback = SDL_CreateGPUTransferBuffer(device, &readbackInfo);
+    if (readback == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create readback buffer: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_GPUCommandBuffer* cmdBuf = SDL_AcquireGPUCommandBuffer(device);
+    if (cmdBuf == NULL) {
+        SDL_ReleaseGPUTransferBuffer(device, readback);
+        return false;
+    }
+    if (!RecordCulling(context, cmdBuf)) {
+        SDL_CancelGPUCommandBuffer(cmdBuf);
+        SDL_ReleaseGPUTransferBuffer(device, readback);
+        return false;
+    }
+
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
+    SDL_GPUBufferRegion argumentsRegion = {
+        .buffer = context->drawArgumentsBuffer,
+        .offset = 0,
+        .size = sizeof(SDL_GPUIndexedIndirectDrawCommand)
+    };
+    SDL_GPUTransferBufferLocation argumentsDestination = {
+        .transfer_buffer = readback,
+        .offset = 0
+    };
+    SDL_DownloadFromGPUBuffer(copyPass, &argumentsRegion, &argumentsDestination);
+
+    SDL_GPUBufferRegion transformsRegion = {
+        .buffer = context->transformBuffer,
+        .offset = 0,
+        .size = transformsSize
+    };
+    SDL_GPUTransferBufferLocation transformsDestination = {
+        .transfer_buffer = readback,
+        .offset = sizeof(SDL_GPUIndexedIndirectDrawCommand)
+    };
+    SDL_DownloadFromGPUBuffer(copyPass, &transformsRegion, &transformsDestination);
+
+    SDL_GPUBufferRegion indicesRegion = {
+        .buffer = context->visibleCubesBuffer,
+        .offset = 0,
+        .size = indicesSize
+    };
+    SDL_GPUTransferBufferLocation indicesDestination = {
+        .transfer_buffer = readback,
+        .offset = sizeof(SDL_GPUIndexedIndirectDrawCommand) + transformsSize
+    };
+    SDL_DownloadFromGPUBuffer(copyPass, &indicesRegion, &indicesDestination);
+    SDL_EndGPUCopyPass(copyPass);
+
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmdBuf);
+    if (fence == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_SubmitGPUCommandBufferAndAcquireFence failed: %s", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(device, readback);
+        return false;
+    }
+    SDL_WaitForGPUFences(device, true, &fence, 1);
+    SDL_ReleaseGPUFence(device, fence);
+
+    // What the CPU thinks should have survived. Each survivor gets crossed off as the
+    // GPU's list turns it up, so any cube it lists twice shows up too.
+    Uint8* expected = SDL_calloc(context->numCubes, 1);
+    if (expected == NULL) {
+        SDL_ReleaseGPUTransferBuffer(device, readback);
+        return false;
+    }
+
+    GBE_Frustum frustum = GBE_FrustumFromMatrix(context->scene->viewProjectionMatrix);
+    Uint32 expectedCount = 0;
+    for (Uint32 i = 0; i < context->numCubes; i++) {
+        if (GBE_FrustumIntersectsSphere(frustum, context->cubePositions[i], context->scene->cubeRadius)) {
+            expected[i] = 1;
+            expectedCount++;
+        }
+    }
+
+    const Uint8* mapped = SDL_MapGPUTransferBuffer(device, readback, false);
+    if (mapped == NULL) {
+        SDL_free(expected);
+        SDL_ReleaseGPUTransferBuffer(device, readback);
+        return false;
+    }
+
+    SDL_GPUIndexedIndirectDrawCommand arguments;
+    SDL_memcpy(&arguments, mapped, sizeof(arguments));
+    const GBE_Matrix4x4* transforms = (const GBE_Matrix4x4*)(mapped + sizeof(arguments));
+    const Uint32* indices = (const Uint32*)(mapped + sizeof(arguments) + transformsSize);
+
+    bool matches = arguments.num_instances == expectedCount;
+    Uint32 checked = SDL_min(arguments.num_instances, context->numCubes);
+    for (Uint32 slot = 0; slot < checked && matches; slot++) {
+        Uint32 cube = indices[slot];
+        if (cube >= context->numCubes || !expected[cube]) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Culling check failed: the GPU kept cube %u, which the CPU culled (or listed it twice).", cube);
+            matches = false;
+            break;
+        }
+        expected[cube] = 0;
+
+        // The GPU's floating point doesn't have to match ours bit for bit, so allow a
+        // little slack.
+        GBE_Matrix4x4 cubeMatrix = GBE_Matrix4x4Multiply(context->scene->cubeModelMatrix, GBE_Matrix4x4Translation(context->cubePositions[cube]));
+        GBE_Matrix4x4 transform = GBE_Matrix4x4Multiply(cubeMatrix, context->scene->viewProjectionMatrix);
+        const float* want = &transform.m11;
+        const float* got = &transforms[slot].m11;
+        for (int i = 0; i < 16; i++) {
+            if (SDL_fabsf(want[i] - got[i]) > 1e-3f * (1.0f + SDL_fabsf(want[i]))) {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Culling check failed: cube %u's transform is off by %f in element %d.",
+                    cube, got[i] - want[i], i);
+                matches = false;
+                break;
+            }
+        }
+    }
+    SDL_UnmapGPUTransferBuffer(device, readback);
+    SDL_ReleaseGPUTransferBuffer(device, readback);
+    SDL_free(expected);
+
+    if (matches) {
+        SDL_Log("Culling check passed: %u of %u cubes visible.", expectedCount, context->numCubes);
+    }
+    else if (arguments.num_instances != expectedCount) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Culling check failed: the GPU kept %u cubes, the CPU %u.",
+            arguments.num_instances, expectedCount);
+    }
+    return matches;
 }
 
 SDL_AppResult SDL_AppIterate(void* appState)
 {
     AppContext* context = (AppContext*)appState;
-    frameStep(context);
+    if (!GBE_ShouldRender(&context->context)) {
+        return SDL_APP_CONTINUE;
+    }
 
-    SDL_GPUCommandBuffer* cmdBuf;
-    cmdBuf = SDL_AcquireGPUCommandBuffer(context->context.device);
-    if (cmdBuf == NULL) {
-        SDL_Log("SDL_AcquireGPUCommandBuffer failed: %s", SDL_GetError());
-        return SDL_APP_FAILURE;
+    if (context->pipelined) {
+        TakeScene(context);
+    }
+    else {
+        Uint32 width, height;
+        GBE_GetTargetSize(&context->context, &width, &height);
+        frameStep(context, &context->ownScene, width, height);
     }
 
-    SDL_GPUTexture* swapchainTexture;
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdBuf, context->context.window, &swapchainTexture, NULL, NULL)) {
-        SDL_Log("SDL_WaitAndAcquireGPUSwapchainTexture: %s", SDL_GetError());
+    // Checking every frame would be slow, but once a second or so catches anything that
+    // depends on where the camera is.
+    bool validateNow = context->validateCulling && context->context.frameNumber % 60 == 0;
+    if (context->transformMode == TRANSFORMS_GPU_CULLED && validateNow && !ValidateCulling(context)) {
         return SDL_APP_FAILURE;
     }
 
-    if (swapchainTexture != NULL) {
+    GBE_Frame frame;
+    SDL_AppResult rc = GBE_BeginFrame(&context->context, &frame);
+    if (rc != SDL_APP_CONTINUE) {
+        return rc;
+    }
+
+    Uint64 recordingBegan = SDL_GetTicksNS();
+    if (context->firstFrameNS == 0) {
+        context->firstFrameNS = recordingBegan;
+    }
+
+    SDL_GPUCommandBuffer* cmdBuf = frame.commandBuffer;
+    if (frame.target != NULL && context->recordThreads > 0) {
+        if (!RecordFrameInParallel(context, &frame)) {
+            GBE_CancelFrame(&context->context, &frame);
+            return SDL_APP_FAILURE;
+        }
+    }
+    else if (frame.target != NULL) {
+        // Every cube's transform goes up in a single copy, before the render pass starts.
+        // A frame whose data can't all be staged would draw last frame's, so it fails.
+        bool staged = true;
+        if (context->transformMode == TRANSFORMS_STORAGE) {
+            staged = GBE_StagingRingUpload(&context->stagingRing, context->scene->cubeTransforms,
+                (Uint32)(sizeof(GBE_Matrix4x4) * context->numCubes), context->transformBuffer, 0, true);
+
+            SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
+            GBE_StagingRingFlush(&context->stagingRing, copyPass);
+            SDL_EndGPUCopyPass(copyPass);
+        }
+        else if (context->transformMode == TRANSFORMS_INSTANCED) {
+            // Build the instance data right in staging memory rather than copying it there.
+            Uint32 instancesSize = (Uint32)(sizeof(CubeInstance) * context->numCubes);
+            Uint32 stagingOffset;
+            CubeInstance* instances = GBE_StagingRingAlloc(&context->stagingRing, instancesSize, 16, &stagingOffset);
+            staged = instances != NULL;
+            if (staged) {
+                for (Uint32 i = 0; i < context->numCubes; i++) {
+                    instances[i].modelViewProjectionMatrix = context->scene->cubeTransforms[i];
+                    instances[i].color = context->cubeColors[i];
+                }
+                staged = GBE_StagingRingCopy(&context->stagingRing, stagingOffset, context->instanceBuffer, 0, instancesSize, true);
+            }
+
+            SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
+            GBE_StagingRingFlush(&context->stagingRing, copyPass);
+            SDL_EndGPUCopyPass(copyPass);
+        }
+        else if (context->transformMode == TRANSFORMS_GPU_CULLED) {
+            staged = RecordCulling(context, cmdBuf);
+        }
+
+        if (!staged) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't stage this frame's %u cubes (%llu staging ring overflows so far).",
+                context->numCubes, (unsigned long long)context->stagingRing.overflows);
+            GBE_CancelFrame(&context->context, &frame);
+            return SDL_APP_FAILURE;
+        }
 
         SDL_GPUColorTargetInfo targetInfo = {
-            .texture = swapchainTexture,
+            .texture = frame.target,
             .cycle = true,
             .load_op = SDL_GPU_LOADOP_CLEAR,
             .store_op = SDL_GPU_STOREOP_STORE,
             .clear_color = {0.12f, 0.12f, 0.12f, 1.0f}};
 
-        SDL_GPURenderPass* renderPass;
-        renderPass = SDL_BeginGPURenderPass(cmdBuf, &targetInfo, 1, NULL);
-        SDL_BindGPUGraphicsPipeline(renderPass, context->pipeline);
-        SDL_PushGPUVertexUniformData(cmdBuf, 0, &(context->uniforms), sizeof(Uniforms));
+        // The depth buffer only matters while the pass is running, so there's no need to
+        // store it afterwards.
+        SDL_GPUDepthStencilTargetInfo depthInfo = {
+            .texture = frame.depthTarget,
+            .clear_depth = 1.0f,
+            .load_op = SDL_GPU_LOADOP_CLEAR,
+            .store_op = SDL_GPU_STOREOP_DONT_CARE,
+            .stencil_load_op = SDL_GPU_LOADOP_DONT_CARE,
+            .stencil_store_op = SDL_GPU_STOREOP_DONT_CARE,
+            .cycle = true
+        };
 
         // The API takes an array of vertex buffer pointers, not a single one.
         SDL_GPUBufferBinding vertexBufferBinding = {
-            .buffer = context->vertexBuffer,
+            .buffer = context->meshArena.buffer,
             .offset = 0
         };
-        SDL_BindGPUVertexBuffers(renderPass, 0, &vertexBufferBinding, 1);
-
         SDL_GPUBufferBinding indexBinding = {
-            .buffer = context->indexBuffer,
+            .buffer = context->meshArena.buffer,
             .offset = 0
         };
-        SDL_BindGPUIndexBuffer(renderPass, &indexBinding, SDL_GPU_INDEXELEMENTSIZE_16BIT);
-        SDL_DrawGPUIndexedPrimitives(renderPass, kNumIndices, 1, 0, 0, 0);
-        SDL_EndGPURenderPass(renderPass);
+
+        // The draw list is put together before the pass starts, so there's nothing to end
+        // if it can't be.
+        bool drawListMode = context->transformMode == TRANSFORMS_PUSH && context->useDrawList;
+        if (drawListMode && !RecordCubeDrawList(context, &vertexBufferBinding, &indexBinding)) {
+            GBE_CancelFrame(&context->context, &frame);
+            return SDL_APP_FAILURE;
+        }
+
+        // The render pass goes through GBE_RenderPass, which keeps track of what's bound
+        // and skips binds and uniform pushes that wouldn't change anything.
+        GBE_RenderPass renderPass;
+        if (!GBE_BeginRenderPass(&renderPass, cmdBuf, &targetInfo, 1, frame.depthTarget != NULL ? &depthInfo : NULL)) {
+            GBE_CancelFrame(&context->context, &frame);
+            return SDL_APP_FAILURE;
+        }
+        renderPass.filter = context->filterState;
+
+        if (drawListMode) {
+            Uint64 replayBegan = SDL_GetTicksNS();
+            GBE_ReplayDrawList(&context->drawList, &renderPass);
+            context->drawListReplayNS += SDL_GetTicksNS() - replayBegan;
+        }
+        else if (context->transformMode == TRANSFORMS_PUSH) {
+            RecordCubeRange(context, &renderPass, 0, context->numCubes);
+        }
+        else {
+            GBE_BindPipeline(&renderPass, context->pipeline);
+            GBE_BindVertexBuffers(&renderPass, 0, &vertexBufferBinding, 1);
+            GBE_BindIndexBuffer(&renderPass, &indexBinding, SDL_GPU_INDEXELEMENTSIZE_16BIT);
+        }
+
+        if (context->transformMode == TRANSFORMS_STORAGE) {
+            // One draw for everything. Note that the first instance has to stay 0: the
+            // shader's instance ID doesn't include it on every backend.
+            GBE_BindVertexStorageBuffers(&renderPass, 0, &context->transformBuffer, 1);
+            GBE_DrawIndexedPrimitives(&renderPass, kNumIndices, context->numCubes, context->cubeIndices.firstElement, (Sint32)context->cubeVertices.firstElement, 0);
+        }
+        else if (context->transformMode == TRANSFORMS_INSTANCED) {
+            SDL_GPUBufferBinding instanceBinding = {
+                .buffer = context->instanceBuffer,
+                .offset = 0
+            };
+            GBE_BindVertexBuffers(&renderPass, 1, &instanceBinding, 1);
+            GBE_DrawIndexedPrimitives(&renderPass, kNumIndices, context->numCubes, context->cubeIndices.firstElement, (Sint32)context->cubeVertices.firstElement, 0);
+        }
+        else if (context->transformMode == TRANSFORMS_GPU_CULLED) {
+            // However many cubes survived, the draw's arguments are already on the GPU.
+            GBE_BindVertexStorageBuffers(&renderPass, 0, &context->transformBuffer, 1);
+            GBE_DrawIndexedPrimitivesIndirect(&renderPass, context->drawArgumentsBuffer, 0, 1);
+        }
+        GBE_EndRenderPass(&renderPass);
+
+        context->stateCallsIssued += renderPass.issued;
+        context->stateCallsSkipped += renderPass.skipped;
     }
 
-    SDL_SubmitGPUCommandBuffer(cmdBuf);
+    Uint64 recordingEnded = SDL_GetTicksNS();
+    context->recordingNS += recordingEnded - recordingBegan;
+    context->sceneAgeNS += recordingEnded - context->scene->simulatedNS;
+    context->framesRecorded++;
 
     // That's it for this frame.
-    return SDL_APP_CONTINUE;
+    return GBE_EndFrame(&context->context, &frame);
 }
 
 SDL_AppResult SDL_AppEvent(void* appState, SDL_Event* event)
 {
+    AppContext* context = (AppContext*)appState;
+    GBE_HandleEvent(&context->context, event);
+
     if (event->type == SDL_EVENT_QUIT) {
         return SDL_APP_SUCCESS;
     }
 
+    // A few keys for poking at swapchain settings while the cube spins, to see how
+    // they trade latency against frame rate (S turns on the numbers):
+    //   P cycles through present modes (vsync, immediate, mailbox)
+    //   F cycles through 1, 2 and 3 frames in flight
+    if (event->type == SDL_EVENT_KEY_DOWN && !event->key.repeat) {
+        GBE_TargetState* target = &context->context.target;
+        switch (event->key.key) {
+        case SDLK_P:
+            GBE_SetPresentMode(&context->context, (SDL_GPUPresentMode)((target->presentMode + 1) % 3));
+            SDL_Log("Present mode: %s", GBE_GetPresentModeName(target->presentMode));
+            break;
+
+        case SDLK_F:
+            GBE_SetFramesInFlight(&context->context, target->framesInFlight % 3 + 1);
+            SDL_Log("Frames in flight: %u", target->framesInFlight);
+            break;
+
+        case SDLK_S:
+            context->context.stats.enabled = !context->context.stats.enabled;
+            context->context.stats.intervalStartNS = 0;
+            break;
+
+        default:
+            break;
+        }
+    }
+
     // Nothing else to do, so just continue on with the next frame or event.
     return SDL_APP_CONTINUE;
 }
@@ -415,13 +1473,77 @@ void SDL_AppQuit(void* appState, SDL_AppResult result)
 {
     AppContext* context = (AppContext*)appState;
 
-    if (context->pipeline != NULL) {
-        SDL_ReleaseGPUGraphicsPipeline(context->context.device, context->pipeline);
+    // The simulation thread's done with the clock once it's stopped.
+    StopSimulation(context);
+
+    // One line that sums up the run, so scripts (see Tools/benchmark-cubes.sh and
+    // benchmark-fill.sh) can compare cube counts, transform modes and blending.
+    if (context->framesRecorded > 1) {
+        double frameMS = (double)(SDL_GetTicksNS() - context->firstFrameNS) / SDL_NS_PER_MS / context->framesRecorded;
+        double recordingMS = (double)context->recordingNS / SDL_NS_PER_MS / context->framesRecorded;
+        char drawListTiming[160] = "";
+        if (context->drawList.packets != NULL) {
+            SDL_snprintf(drawListTiming, sizeof(drawListTiming), ", draw list sort %.3f ms and replay %.3f ms per frame, recorded %llu times",
+                (double)context->drawListSortNS / SDL_NS_PER_MS / context->framesRecorded,
+                (double)context->drawListReplayNS / SDL_NS_PER_MS / context->framesRecorded,
+                (unsigned long long)context->drawListRecordings);
+        }
+
+        char threadTiming[192] = "";
+        if (context->recordThreads > 0) {
+            SDL_snprintf(threadTiming, sizeof(threadTiming), ", %d recording threads (slowest %.3f ms per frame)",
+                context->recordThreads, (double)context->slowestThreadNS / SDL_NS_PER_MS / context->framesRecorded);
+        }
+        if (context->pipelined) {
+            size_t length = SDL_strlen(threadTiming);
+            SDL_snprintf(threadTiming + length, sizeof(threadTiming) - length, ", pipelined with %llu frames repeating a scene",
+                (unsigned long long)context->scenesRepeated);
+        }
+        if (context->useJobs) {
+            size_t length = SDL_strlen(threadTiming);
+            SDL_snprintf(threadTiming + length, sizeof(threadTiming) - length, ", transforms on %d job threads", context->jobs.numThreads);
+        }
+
+        // How steady the last few frames were, as frameStep saw them.
+        GBE_FrameTimeSummary frameTimes;
+        GBE_SummarizeFrameTimes(&context->clock, &frameTimes);
+        char clockTiming[160];
+        SDL_snprintf(clockTiming, sizeof(clockTiming), ", last %u frames %.3f-%.3f ms (jitter %.3f ms)",
+            frameTimes.samples, frameTimes.minMS, frameTimes.maxMS, frameTimes.jitterMS);
+        if (context->clock.fixedStepNS > 0) {
+            size_t length = SDL_strlen(clockTiming);
+            SDL_snprintf(clockTiming + length, sizeof(clockTiming) - length, ", simulated at %u Hz (%llu steps, %llu dropped)",
+                context->simulationRate, (unsigned long long)context->clock.stepsTaken, (unsigned long long)context->clock.stepsDropped);
+        }
+
+        SDL_Log("Summary: %u %s%s %s cubes, %s transforms: %.3f ms/frame, %.3f ms CPU recording per frame over %llu frames, "
+                "scene %.3f ms old when submitted, %.0f state calls issued and %.0f skipped per frame%s%s%s",
+            context->numCubes, context->staticScene ? "static " : "", context->stacked ? "stacked" : "grid", GetBlendPresetName(context->blendPreset),
+            GetTransformModeName(context->transformMode), frameMS, recordingMS, (unsigned long long)context->framesRecorded,
+            (double)context->sceneAgeNS / SDL_NS_PER_MS / context->framesRecorded,
+            (double)context->stateCallsIssued / context->framesRecorded, (double)context->stateCallsSkipped / context->framesRecorded,
+            drawListTiming, threadTiming, clockTiming);
     }
 
-    if (context->vertexBuffer != NULL) {
-        SDL_ReleaseGPUBuffer(context->context.device, context->vertexBuffer);
-    }
+    // These get released once the GPU is finished with them: right away while the app is
+    // running, or by GBE_Quit once the GPU's gone idle. NULLs are skipped.
+    GBE_ReleaseCachedPipeline(&context->context, context->pipeline);
+    GBE_ReleaseCachedPipeline(&context->context, context->secondPipeline);
+    GBE_DeferRelease(&context->context, GBE_RESOURCE_BUFFER, context->transformBuffer);
+    GBE_DeferRelease(&context->context, GBE_RESOURCE_BUFFER, context->instanceBuffer);
+    GBE_DeferRelease(&context->context, GBE_RESOURCE_BUFFER, context->objectBuffer);
+    GBE_DeferRelease(&context->context, GBE_RESOURCE_BUFFER, context->drawArgumentsBuffer);
+    GBE_DeferRelease(&context->context, GBE_RESOURCE_BUFFER, context->visibleCubesBuffer);
+    GBE_DeferRelease(&context->context, GBE_RESOURCE_COMPUTE_PIPELINE, context->cullPipeline);
+    GBE_DestroyStagingRing(&context->stagingRing);
+    GBE_DestroyUploadQueue(&context->uploadQueue);
+    GBE_DestroyBufferArena(&context->meshArena);
+    GBE_DestroyDrawList(&context->drawList);
+    GBE_DestroyParallelRecorder(&context->recorder);
+    GBE_DestroyJobSystem(&context->jobs);
+    SDL_free(context->cubePositions);
+    SDL_free(context->ownScene.cubeTransforms);
+    SDL_free(context->cubeColors);
 
     GBE_Quit(&context->context);
     SDL_free(context);
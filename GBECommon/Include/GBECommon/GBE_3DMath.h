@@ -9,6 +9,8 @@
 #ifndef GpuByExample_Math_h
 #define GpuByExample_Math_h
 
+#include <stdbool.h>
+
 typedef struct GBE_Vector3 {
     float x, y, z;
 } GBE_Vector3;
@@ -24,6 +26,12 @@ typedef struct GBE_Matrix4x4 {
     float m41, m42, m43, m44;
 } GBE_Matrix4x4;
 
+// The six planes (left, right, bottom, top, near, far) bounding what a camera can see,
+// each as (normal.x, normal.y, normal.z, distance) with the normal pointing inward.
+typedef struct GBE_Frustum {
+    GBE_Vector4 planes[6];
+} GBE_Frustum;
+
 extern const GBE_Vector3   kZeroVector3;
 extern const GBE_Matrix4x4 kIdentityMatrix;
 
@@ -47,5 +55,10 @@ GBE_Matrix4x4 GBE_Matrix4x4UniformScale(float scalar);
 GBE_Matrix4x4 GBE_Matrix4x4RotateAxisAngle(GBE_Vector3 axis, float angleInRadians);
 GBE_Matrix4x4 GBE_Matrix4x4Perspective(float aspect, float fovy, float near, float far);
 
+// Pulls the frustum's planes out of a view-projection matrix. The planes are in whatever
+// space the matrix transforms from (world space, for view * projection).
+GBE_Frustum GBE_FrustumFromMatrix(GBE_Matrix4x4 viewProjection);
+bool        GBE_FrustumIntersectsSphere(GBE_Frustum frustum, GBE_Vector3 center, float radius);
+
 #endif /* GpuByExample_Math_h */
 
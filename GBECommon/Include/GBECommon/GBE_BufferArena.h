@@ -0,0 +1,76 @@
+//
+//  GBE_BufferArena.h
+//  GBECommon
+//
+//  One big GPU buffer that lots of meshes share. Rather than creating a vertex
+//  and index buffer per mesh (and binding them before every draw), meshes get
+//  ranges of a shared buffer, and draws pick out their part of it with
+//  first_index / vertex_offset. Consecutive draws from the same arena don't
+//  need to rebind anything.
+//
+//  Ranges are handed out by a buddy allocator: the buffer is split into
+//  power-of-two sized blocks, halved as needed to fit each request, and freed
+//  blocks merge back with their neighbors ("buddies") when both are free.
+
+#ifndef GBE_BufferArena_h
+#define GBE_BufferArena_h
+
+#include "GBE_Context.h"
+
+// The smallest block the arena hands out, and the most times a buffer can be halved.
+#define GBE_ARENA_MIN_BLOCK_SIZE 256
+#define GBE_ARENA_MAX_ORDERS     24
+
+typedef struct GBE_BufferRange {
+    // Where the data starts in the arena's buffer, and how much of it there is.
+    Uint32 offset;
+    Uint32 size;
+
+    // The element size the range was allocated with, and offset / stride: pass this as
+    // first_index (for indices) or vertex_offset (for vertices) when drawing.
+    Uint32 stride;
+    Uint32 firstElement;
+
+    // The buddy block backing this range. Internal to the arena.
+    Uint32 block;
+} GBE_BufferRange;
+
+typedef struct GBE_BufferArena {
+    SDL_GPUDevice* device;
+    SDL_GPUBuffer* buffer;
+    SDL_GPUBufferUsageFlags usage;
+    Uint32 capacity;
+    int maxOrder;
+
+    // Book-keeping per GBE_ARENA_MIN_BLOCK_SIZE chunk of the buffer. Only entries at
+    // the start of a block mean anything.
+    Uint8* blockOrder;
+    Uint8* blockState;
+    Sint32* nextFree;
+    Sint32* prevFree;
+    Sint32 freeLists[GBE_ARENA_MAX_ORDERS];
+
+    Uint32 bytesInUse;
+    Uint32 numAllocations;
+} GBE_BufferArena;
+
+// Capacity gets rounded up to a power of two multiple of GBE_ARENA_MIN_BLOCK_SIZE.
+bool GBE_CreateBufferArena(GBE_Context* context, SDL_GPUBufferUsageFlags usage, Uint32 capacity, GBE_BufferArena* arena);
+
+// Sets up just the block book-keeping, with no buffer behind it, so ranges can be handed
+// out without a GPU (the tests do this). GBE_CreateBufferArena starts with this. Destroy
+// it with GBE_DestroyBufferArena all the same; it can't be defragmented.
+bool GBE_CreateBufferArenaBlocks(Uint32 capacity, GBE_BufferArena* arena);
+void GBE_DestroyBufferArena(GBE_BufferArena* arena);
+
+// Finds room for `count` elements of `stride` bytes each. The range's offset is always
+// a multiple of stride, so its firstElement can be used directly in draw calls.
+bool GBE_BufferArenaAlloc(GBE_BufferArena* arena, Uint32 count, Uint32 stride, GBE_BufferRange* range);
+void GBE_BufferArenaFree(GBE_BufferArena* arena, GBE_BufferRange* range);
+
+// Packs every live range tightly into a brand new buffer, copying their contents over on
+// the GPU with `copyPass`. `ranges` must list every range still allocated from the arena;
+// they're updated in place. The arena's buffer changes, so rebind it afterward.
+bool GBE_DefragmentBufferArena(GBE_BufferArena* arena, SDL_GPUCopyPass* copyPass, GBE_BufferRange** ranges, int count);
+
+#endif /* GBE_BufferArena_h */
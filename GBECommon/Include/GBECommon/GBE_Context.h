@@ -11,10 +11,194 @@
 
 #include <SDL3/SDL.h>
 
+// What the GPU device can do. None of this changes after startup, so it's looked up
+// once instead of asking the driver every time.
+typedef struct GBE_DeviceCaps {
+    const char* driver;
+    SDL_GPUShaderFormat shaderFormats;
+
+    // The best supported formats for depth-only and depth-stencil render targets, or
+    // SDL_GPU_TEXTUREFORMAT_INVALID if there isn't one.
+    SDL_GPUTextureFormat depthFormat;
+    SDL_GPUTextureFormat depthStencilFormat;
+} GBE_DeviceCaps;
+
+// What frames are being rendered into: the window's swapchain, or the offscreen target
+// when headless. GBE_HandleEvent keeps this up to date as the window is resized or moves
+// to another display, so reading it is free.
+typedef struct GBE_TargetState {
+    SDL_GPUTextureFormat format;
+    Uint32 width;
+    Uint32 height;
+    SDL_GPUPresentMode presentMode;
+    SDL_GPUSwapchainComposition composition;
+    Uint32 framesInFlight;
+
+    // Bitmasks of (1 << SDL_GPUPresentMode) and (1 << SDL_GPUSwapchainComposition) the
+    // window supports on its current display.
+    Uint32 supportedPresentModes;
+    Uint32 supportedCompositions;
+} GBE_TargetState;
+
+// How many frames' worth of input-to-completion latency we can be measuring at once.
+#define GBE_MAX_LATENCY_PROBES 4
+
+// Rolling throughput and latency numbers, logged about once a second when enabled so
+// different present modes and frames-in-flight settings can be compared.
+typedef struct GBE_FrameStats {
+    bool enabled;
+    Uint64 intervalStartNS;
+    Uint32 intervalFrames;
+
+    // Timestamp of the oldest input event that hasn't made it into a submitted frame
+    // yet, or 0 if there isn't one.
+    Uint64 pendingInputNS;
+
+    // Frames that picked up input (frame number + 1, or 0 for an unused probe), waiting
+    // for the GPU to finish them.
+    Uint64 latencyFrames[GBE_MAX_LATENCY_PROBES];
+    Uint64 latencyInputNS[GBE_MAX_LATENCY_PROBES];
+
+    // The samples end when a frame's fence is next checked, at the start of a later frame,
+    // not when the GPU signaled it. So each one is an upper bound, high by anything up to
+    // a frame.
+    Uint64 latencyTotalNS;
+    Uint32 latencySamples;
+} GBE_FrameStats;
+
+// Whether frames get drawn every time through SDL_AppIterate, or only when something's
+// changed. See GBE_ShouldRender in GBE_Frame.h.
+typedef struct GBE_FramePolicy {
+    bool onDemand;
+
+    // How often SDL_AppIterate gets called while there's nothing to draw: this many times
+    // a second, or with 0, only once events arrive. `idle` says whether it's been slowed
+    // down to that.
+    Uint32 idleRate;
+    bool idle;
+
+    // GBE_RedrawReason bits for whatever's changed since the last frame was drawn, and
+    // whether the app has something moving, which needs every frame drawn.
+    Uint32 dirty;
+    bool animating;
+
+    // Times through SDL_AppIterate that didn't draw anything.
+    Uint64 framesSkipped;
+} GBE_FramePolicy;
+
+// How many submitted frames we can be waiting on at once. Frames in flight tops out at
+// 3, so this is plenty; GBE_EndFrame only ever waits if the GPU is further behind.
+#define GBE_MAX_FRAME_FENCES 8
+
+// Every frame is submitted with a fence, so we know which frames the GPU has finished.
+// Frame N's fence lives in fences[N % GBE_MAX_FRAME_FENCES] until it's signaled.
+typedef struct GBE_FrameFences {
+    SDL_GPUFence* fences[GBE_MAX_FRAME_FENCES];
+
+    // Frames 0 up to (but not including) this one are known to be finished.
+    Uint64 completedFrames;
+} GBE_FrameFences;
+
+typedef enum GBE_ResourceType {
+    GBE_RESOURCE_BUFFER,
+    GBE_RESOURCE_TRANSFER_BUFFER,
+    GBE_RESOURCE_TEXTURE,
+    GBE_RESOURCE_SAMPLER,
+    GBE_RESOURCE_SHADER,
+    GBE_RESOURCE_GRAPHICS_PIPELINE,
+    GBE_RESOURCE_COMPUTE_PIPELINE
+} GBE_ResourceType;
+
+typedef struct GBE_PendingRelease {
+    GBE_ResourceType type;
+    void* resource;
+
+    // The last frame that could have used it; it's released once that frame is done.
+    Uint64 frame;
+} GBE_PendingRelease;
+
+typedef struct GBE_TrackedResource {
+    GBE_ResourceType type;
+    void* resource;
+    const char* name;
+} GBE_TrackedResource;
+
+// GPU resources waiting for the GPU to finish with them before they're released, and
+// (in debug mode) every resource that's been registered, so anything never released can
+// be reported when the app quits. See GBE_ReleaseQueue.h.
+typedef struct GBE_ReleaseQueue {
+    GBE_PendingRelease* pending;
+    int numPending;
+    int maxPending;
+
+    bool trackResources;
+    GBE_TrackedResource* tracked;
+    int numTracked;
+    int maxTracked;
+
+    Uint64 released;
+} GBE_ReleaseQueue;
+
+// Graphics pipelines shared by everything that asks for the same description, along
+// with how often a lookup found one already made. The entries themselves are private to
+// GBE_PipelineCache.c. See GBE_PipelineCache.h.
+typedef struct GBE_PipelineCache {
+    struct GBE_CachedPipeline** entries;
+    int numEntries;
+    int maxEntries;
+
+    // The same entries again in an open-addressed hash table, found by their description's
+    // hash with linear probing. numSlots is a power of two, kept at most 3/4 full.
+    struct GBE_CachedPipeline** slots;
+    int numSlots;
+
+    Uint32 hits;
+    Uint32 misses;
+    Uint32 prewarmed;
+
+    // Where the descriptions get saved at quit and read back from at startup, if anywhere,
+    // and that file's contents between being read and being prewarmed from.
+    const char* path;
+    void* startupFile;
+    size_t startupFileSize;
+} GBE_PipelineCache;
+
 typedef struct GBE_Context {
     SDL_Window* window;
     SDL_GPUDevice* device;
     SDL_Storage* titleStorage;
+
+    GBE_DeviceCaps caps;
+    GBE_TargetState target;
+
+    // Headless contexts have no window (window is NULL); frames get rendered into
+    // this offscreen texture instead of a swapchain texture. Its size and format are
+    // in `target`.
+    bool headless;
+    SDL_GPUTexture* offscreenTarget;
+
+    // The depth buffer handed out with each frame, if the app asked for one (see
+    // depthBuffer in GBE_InitConfig). It's in caps.depthFormat, and GBE_BeginFrame makes
+    // a new one whenever the target changes size.
+    bool useDepthTarget;
+    SDL_GPUTexture* depthTarget;
+    Uint32 depthTargetWidth;
+    Uint32 depthTargetHeight;
+
+    // How many frames have been submitted so far, and (if not 0) how many to run
+    // before GBE_EndFrame asks the app to quit.
+    Uint64 frameNumber;
+    Uint64 maxFrames;
+
+    // Sends SDL_EVENT_QUIT once the time from runSeconds in GBE_InitConfig is up, or 0.
+    SDL_TimerID quitTimer;
+
+    GBE_FrameFences frameFences;
+    GBE_ReleaseQueue releaseQueue;
+    GBE_PipelineCache pipelineCache;
+
+    GBE_FrameStats stats;
+    GBE_FramePolicy policy;
 } GBE_Context;
 
 #endif /* GBE_Context_h */
@@ -0,0 +1,151 @@
+//
+//  GBE_DrawList.h
+//  GBECommon
+//
+//  Draws recorded as small plain packets instead of issued straight away, so
+//  they can be sorted before they reach the GPU: grouped by pipeline and
+//  material to cut down on state changes, and ordered by depth (front to back
+//  for opaque things, so the depth test throws more away; back to front for
+//  blended ones, so they blend correctly).
+//
+//  Every packet has a 64-bit sort key. GBE_MakeDrawKey packs one as
+//
+//      bits 60-63  layer      (drawn in order: e.g. opaque, then blended, then UI)
+//      bits 48-59  pipeline
+//      bits 32-47  material
+//      bits  0-31  depth
+//
+//  and GBE_SortDrawList radix sorts by it. The replay goes through a
+//  GBE_RenderPass, so binds shared by consecutive packets only happen once.
+//
+//  Lists of things that don't change from frame to frame can be kept instead
+//  of recorded again every frame: see GBE_BeginStaticDrawList.
+
+#ifndef GBE_DrawList_h
+#define GBE_DrawList_h
+
+#include "GBE_Context.h"
+#include "GBE_RenderPass.h"
+
+typedef struct GBE_DrawPacket {
+    Uint64 key;
+
+    SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUBufferBinding vertexBuffer;
+    SDL_GPUBufferBinding indexBuffer;
+    SDL_GPUIndexElementSize indexElementSize;
+
+    // Bound to vertex storage buffer slot 0 if not NULL.
+    SDL_GPUBuffer* storageBuffer;
+
+    // Where this draw's vertex uniforms are in the list's uniform data, and how big
+    // they are; 0 for none. GBE_AddDraw fills these in.
+    Uint32 uniformOffset;
+    Uint32 uniformSize;
+
+    // An indexed draw if indexBuffer.buffer isn't NULL, in which case `count` is the
+    // number of indices; otherwise the number of vertices.
+    Uint32 count;
+    Uint32 numInstances;
+    Uint32 first;
+    Sint32 vertexOffset;
+} GBE_DrawPacket;
+
+// Pairs of sort key and packet index, which are what actually get shuffled around by the
+// sort; packets themselves never move.
+typedef struct GBE_DrawSortEntry {
+    Uint64 key;
+    Uint32 packet;
+    Uint32 padding;
+} GBE_DrawSortEntry;
+
+// A static list's replay, worked out ahead of time: just the SDL calls that change
+// something, each pointing at the packet it takes its arguments from.
+typedef enum GBE_DrawCommandType {
+    GBE_DRAW_COMMAND_BIND_PIPELINE,
+    GBE_DRAW_COMMAND_BIND_VERTEX_BUFFER,
+    GBE_DRAW_COMMAND_BIND_INDEX_BUFFER,
+    GBE_DRAW_COMMAND_BIND_STORAGE_BUFFER,
+    GBE_DRAW_COMMAND_PUSH_UNIFORMS,
+    GBE_DRAW_COMMAND_DRAW
+} GBE_DrawCommandType;
+
+typedef struct GBE_DrawCommand {
+    GBE_DrawCommandType type;
+    Uint32 packet;
+} GBE_DrawCommand;
+
+typedef struct GBE_DrawList {
+    GBE_DrawPacket* packets;
+    Uint32 numPackets;
+    Uint32 maxPackets;
+
+    GBE_DrawSortEntry* order;
+    GBE_DrawSortEntry* scratch;
+    bool sorted;
+
+    Uint8* uniforms;
+    Uint32 uniformsUsed;
+    Uint32 uniformsCapacity;
+
+    // Static lists only: what the list was recorded against, whether it's been baked
+    // since, and the baked commands. `bakedSkipped` is how many binds and pushes baking
+    // left out as redundant.
+    bool isStatic;
+    bool baked;
+    Uint64 stamp;
+    GBE_DrawCommand* commands;
+    Uint32 numCommands;
+    Uint32 maxCommands;
+    Uint32 bakedSkipped;
+} GBE_DrawList;
+
+// Packs a sort key. Depth is a view distance (anything non-negative), and sorts nearest
+// first unless backToFront is set. Layer, pipeline and material are cut down to the bits
+// they have in the key.
+Uint64 GBE_MakeDrawKey(Uint32 layer, Uint32 pipeline, Uint32 material, float depth, bool backToFront);
+
+// Room for this many packets and bytes of uniform data up front; both grow if needed.
+bool GBE_CreateDrawList(Uint32 maxPackets, Uint32 uniformsCapacity, GBE_DrawList* list);
+void GBE_DestroyDrawList(GBE_DrawList* list);
+
+// Empties the list for the next frame, keeping its memory.
+void GBE_ResetDrawList(GBE_DrawList* list);
+
+// Copies a packet into the list, with `uniformSize` bytes of vertex uniform data for
+// slot 0 (which can be NULL for none). Returns false if it ran out of memory.
+bool GBE_AddDraw(GBE_DrawList* list, const GBE_DrawPacket* packet, const void* uniforms, Uint32 uniformSize);
+
+// Orders the packets by key, keeping packets with equal keys in the order they were
+// added. Replaying an unsorted list plays the packets back in the order they were added.
+void GBE_SortDrawList(GBE_DrawList* list);
+
+// Records every packet into the render pass. Baked static lists skip straight to the
+// SDL calls they worked out when they were baked.
+void GBE_ReplayDrawList(const GBE_DrawList* list, GBE_RenderPass* renderPass);
+
+// Records `count` packets, starting `first` packets into the list's order, so a list can
+// be split up and recorded in pieces (say, one per thread; see GBE_ParallelRecorder.h).
+// Always goes through the render pass's filtering, even for baked lists.
+void GBE_ReplayDrawListRange(const GBE_DrawList* list, GBE_RenderPass* renderPass, Uint32 first, Uint32 count);
+
+// Static lists are recorded once and replayed every frame until whatever they depend on
+// changes. That's summed up in a stamp: hash everything the packets were built from
+// (camera, transforms, pipelines and buffers, target size...) with GBE_HashStamp, and
+// pass it in every frame. If it matches what the list was recorded against, this returns
+// false and the list is ready to replay as is. Otherwise it empties the list, and
+// returns true: add the packets again, then call GBE_BakeDrawList.
+bool GBE_BeginStaticDrawList(GBE_DrawList* list, Uint64 stamp);
+
+// Sorts a static list and works out the SDL calls its replay needs, leaving out binds
+// and pushes that repeat the packet before's.
+bool GBE_BakeDrawList(GBE_DrawList* list);
+
+// Forces the next GBE_BeginStaticDrawList to ask for the list to be recorded again, e.g.
+// after a buffer it uses has been replaced.
+void GBE_InvalidateDrawList(GBE_DrawList* list);
+
+// Folds `size` bytes into a stamp. Start from 0.
+Uint64 GBE_HashStamp(Uint64 stamp, const void* data, size_t size);
+
+#endif /* GBE_DrawList_h */
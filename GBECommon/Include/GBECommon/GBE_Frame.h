@@ -0,0 +1,96 @@
+//
+//  GBE_Frame.h
+//  GBECommon
+//
+//  Per-frame boilerplate: getting a command buffer and something to draw into,
+//  and submitting it all when we're done. Works the same whether we're drawing
+//  into a window or running headless.
+
+#ifndef GBE_Frame_h
+#define GBE_Frame_h
+
+#include "GBE_Context.h"
+
+typedef struct GBE_Frame {
+    SDL_GPUCommandBuffer* commandBuffer;
+
+    // What to render into this frame: the window's swapchain texture, or the offscreen
+    // target when running headless. This can be NULL (e.g. when the window is minimized);
+    // skip drawing, but still call GBE_EndFrame.
+    SDL_GPUTexture* target;
+    Uint32 width;
+    Uint32 height;
+
+    // A depth buffer the same size as the target, in the context's caps.depthFormat, if
+    // the context was set up with one; NULL otherwise, or whenever target is.
+    SDL_GPUTexture* depthTarget;
+} GBE_Frame;
+
+SDL_AppResult GBE_BeginFrame(GBE_Context* context, GBE_Frame* frame);
+SDL_AppResult GBE_EndFrame(GBE_Context* context, GBE_Frame* frame);
+
+// Gives up on a frame that couldn't be recorded, instead of GBE_EndFrame, so its command
+// buffer isn't left hanging. SDL can't cancel one that's acquired a swapchain texture, so
+// that's submitted as it is (which hands the texture back); any other is canceled.
+void GBE_CancelFrame(GBE_Context* context, GBE_Frame* frame);
+
+// Why a frame needs drawing, for contexts that render on demand. GBE_HandleEvent flags
+// input, resizes and the window being uncovered; apps flag their own changes with
+// GBE_REDRAW_CONTENT.
+typedef enum GBE_RedrawReason {
+    GBE_REDRAW_CONTENT = 1 << 0,
+    GBE_REDRAW_INPUT = 1 << 1,
+    GBE_REDRAW_RESIZE = 1 << 2,
+    GBE_REDRAW_EXPOSED = 1 << 3
+} GBE_RedrawReason;
+
+// Render on demand: call this at the top of SDL_AppIterate, and if it says no, return
+// without acquiring, recording or submitting anything. It says yes every time unless the
+// context renders on demand (renderOnDemand in GBE_InitConfig); then only when a redraw's
+// been asked for since the last frame, or something's animating. While it's saying no,
+// SDL_AppIterate is slowed down to the context's idle rate.
+bool GBE_ShouldRender(GBE_Context* context);
+void GBE_RequestRedraw(GBE_Context* context, GBE_RedrawReason reason);
+
+// While animating, every frame gets drawn, on demand or not.
+void GBE_SetAnimating(GBE_Context* context, bool animating);
+
+// The pixel format frames get rendered in; pipelines need this for their color target.
+// Like GBE_GetTargetSize, this just reads the context's cached target state, so it's
+// fine to call as often as you like.
+SDL_GPUTextureFormat GBE_GetTargetFormat(GBE_Context* context);
+
+// The format of the frames' depth buffers, or SDL_GPU_TEXTUREFORMAT_INVALID if they don't
+// get one. Pipelines that draw into frames need to agree with this.
+SDL_GPUTextureFormat GBE_GetDepthFormat(GBE_Context* context);
+
+// The size, in pixels, of what frames get rendered into.
+void GBE_GetTargetSize(GBE_Context* context, Uint32* width, Uint32* height);
+
+// Re-queries the swapchain format, size and supported present modes from SDL. You
+// shouldn't normally need to call this; GBE_HandleEvent does when it has to.
+void GBE_RefreshTargetState(GBE_Context* context);
+
+// Swapchain tuning. Present modes trade latency, tearing and power against each other:
+//
+// - VSYNC waits for the display's refresh; always supported, no tearing.
+// - MAILBOX doesn't wait, but replaces the queued image instead of tearing.
+// - IMMEDIATE doesn't wait and may tear; lowest latency.
+//
+// Asking for a mode the window doesn't support falls back to the next best one
+// (IMMEDIATE -> MAILBOX -> VSYNC). Both functions return what's actually in use.
+SDL_GPUPresentMode          GBE_SetPresentMode(GBE_Context* context, SDL_GPUPresentMode presentMode);
+SDL_GPUSwapchainComposition GBE_SetSwapchainComposition(GBE_Context* context, SDL_GPUSwapchainComposition composition);
+
+// How many frames the CPU can get ahead of the GPU. 1 gives the lowest latency, 3 the
+// most throughput when frame times are uneven; SDL's default is 2.
+bool GBE_SetFramesInFlight(GBE_Context* context, Uint32 framesInFlight);
+
+const char* GBE_GetPresentModeName(SDL_GPUPresentMode presentMode);
+bool        GBE_ParsePresentMode(const char* name, SDL_GPUPresentMode* presentMode);
+
+// Pass every event from SDL_AppEvent through here so the cached target state follows
+// window resizes and display changes, and so input can be timed for the frame stats.
+void GBE_HandleEvent(GBE_Context* context, const SDL_Event* event);
+
+#endif /* GBE_Frame_h */
@@ -0,0 +1,90 @@
+//
+//  GBE_FrameArena.h
+//  GBECommon
+//
+//  Scratch memory for CPU data that only lives for a frame or so: culling
+//  lists, sort keys, uniforms being put together, that kind of thing. Getting
+//  these from SDL_malloc means a trip through the general heap for every one,
+//  and freeing each one again. An arena hands out memory by bumping an offset,
+//  and the whole lot is let go of at once by setting the offset back to 0.
+//
+//  Each frame in flight gets its own region. Resetting for frame N only
+//  throws away what frame N - numFrames allocated, so anything still being
+//  read while the next frames are prepared (by another thread, say) stays put.
+//
+//  An arena belongs to one thread at a time. GBE_JobArenas gives every thread
+//  of a job system an arena of its own, so jobs can allocate without locking.
+
+#ifndef GBE_FrameArena_h
+#define GBE_FrameArena_h
+
+#include "GBE_Jobs.h"
+
+// Frames in flight top out at 3.
+#define GBE_MAX_ARENA_FRAMES 3
+
+// Regions, and each thread's arena in GBE_JobArenas, start on a cache line of their own.
+#define GBE_CACHE_LINE_SIZE 64
+
+typedef struct GBE_FrameArena {
+    // numFrames regions of `capacity` bytes each, one after the other.
+    Uint8* memory;
+    size_t capacity;
+    int numFrames;
+
+    // The region allocations are coming out of, and how much of it's been handed out.
+    Uint8* region;
+    size_t used;
+
+    // The most bytes any frame has used, and how many allocations didn't fit. If
+    // overflows isn't 0, the arena needs to be bigger.
+    size_t highWaterMark;
+    Uint64 allocations;
+    Uint64 overflows;
+} GBE_FrameArena;
+
+// `capacity` bytes for each of `numFrames` frames (clamped to 1 through
+// GBE_MAX_ARENA_FRAMES).
+bool GBE_CreateFrameArena(size_t capacity, int numFrames, GBE_FrameArena* arena);
+void GBE_DestroyFrameArena(GBE_FrameArena* arena);
+
+// Call at the start of each frame: switches to frame `frameNumber`'s region and empties
+// it, however much was allocated from it.
+void GBE_ResetFrameArena(GBE_FrameArena* arena, Uint64 frameNumber);
+
+// Hands out `size` bytes at a multiple of `alignment` (a power of two), good until the
+// arena's next reset for the same region. The memory isn't zeroed. Returns NULL if the
+// frame's run out of room.
+void* GBE_FrameArenaAlloc(GBE_FrameArena* arena, size_t size, size_t alignment);
+
+// A thread's arena, padded out to whole cache lines. Every allocation writes to its
+// arena's offsets, so two threads' arenas sharing a line would have the threads fighting
+// over it.
+typedef union GBE_JobArena {
+    GBE_FrameArena arena;
+    Uint8 padding[(sizeof(GBE_FrameArena) + GBE_CACHE_LINE_SIZE - 1) / GBE_CACHE_LINE_SIZE * GBE_CACHE_LINE_SIZE];
+} GBE_JobArena;
+
+// One arena per thread of a job system, indexed the same way as its threads. `arenas` is
+// allocated on a cache line boundary.
+typedef struct GBE_JobArenas {
+    GBE_JobSystem* jobs;
+    GBE_JobArena* arenas;
+    int numArenas;
+} GBE_JobArenas;
+
+bool GBE_CreateJobArenas(GBE_JobSystem* jobs, size_t capacity, int numFrames, GBE_JobArenas* arenas);
+void GBE_DestroyJobArenas(GBE_JobArenas* arenas);
+
+// Resets every thread's arena. Only call this while no jobs are running.
+void GBE_ResetJobArenas(GBE_JobArenas* arenas, Uint64 frameNumber);
+
+// Allocates from the calling thread's arena. Must be called from one of the job
+// system's threads.
+void* GBE_JobArenaAlloc(GBE_JobArenas* arenas, size_t size, size_t alignment);
+
+// Totals over every thread: the sum of their high-water marks and overflows.
+size_t GBE_GetJobArenasHighWaterMark(const GBE_JobArenas* arenas);
+Uint64 GBE_GetJobArenasOverflows(const GBE_JobArenas* arenas);
+
+#endif /* GBE_FrameArena_h */
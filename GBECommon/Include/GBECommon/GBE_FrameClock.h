@@ -0,0 +1,93 @@
+//
+//  GBE_FrameClock.h
+//  GBECommon
+//
+//  Frame timing in nanoseconds. Millisecond ticks make for deltas like 6, 7, 7
+//  ms at 144 Hz. Here each tick measures the time since the last one with
+//  SDL_GetTicksNS, and also keeps a smoothed delta and a history of recent
+//  frame times.
+//
+//  It can also run a fixed timestep. Time piles up in an accumulator, and the
+//  simulation takes as many fixed steps as fit into it, however often frames
+//  are rendered. The render then blends between the last two simulated states
+//  by however far it is into the next step, so motion stays smooth when the
+//  simulation runs slower than the display.
+//
+//      GBE_TickFrameClock(&clock);
+//      while (GBE_NextFixedStep(&clock)) {
+//          previous = current;
+//          Simulate(&current, GBE_GetFixedStepSeconds(&clock));
+//      }
+//      Draw(Lerp(previous, current, GBE_GetFrameClockAlpha(&clock)));
+
+#ifndef GBE_FrameClock_h
+#define GBE_FrameClock_h
+
+#include <SDL3/SDL.h>
+
+// How many of the most recent frame times are kept.
+#define GBE_FRAME_CLOCK_HISTORY 128
+
+// Longer frames than this (say, after sitting in a debugger) count as this long, so
+// nothing jumps.
+#define GBE_FRAME_CLOCK_MAX_DELTA_NS (200 * SDL_NS_PER_MS)
+
+// The most fixed steps one tick runs. Once the simulation can't keep up, whatever time
+// is left over is dropped, rather than each tick running more steps than the last.
+#define GBE_FRAME_CLOCK_MAX_STEPS 8
+
+typedef struct GBE_FrameClock {
+    Uint64 lastTickNS;
+    Uint64 frames;
+
+    // The last tick's delta (after clamping), a moving average of them that weights the
+    // newest one by `smoothing`, and the total of every delta since the clock was reset.
+    Uint64 deltaNS;
+    double smoothedDeltaNS;
+    double smoothing;
+    Uint64 elapsedNS;
+
+    // The last GBE_FRAME_CLOCK_HISTORY deltas, oldest overwritten first.
+    Uint64 history[GBE_FRAME_CLOCK_HISTORY];
+    Uint32 historyCount;
+
+    // 0 without a fixed timestep. Otherwise the accumulator holds time not yet simulated;
+    // `stepsTaken` and `stepsDropped` count steps run and the ones skipped to catch up.
+    Uint64 fixedStepNS;
+    Uint64 accumulatorNS;
+    Uint64 stepsTaken;
+    Uint64 stepsDropped;
+} GBE_FrameClock;
+
+// What's in the frame time history, in milliseconds. `jitterMS` is the standard
+// deviation.
+typedef struct GBE_FrameTimeSummary {
+    Uint32 samples;
+    double minMS;
+    double averageMS;
+    double maxMS;
+    double jitterMS;
+} GBE_FrameTimeSummary;
+
+// Starts timing from now, with a fixed step of `fixedStepNS` (or 0 for none).
+void GBE_ResetFrameClock(GBE_FrameClock* clock, Uint64 fixedStepNS);
+
+// Call once a frame: measures how long it's been since the last tick, and adds it to the
+// accumulator.
+void GBE_TickFrameClock(GBE_FrameClock* clock);
+
+// The smoothed delta, in seconds, for simulations that take one variable step a frame.
+double GBE_GetSmoothedDeltaSeconds(const GBE_FrameClock* clock);
+
+// Takes one fixed step out of the accumulator, if there's a whole one in it. Always
+// false without a fixed timestep.
+bool GBE_NextFixedStep(GBE_FrameClock* clock);
+double GBE_GetFixedStepSeconds(const GBE_FrameClock* clock);
+
+// How far into the next fixed step the accumulator is, from 0 up to 1, for blending the
+// last two simulated states. 1 without a fixed timestep.
+float GBE_GetFrameClockAlpha(const GBE_FrameClock* clock);
+
+void GBE_SummarizeFrameTimes(const GBE_FrameClock* clock, GBE_FrameTimeSummary* summary);
+
+#endif /* GBE_FrameClock_h */
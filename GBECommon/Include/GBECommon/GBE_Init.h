@@ -11,7 +11,90 @@
 
 #include "GBE_Context.h"
 
+// The most shader format combinations GBE_InitConfig can list.
+#define GBE_MAX_SHADER_FORMAT_PREFERENCES 4
+
+// Everything GBE_CommonInitWithConfig needs to know to get SDL up and running.
+// Start from GBE_DefaultInitConfig and change whatever you need.
+typedef struct GBE_InitConfig {
+    const char* windowTitle;
+    int windowWidth;
+    int windowHeight;
+
+    // Turns on the GPU backend's validation layers. Great while developing, but they
+    // make device creation and every GPU call slower, so the default is on only for
+    // debug builds (i.e. when NDEBUG isn't defined).
+    bool debugMode;
+
+    // Sets of shader formats we can supply, in order of preference. Each one is checked
+    // with SDL_GPUSupportsShaderFormats before anything gets created, so we only ever
+    // create the one GPU device we're going to use.
+    SDL_GPUShaderFormat shaderFormats[GBE_MAX_SHADER_FORMAT_PREFERENCES];
+    int numShaderFormats;
+
+    // Optionally ask for a specific backend ("vulkan", "direct3d12", "metal"). Leave it
+    // NULL to let SDL choose.
+    const char* preferredDriver;
+
+    // Don't create a window: render into an offscreen texture of windowWidth x
+    // windowHeight pixels in offscreenFormat instead. This lets the examples run on
+    // machines without a display, e.g. under a software Vulkan driver like lavapipe.
+    bool headless;
+    SDL_GPUTextureFormat offscreenFormat;
+
+    // Give every frame a depth buffer the size of the target (GBE_Frame's depthTarget),
+    // in the device's best depth format. Off by default; 2D examples don't need one.
+    bool depthBuffer;
+
+    // Stop after this many frames, or this many seconds; 0 runs until the app quits on
+    // its own. Frames that GBE_ShouldRender skips don't count, so with renderOnDemand a
+    // time limit is the one to use. Headless runs with both ignore renderOnDemand, since
+    // nothing would ever flag a redraw to count.
+    Uint64 maxFrames;
+    Uint32 runSeconds;
+
+    // How long to wait for title storage to become ready before giving up.
+    Uint32 storageTimeoutMS;
+
+    // Swapchain behavior; see GBE_SetPresentMode and GBE_SetFramesInFlight. Modes the
+    // window can't do fall back to ones it can.
+    SDL_GPUPresentMode presentMode;
+    SDL_GPUSwapchainComposition composition;
+    Uint32 framesInFlight;
+
+    // Log frame rate and input latency about once a second.
+    bool logFrameStats;
+
+    // Only draw frames when something's changed, and slow SDL_AppIterate down to
+    // idleRate times a second (or, with 0, until events arrive) while nothing has. See
+    // GBE_ShouldRender.
+    bool renderOnDemand;
+    Uint32 idleRate;
+
+    // A file to save the pipeline cache's descriptions to at quit, and to create them all
+    // from at startup, so the pipelines are ready before the first frame needs them. The
+    // string isn't copied, so it has to stick around. NULL to do neither.
+    const char* pipelineCachePath;
+} GBE_InitConfig;
+
+void          GBE_DefaultInitConfig(GBE_InitConfig* config, const char* windowTitle);
+
+// Picks up the options every example understands from the command line:
+//   --headless        render offscreen instead of into a window
+//   --size WxH        window (or offscreen target) size
+//   --frames N        quit after N frames
+//   --run-for SECONDS quit after this many seconds
+//   --driver NAME     ask for a specific GPU backend
+//   --debug / --no-debug   turn GPU validation on or off
+//   --present-mode vsync|immediate|mailbox
+//   --frames-in-flight N   1 to 3
+//   --stats           log frame rate and input latency
+//   --on-demand / --continuous   only draw when something's changed, or every frame
+//   --idle-rate HZ    iterate this often while idle (0: only on events); implies --on-demand
+//   --pipeline-cache FILE  save pipeline descriptions to FILE, and prewarm from it
+void          GBE_ApplyCommandLine(GBE_InitConfig* config, int argc, char** argv);
 SDL_AppResult GBE_CommonInit(GBE_Context* appContext, const char* windowTitle);
+SDL_AppResult GBE_CommonInitWithConfig(GBE_Context* appContext, const GBE_InitConfig* config);
 void          GBE_Quit(GBE_Context* appContext);
 
 #endif /* GBE_Init_h */
@@ -0,0 +1,112 @@
+//
+//  GBE_Jobs.h
+//  GBECommon
+//
+//  A small work-stealing job system, for spreading CPU work (transforms,
+//  culling, building draw lists...) over every core.
+//
+//  Each thread has its own deque of jobs. It pushes and pops jobs at one end,
+//  and idle threads steal from the other end (a Chase-Lev deque), so threads
+//  mostly stay out of each other's way. Jobs are counted down on a counter when
+//  they finish; waiting on a counter runs other jobs until it reaches 0 instead
+//  of blocking, so jobs can start jobs of their own and wait for them. That's
+//  also how one job waits for another it depends on.
+//
+//  The thread that creates the job system is one of its threads, and so are
+//  the workers it starts. Only those threads may start jobs or wait on them.
+
+#ifndef GBE_Jobs_h
+#define GBE_Jobs_h
+
+#include <SDL3/SDL.h>
+
+// How many threads a job system can have, and how many jobs each one can have queued.
+// A thread that starts a job while its deque is full runs it right away instead.
+#define GBE_MAX_JOB_THREADS 32
+#define GBE_JOB_DEQUE_SIZE 4096
+
+typedef void (*GBE_JobFunction)(void* data);
+
+// Runs items `begin` up to (not including) `end` of a GBE_ParallelFor.
+typedef void (*GBE_RangeFunction)(void* data, Uint32 begin, Uint32 end);
+
+// How many jobs started against it haven't finished yet. Zero it before first use.
+typedef struct GBE_JobCounter {
+    SDL_AtomicInt pending;
+} GBE_JobCounter;
+
+typedef struct GBE_Job {
+    GBE_JobFunction function;
+    void* data;
+    GBE_JobCounter* counter;
+
+    // GBE_ParallelFor's jobs each run a range, splitting it first if it's big enough.
+    GBE_RangeFunction rangeFunction;
+    Uint32 begin;
+    Uint32 end;
+    Uint32 grain;
+
+    // Set while the job is queued or running, so its slot isn't handed out again.
+    SDL_AtomicInt busy;
+} GBE_Job;
+
+typedef struct GBE_JobThread {
+    struct GBE_JobSystem* jobs;
+    SDL_Thread* thread;
+    int index;
+
+    // The deque: the owner pushes and pops at `bottom`, thieves take from `top`.
+    GBE_Job* slots[GBE_JOB_DEQUE_SIZE];
+    SDL_AtomicU32 top;
+    SDL_AtomicU32 bottom;
+
+    // Jobs are kept in a ring, handed out in order. A slot still in use means there are
+    // a ring's worth of jobs outstanding, and the new one runs right away.
+    GBE_Job pool[GBE_JOB_DEQUE_SIZE];
+    Uint32 nextJob;
+
+    // For picking threads to steal from.
+    Uint32 random;
+
+    // Jobs this thread ran, how many of those it stole, and how many it had to run right
+    // away because it was out of room.
+    Uint64 executed;
+    Uint64 stolen;
+    Uint64 ranInline;
+} GBE_JobThread;
+
+typedef struct GBE_JobSystem {
+    int numThreads;
+    GBE_JobThread* threads;
+
+    // Which of the job system's threads the current one is.
+    SDL_TLSID currentThread;
+
+    // Idle workers sleep on `wake` after a while without finding anything to do.
+    SDL_Semaphore* wake;
+    SDL_AtomicInt sleepers;
+    SDL_AtomicInt quit;
+} GBE_JobSystem;
+
+// Starts numThreads - 1 worker threads; the calling thread is the other one. 0 means one
+// thread per logical CPU core.
+bool GBE_CreateJobSystem(int numThreads, GBE_JobSystem* jobs);
+void GBE_DestroyJobSystem(GBE_JobSystem* jobs);
+
+// Which of the job system's threads is calling: 0 for the one that created it, 1 and up
+// for the workers, or -1 for any other thread.
+int GBE_GetJobThreadIndex(GBE_JobSystem* jobs);
+
+// Queues `function(data)` to run on whichever thread gets to it first. The counter, if
+// not NULL, goes up by one now and back down when the job's finished.
+void GBE_RunJob(GBE_JobSystem* jobs, GBE_JobFunction function, void* data, GBE_JobCounter* counter);
+
+// Runs other jobs until the counter gets to 0.
+void GBE_WaitForCounter(GBE_JobSystem* jobs, GBE_JobCounter* counter);
+
+// Calls `function` on ranges of 0 up to `count` from every thread, and returns when all
+// of it's done. Ranges are split in half until they're no bigger than the grain size:
+// enough pieces to keep every thread busy, but never fewer than `minGrain` items each.
+void GBE_ParallelFor(GBE_JobSystem* jobs, Uint32 count, Uint32 minGrain, GBE_RangeFunction function, void* data);
+
+#endif /* GBE_Jobs_h */
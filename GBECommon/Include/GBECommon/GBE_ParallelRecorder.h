@@ -0,0 +1,99 @@
+//
+//  GBE_ParallelRecorder.h
+//  GBECommon
+//
+//  Records one render pass's worth of draws on several threads at once. The
+//  draws are split into consecutive chunks, and each chunk gets its own command
+//  buffer and render pass, recorded by a worker thread (or the calling thread,
+//  which takes the first chunk). SDL wants a command buffer acquired, recorded
+//  and submitted all on the same thread, so each chunk's thread does all three.
+//
+//  The recording overlaps, but the submits take turns: each chunk waits for the
+//  one before it to be submitted before submitting its own, so the GPU draws
+//  them in the same order a single pass would have. They all render into a color
+//  texture of the recorder's own (and the frame's depth buffer, if it has one):
+//  the first chunk clears them and the rest load what came before. The swapchain
+//  texture can only be used by the command buffer that acquired it, so the
+//  result is blitted into the frame's target from the frame's command buffer.
+
+#ifndef GBE_ParallelRecorder_h
+#define GBE_ParallelRecorder_h
+
+#include "GBE_Context.h"
+#include "GBE_Frame.h"
+#include "GBE_RenderPass.h"
+
+// The most threads (the caller's included) a recorder splits the work between.
+#define GBE_MAX_RECORD_THREADS 16
+
+// Records draws `first` up to `first + count` of whatever's being drawn into the render
+// pass. Called on a worker thread, and on several at once, so it mustn't change anything
+// shared without its own locking.
+typedef void (*GBE_RecordFunction)(void* userData, GBE_RenderPass* renderPass, Uint32 first, Uint32 count);
+
+typedef struct GBE_RecordChunk {
+    struct GBE_ParallelRecorder* recorder;
+    SDL_Thread* thread;
+    SDL_Semaphore* start;
+
+    // Signaled once the chunk before this one has been submitted.
+    SDL_Semaphore* turn;
+
+    SDL_GPUCommandBuffer* commandBuffer;
+    Uint32 first;
+    Uint32 count;
+    bool failed;
+
+    // The chunk's render pass counts, and how long it took to record.
+    Uint32 issued;
+    Uint32 skipped;
+    Uint32 draws;
+    Uint64 recordNS;
+} GBE_RecordChunk;
+
+typedef struct GBE_ParallelRecorder {
+    GBE_Context* context;
+    int numThreads;
+    GBE_RecordChunk chunks[GBE_MAX_RECORD_THREADS];
+    SDL_Semaphore* done;
+    SDL_AtomicInt quit;
+
+    // What the current GBE_RecordInParallel call is recording, and how many chunks it's
+    // been split into.
+    GBE_RecordFunction function;
+    void* userData;
+    SDL_FColor clearColor;
+    SDL_GPUTexture* depthTarget;
+    bool filter;
+    int numActiveChunks;
+
+    // The texture the chunks render into, remade whenever the frame's size changes.
+    SDL_GPUTexture* colorTarget;
+    Uint32 width;
+    Uint32 height;
+
+    // Totals over every chunk of the last GBE_RecordInParallel call, and the longest any
+    // one chunk took to record.
+    Uint32 issued;
+    Uint32 skipped;
+    Uint32 draws;
+    Uint64 slowestChunkNS;
+} GBE_ParallelRecorder;
+
+// Starts `numThreads - 1` worker threads; the thread calling GBE_RecordInParallel is the
+// other one. numThreads is clamped to 1 through GBE_MAX_RECORD_THREADS.
+bool GBE_CreateParallelRecorder(GBE_Context* context, int numThreads, GBE_ParallelRecorder* recorder);
+void GBE_DestroyParallelRecorder(GBE_ParallelRecorder* recorder);
+
+// Clears to `clearColor` (and the frame's depth buffer to 1), splits `count` draws between
+// the threads, has each record and submit its chunk in order, then blits
+// the result into the frame's target with frame->commandBuffer. `filter` is passed on to
+// each chunk's GBE_RenderPass.
+//
+// The chunks are submitted before the frame's command buffer, so anything they need
+// uploaded has to be in a command buffer that's already been submitted, not in
+// frame->commandBuffer. Returns false, having logged why, if any of it failed.
+bool GBE_RecordInParallel(GBE_ParallelRecorder* recorder, GBE_Frame* frame, SDL_FColor clearColor, bool filter,
+    Uint32 count, GBE_RecordFunction function, void* userData);
+
+#endif /* GBE_ParallelRecorder_h */
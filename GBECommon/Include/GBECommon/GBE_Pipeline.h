@@ -0,0 +1,75 @@
+//
+//  GBE_Pipeline.h
+//  GBECommon
+//
+//  A plain description of a graphics pipeline, with presets for the usual ways
+//  of drawing things, so examples don't have to spell out every blend factor
+//  and depth setting by hand.
+
+#ifndef GBE_Pipeline_h
+#define GBE_Pipeline_h
+
+#include "GBE_Context.h"
+#include "GBE_Shaders.h"
+
+#define GBE_MAX_PIPELINE_VERTEX_BUFFERS 4
+#define GBE_MAX_PIPELINE_VERTEX_ATTRIBUTES 16
+
+// How a pipeline's output gets combined with what's already in the target.
+//
+// - OPAQUE overwrites it. No blending, and with a depth target it tests and writes
+//   depth, so hidden fragments can be thrown away before they're shaded and draw order
+//   doesn't matter (though front to back is fastest).
+// - ALPHA_BLEND mixes by the source alpha. It tests depth against opaque geometry but
+//   doesn't write it, so translucent things have to be drawn back to front, after
+//   everything opaque.
+// - ADDITIVE adds to the target (glows, particles). Like ALPHA_BLEND it tests depth but
+//   doesn't write it; since addition doesn't care about order, neither does it.
+typedef enum GBE_PipelinePreset {
+    GBE_PIPELINE_OPAQUE,
+    GBE_PIPELINE_ALPHA_BLEND,
+    GBE_PIPELINE_ADDITIVE
+} GBE_PipelinePreset;
+
+// Everything that goes into a graphics pipeline. It's plain data: shaders are named by
+// how to load them rather than by handle, and fixed-size arrays stand in for pointers,
+// so a description can be copied, compared and stored as is.
+typedef struct GBE_PipelineDesc {
+    GBE_LoadShaderInfo vertexShader;
+    GBE_LoadShaderInfo fragmentShader;
+
+    SDL_GPUVertexBufferDescription vertexBuffers[GBE_MAX_PIPELINE_VERTEX_BUFFERS];
+    Uint32 numVertexBuffers;
+    SDL_GPUVertexAttribute vertexAttributes[GBE_MAX_PIPELINE_VERTEX_ATTRIBUTES];
+    Uint32 numVertexAttributes;
+
+    SDL_GPUPrimitiveType primitiveType;
+    SDL_GPURasterizerState rasterizerState;
+
+    SDL_GPUTextureFormat colorFormat;
+    SDL_GPUColorTargetBlendState blendState;
+
+    // SDL_GPU_TEXTUREFORMAT_INVALID for pipelines that draw without a depth target.
+    SDL_GPUTextureFormat depthFormat;
+    SDL_GPUDepthStencilState depthStencilState;
+} GBE_PipelineDesc;
+
+// Fills in a description for drawing filled, back-face culled triangle lists with
+// counter-clockwise front faces into colorFormat, blended and depth tested the way the
+// preset says. Pass SDL_GPU_TEXTUREFORMAT_INVALID as the depth format for no depth
+// target. Shaders and vertex input are left empty for the caller to fill in.
+void GBE_InitPipelineDesc(GBE_PipelineDesc* desc, GBE_PipelinePreset preset,
+    SDL_GPUTextureFormat colorFormat, SDL_GPUTextureFormat depthFormat);
+
+// Vertex input, a buffer or attribute at a time. Both return false (and log) if the
+// description is already full.
+bool GBE_AddPipelineVertexBuffer(GBE_PipelineDesc* desc, Uint32 slot, Uint32 pitch, SDL_GPUVertexInputRate inputRate);
+bool GBE_AddPipelineVertexAttribute(GBE_PipelineDesc* desc, Uint32 bufferSlot, Uint32 location,
+    SDL_GPUVertexElementFormat format, Uint32 offset);
+
+// Loads the description's shaders, creates the pipeline, and releases the shaders again
+// (the pipeline keeps what it needs). Returns NULL, having logged why, if any of that
+// fails.
+SDL_GPUGraphicsPipeline* GBE_CreatePipeline(GBE_Context* context, const GBE_PipelineDesc* desc);
+
+#endif /* GBE_Pipeline_h */
@@ -0,0 +1,50 @@
+//
+//  GBE_PipelineCache.h
+//  GBECommon
+//
+//  Shares graphics pipelines between everything that describes the same one.
+//  Creating a pipeline is slow (it's where the driver compiles shaders down to
+//  GPU code), and different materials often end up asking for identical ones.
+//
+//  Descriptions are canonicalized before they're compared: vertex buffers and
+//  attributes are put in slot and location order, and settings that can't have
+//  any effect (blend factors with blending off, depth state without a depth
+//  target, and so on) are cleared. The canonical form is also what gets saved,
+//  so the pipelines one run used can be created up front by the next.
+
+#ifndef GBE_PipelineCache_h
+#define GBE_PipelineCache_h
+
+#include "GBE_Context.h"
+#include "GBE_Pipeline.h"
+
+// Returns the pipeline for `desc`, creating it if nothing matching has been created yet.
+// Every successful call needs a matching GBE_ReleaseCachedPipeline. Returns NULL, having
+// logged why, if the pipeline couldn't be created.
+SDL_GPUGraphicsPipeline* GBE_AcquireCachedPipeline(GBE_Context* context, const GBE_PipelineDesc* desc);
+
+// Gives back a pipeline from GBE_AcquireCachedPipeline. It stays cached when nothing's
+// using it, so asking for it again is still a hit; GBE_TrimPipelineCache lets go of those.
+// NULL is ignored.
+void GBE_ReleaseCachedPipeline(GBE_Context* context, SDL_GPUGraphicsPipeline* pipeline);
+
+// Releases every cached pipeline nobody's holding on to, and returns how many that was.
+int GBE_TrimPipelineCache(GBE_Context* context);
+
+// Writes every cached description to `path`, or reads a file like that back and creates
+// all of its pipelines, ready for the first GBE_AcquireCachedPipeline. Descriptions that
+// can't be created any more (e.g. a shader's gone, or the target format has changed) are
+// skipped. GBE_CommonInitWithConfig and GBE_Quit call these when the config names a
+// pipeline cache file.
+bool GBE_SavePipelineCache(GBE_Context* context, const char* path);
+bool GBE_PrewarmPipelineCache(GBE_Context* context, const char* path);
+
+// Prewarms from a cache file that's already been read into memory (by SDL_LoadFile, say,
+// on another thread), and frees it. `file` is NULL if there wasn't one; `path` is only
+// used for logging.
+bool GBE_PrewarmPipelineCacheFromFile(GBE_Context* context, const char* path, void* file, size_t fileSize);
+
+// Releases everything in the cache, whether or not it's still in use. GBE_Quit calls this.
+void GBE_DestroyPipelineCache(GBE_Context* context);
+
+#endif /* GBE_PipelineCache_h */
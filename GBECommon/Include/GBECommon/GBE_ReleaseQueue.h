@@ -0,0 +1,39 @@
+//
+//  GBE_ReleaseQueue.h
+//  GBECommon
+//
+//  Releasing GPU resources while the app is running. SDL's release functions
+//  are already safe to call while the GPU is using a resource (SDL hangs on to
+//  it until it's done), but that bookkeeping happens per resource, on every
+//  submit. Deferring releases until the frame that last used a resource has
+//  finished lets us release whole batches at once, at the start of a frame,
+//  without ever calling SDL_WaitForGPUIdle.
+//
+//  In debug mode, resources can also be registered when they're created, and
+//  GBE_Quit lists any that were never released.
+
+#ifndef GBE_ReleaseQueue_h
+#define GBE_ReleaseQueue_h
+
+#include "GBE_Context.h"
+
+// Registers a resource for leak reporting. `name` isn't copied, so use a string literal
+// or something else that sticks around. Does nothing unless the context was created in
+// debug mode.
+void GBE_TrackResource(GBE_Context* context, GBE_ResourceType type, void* resource, const char* name);
+
+// Releases `resource` once every frame submitted so far, and the one being recorded now,
+// has finished on the GPU. NULL is ignored, so this can be called unconditionally.
+void GBE_DeferRelease(GBE_Context* context, GBE_ResourceType type, void* resource);
+
+// Releases everything whose last frame has finished. GBE_BeginFrame calls this.
+void GBE_ProcessReleases(GBE_Context* context);
+
+// Waits for the GPU to go idle and releases everything still queued. GBE_Quit calls this.
+void GBE_FlushReleases(GBE_Context* context);
+
+// Logs every tracked resource that hasn't been released and returns how many there were.
+// GBE_Quit calls this.
+int GBE_ReportLeaks(GBE_Context* context);
+
+#endif /* GBE_ReleaseQueue_h */
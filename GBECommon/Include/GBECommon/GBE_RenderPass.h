@@ -0,0 +1,83 @@
+//
+//  GBE_RenderPass.h
+//  GBECommon
+//
+//  A thin wrapper around an SDL render pass that remembers what's bound and
+//  what uniform data was pushed last, and drops calls that wouldn't change
+//  anything. A draw loop can then bind everything each object needs without
+//  worrying about whether the last object already bound it.
+
+#ifndef GBE_RenderPass_h
+#define GBE_RenderPass_h
+
+#include "GBE_Context.h"
+
+// How many binding slots are shadowed. Bindings past these still work, they just always
+// go through to SDL.
+#define GBE_RENDER_PASS_VERTEX_BUFFERS 8
+#define GBE_RENDER_PASS_STORAGE_BUFFERS 8
+#define GBE_RENDER_PASS_UNIFORM_SLOTS 4
+
+// Uniform pushes bigger than this aren't compared; they always go through.
+#define GBE_RENDER_PASS_MAX_SHADOWED_UNIFORMS 256
+
+typedef struct GBE_ShadowedUniforms {
+    Uint32 size;
+    Uint8 data[GBE_RENDER_PASS_MAX_SHADOWED_UNIFORMS];
+} GBE_ShadowedUniforms;
+
+typedef struct GBE_RenderPass {
+    SDL_GPUCommandBuffer* commandBuffer;
+    SDL_GPURenderPass* pass;
+
+    // Turn this off (after GBE_BeginRenderPass) to send every call through, e.g. to
+    // measure what the filtering saves. The counts are kept either way.
+    bool filter;
+
+    // State-setting calls that went through to SDL and ones that were dropped, and how
+    // many draws there were.
+    Uint32 issued;
+    Uint32 skipped;
+    Uint32 draws;
+
+    // What's bound now. A NULL buffer means the slot hasn't been bound in this pass.
+    SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUBufferBinding vertexBuffers[GBE_RENDER_PASS_VERTEX_BUFFERS];
+    SDL_GPUBufferBinding indexBuffer;
+    SDL_GPUIndexElementSize indexElementSize;
+    SDL_GPUBuffer* vertexStorageBuffers[GBE_RENDER_PASS_STORAGE_BUFFERS];
+    SDL_GPUBuffer* fragmentStorageBuffers[GBE_RENDER_PASS_STORAGE_BUFFERS];
+
+    // The last data pushed to each uniform slot, while it's small enough to keep. Uniform
+    // data belongs to the command buffer and outlives pipeline changes, so binding a new
+    // pipeline doesn't clear these.
+    GBE_ShadowedUniforms vertexUniforms[GBE_RENDER_PASS_UNIFORM_SLOTS];
+    GBE_ShadowedUniforms fragmentUniforms[GBE_RENDER_PASS_UNIFORM_SLOTS];
+} GBE_RenderPass;
+
+// Begins an SDL render pass with the given targets and starts out with nothing bound.
+// Returns false, having logged why, if SDL couldn't begin the pass.
+bool GBE_BeginRenderPass(GBE_RenderPass* renderPass, SDL_GPUCommandBuffer* commandBuffer,
+    const SDL_GPUColorTargetInfo* colorTargets, Uint32 numColorTargets,
+    const SDL_GPUDepthStencilTargetInfo* depthStencilTarget);
+void GBE_EndRenderPass(GBE_RenderPass* renderPass);
+
+// Same as the SDL functions they're named after, minus anything already in place.
+void GBE_BindPipeline(GBE_RenderPass* renderPass, SDL_GPUGraphicsPipeline* pipeline);
+void GBE_BindVertexBuffers(GBE_RenderPass* renderPass, Uint32 firstSlot, const SDL_GPUBufferBinding* bindings, Uint32 numBindings);
+void GBE_BindIndexBuffer(GBE_RenderPass* renderPass, const SDL_GPUBufferBinding* binding, SDL_GPUIndexElementSize elementSize);
+void GBE_BindVertexStorageBuffers(GBE_RenderPass* renderPass, Uint32 firstSlot, SDL_GPUBuffer* const* buffers, Uint32 numBuffers);
+void GBE_BindFragmentStorageBuffers(GBE_RenderPass* renderPass, Uint32 firstSlot, SDL_GPUBuffer* const* buffers, Uint32 numBuffers);
+void GBE_PushVertexUniforms(GBE_RenderPass* renderPass, Uint32 slot, const void* data, Uint32 size);
+void GBE_PushFragmentUniforms(GBE_RenderPass* renderPass, Uint32 slot, const void* data, Uint32 size);
+
+void GBE_DrawPrimitives(GBE_RenderPass* renderPass, Uint32 numVertices, Uint32 numInstances, Uint32 firstVertex, Uint32 firstInstance);
+void GBE_DrawIndexedPrimitives(GBE_RenderPass* renderPass, Uint32 numIndices, Uint32 numInstances,
+    Uint32 firstIndex, Sint32 vertexOffset, Uint32 firstInstance);
+void GBE_DrawIndexedPrimitivesIndirect(GBE_RenderPass* renderPass, SDL_GPUBuffer* buffer, Uint32 offset, Uint32 drawCount);
+
+// Forgets everything that's bound, so the next calls all go through. Call this after
+// using renderPass->pass with SDL directly.
+void GBE_InvalidateRenderPassState(GBE_RenderPass* renderPass);
+
+#endif /* GBE_RenderPass_h */
@@ -12,9 +12,31 @@
 #include <SDL3/SDL.h>
 #include "GBE_Context.h"
 
+// A shader can come in several specialized variants, one for each combination of
+// feature bits it's been compiled with. Each feature bit turns on a preprocessor
+// define in the shader source; the combinations that actually get built are listed
+// in a manifest file that sits next to the shader (e.g. SpinningCube.vert.permutations),
+// and Tools/compile-shader-permutations.sh compiles one blob per listed variant.
+//
+// The manifest is plain text, one directive per line:
+//
+//     feature <bit> <DEFINE>   names feature bit <bit> and the define it turns on
+//     variant <mask>           a combination of feature bits to precompile
+//
+// Variant 0 is the plain shader file and is always available. Variant blobs are
+// named after their mask, so variant 0x3 of SpinningCube.vert is SpinningCube-3.vert.spv
+// (and .dxil, .msl).
+typedef Uint32 GBE_ShaderFeatures;
+
 typedef struct GBE_LoadShaderInfo {
     const char* path;
     SDL_GPUShaderStage stage;
+
+    // Which specialized variant of the shader to load. Bits that aren't named in the
+    // shader's manifest are ignored, so the same feature set can be handed to both the
+    // vertex and fragment shader of a pipeline. Leave this at 0 for the plain shader.
+    GBE_ShaderFeatures features;
+
     const char* entryPoint;
     Uint32 samplerCount;
     Uint32 uniformBufferCount;
@@ -24,4 +46,22 @@ typedef struct GBE_LoadShaderInfo {
 
 SDL_GPUShader* GBE_LoadShader(GBE_Context* context, const GBE_LoadShaderInfo* loadShaderInfo);
 
+// Compute shaders are loaded straight into a pipeline. They're named like the others,
+// with a .comp stage extension (e.g. FrustumCull.comp.spv), and the Metal versions use
+// compute_main as their entry point. The thread counts have to match the shader's.
+typedef struct GBE_LoadComputePipelineInfo {
+    const char* path;
+    Uint32 samplerCount;
+    Uint32 readonlyStorageTextureCount;
+    Uint32 readonlyStorageBufferCount;
+    Uint32 readwriteStorageTextureCount;
+    Uint32 readwriteStorageBufferCount;
+    Uint32 uniformBufferCount;
+    Uint32 threadCountX;
+    Uint32 threadCountY;
+    Uint32 threadCountZ;
+} GBE_LoadComputePipelineInfo;
+
+SDL_GPUComputePipeline* GBE_LoadComputePipeline(GBE_Context* context, const GBE_LoadComputePipelineInfo* loadInfo);
+
 #endif /* GpuByExample_Shaders_h */
@@ -0,0 +1,68 @@
+//
+//  GBE_StagingRing.h
+//  GBECommon
+//
+//  A long-lived upload transfer buffer for data that changes every frame
+//  (particles, UI, debug lines, per-instance data...), so none of it needs
+//  GPU objects created or destroyed while the app is running.
+//
+//  Each frame, space is handed out from the start of the buffer in order. The
+//  first allocation of a frame maps the buffer with cycling turned on, so if
+//  the GPU is still reading last frame's data SDL quietly swaps in another
+//  backing buffer instead of making us wait. At the end of the frame,
+//  GBE_StagingRingFlush records all of the frame's copies into a copy pass.
+
+#ifndef GBE_StagingRing_h
+#define GBE_StagingRing_h
+
+#include "GBE_Context.h"
+
+typedef struct GBE_StagingCopy {
+    Uint32 sourceOffset;
+    SDL_GPUBufferRegion destination;
+    bool cycle;
+} GBE_StagingCopy;
+
+typedef struct GBE_StagingRing {
+    SDL_GPUDevice* device;
+    SDL_GPUTransferBuffer* transferBuffer;
+    Uint32 capacity;
+
+    // Only set between the first allocation of a frame and the flush.
+    Uint8* mapped;
+    Uint32 used;
+
+    // Copies recorded this frame, waiting for the flush.
+    GBE_StagingCopy* copies;
+    int numCopies;
+    int maxCopies;
+
+    // The most bytes any single frame has used, and how many allocations didn't fit.
+    // If overflows isn't 0, the ring needs to be bigger.
+    Uint32 highWaterMark;
+    Uint64 overflows;
+} GBE_StagingRing;
+
+bool GBE_CreateStagingRing(GBE_Context* context, Uint32 capacity, GBE_StagingRing* ring);
+void GBE_DestroyStagingRing(GBE_StagingRing* ring);
+
+// Hands out `size` bytes of this frame's staging memory for the caller to write into.
+// The returned offset is what to pass to GBE_StagingRingCopy. Returns NULL if the
+// frame's run out of room.
+void* GBE_StagingRingAlloc(GBE_StagingRing* ring, Uint32 size, Uint32 alignment, Uint32* offset);
+
+// Queues a copy from staging memory (at `sourceOffset`, from GBE_StagingRingAlloc) into
+// a GPU buffer. `cycle` is passed along to SDL_UploadToGPUBuffer; turn it on when the
+// whole destination buffer gets rewritten every frame. Returns false, and queues nothing,
+// if there wasn't the memory to keep track of another copy.
+bool GBE_StagingRingCopy(GBE_StagingRing* ring, Uint32 sourceOffset, SDL_GPUBuffer* buffer, Uint32 offset, Uint32 size, bool cycle);
+
+// Allocates, copies `data` in and queues the upload all at once. Returns false if any of
+// that failed, in which case nothing's uploaded.
+bool GBE_StagingRingUpload(GBE_StagingRing* ring, const void* data, Uint32 size, SDL_GPUBuffer* buffer, Uint32 offset, bool cycle);
+
+// Unmaps the buffer and records all of this frame's copies into `copyPass`, then starts
+// the ring over for the next frame. Does nothing if nothing was allocated.
+void GBE_StagingRingFlush(GBE_StagingRing* ring, SDL_GPUCopyPass* copyPass);
+
+#endif /* GBE_StagingRing_h */
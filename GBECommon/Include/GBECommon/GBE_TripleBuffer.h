@@ -0,0 +1,51 @@
+//
+//  GBE_TripleBuffer.h
+//  GBECommon
+//
+//  Hands data from one thread to another without either of them ever waiting:
+//  say, a simulation thread passing each frame's state to the render thread.
+//
+//  There are three slots. The writer fills in one and publishes it, which
+//  swaps it with the middle slot; the reader swaps the middle slot with its own
+//  when there's something new in it. The writer always has a slot to itself to
+//  write the next one, and the reader always has the newest finished one to
+//  read. Anything published twice before the reader looks is overwritten.
+
+#ifndef GBE_TripleBuffer_h
+#define GBE_TripleBuffer_h
+
+#include <SDL3/SDL.h>
+
+typedef struct GBE_TripleBuffer {
+    Uint8* data;
+    size_t slotSize;
+
+    // The middle slot's index, plus GBE_TRIPLE_BUFFER_FRESH if it's been published and
+    // not read yet. The other two indices belong to one side each.
+    SDL_AtomicInt middle;
+    int writeSlot;
+    int readSlot;
+
+    // Publishes (counted by the writer), and how many of those were overwritten before the
+    // reader saw them.
+    Uint64 published;
+    Uint64 overwritten;
+} GBE_TripleBuffer;
+
+#define GBE_TRIPLE_BUFFER_FRESH 4
+
+// Three zeroed slots of `slotSize` bytes each.
+bool GBE_CreateTripleBuffer(size_t slotSize, GBE_TripleBuffer* buffer);
+void GBE_DestroyTripleBuffer(GBE_TripleBuffer* buffer);
+
+// Writer side: the slot to fill in next, and handing it over once it's ready. The slot
+// returned after publishing is a different one, holding whatever was last written to it.
+void* GBE_GetTripleBufferWriteSlot(GBE_TripleBuffer* buffer);
+void GBE_PublishTripleBuffer(GBE_TripleBuffer* buffer);
+
+// Reader side: the newest published slot, which stays put until the next call. `fresh`,
+// if not NULL, says whether it's one this hasn't returned before. Before anything's been
+// published, this is one of the zeroed slots.
+const void* GBE_ReadTripleBuffer(GBE_TripleBuffer* buffer, bool* fresh);
+
+#endif /* GBE_TripleBuffer_h */
@@ -0,0 +1,35 @@
+//
+//  GBE_Upload.h
+//  GBECommon
+//
+//  Getting data into GPU buffers.
+
+#ifndef GBE_Upload_h
+#define GBE_Upload_h
+
+#include "GBE_Context.h"
+
+// Each upload's data starts on a multiple of this many bytes within the transfer buffer.
+#define GBE_UPLOAD_ALIGNMENT 16
+
+typedef struct GBE_BufferUpload {
+    const void* data;
+    Uint32 size;
+    SDL_GPUBufferUsageFlags usage;
+
+    // Set this to copy into a buffer that already exists (a GBE_BufferArena's, say)
+    // instead of creating a new one. usage is ignored then.
+    SDL_GPUBuffer* destination;
+    Uint32 destinationOffset;
+
+    // Filled in with the newly created buffer, or destination if there was one.
+    SDL_GPUBuffer* buffer;
+} GBE_BufferUpload;
+
+// Creates a GPU buffer for each upload (unless it has a destination) and copies its data
+// in. However many uploads there are, this only makes one transfer buffer, records one
+// copy pass and submits one command buffer. If anything fails, no buffers it created are
+// left behind.
+bool GBE_UploadBuffers(GBE_Context* context, GBE_BufferUpload* uploads, int count);
+
+#endif /* GBE_Upload_h */
@@ -0,0 +1,93 @@
+//
+//  GBE_UploadQueue.h
+//  GBECommon
+//
+//  Streams data into GPU buffers in the background while the app keeps
+//  rendering. GBE_UploadBuffers waits for nothing, but it also can't tell you
+//  when the data has actually arrived, and a big upload all lands in one frame.
+//
+//  Uploads queued here go out a little at a time: each call to
+//  GBE_PumpUploadQueue (once per frame) copies at most bytesPerFrame worth of
+//  data into a transfer buffer and submits it with a fence, splitting larger
+//  uploads across frames. The next pumps check those fences without waiting on
+//  them; once one has signaled, its transfer buffer goes back in the pool and
+//  the callbacks for uploads that finished in it are called.
+
+#ifndef GBE_UploadQueue_h
+#define GBE_UploadQueue_h
+
+#include "GBE_Context.h"
+
+// How many submissions can be in flight at once. If they all are, pumping just
+// checks their fences and waits for the next frame rather than stalling.
+#define GBE_UPLOAD_QUEUE_MAX_BATCHES 4
+
+// Called from GBE_PumpUploadQueue once the GPU has the data. `succeeded` is false if
+// the queue was destroyed before the upload was submitted. (A submission that fails is
+// tried again on the next pump.)
+typedef void (*GBE_UploadCallback)(void* userdata, SDL_GPUBuffer* buffer, Uint32 offset, Uint32 size, bool succeeded);
+
+typedef struct GBE_QueuedUpload {
+    const void* data;
+    SDL_GPUBuffer* buffer;
+    Uint32 offset;
+    Uint32 size;
+    GBE_UploadCallback callback;
+    void* userdata;
+
+    // How much has been copied to a transfer buffer so far, and which batch the final
+    // piece went out in.
+    Uint32 submitted;
+    int batch;
+} GBE_QueuedUpload;
+
+typedef struct GBE_UploadBatch {
+    SDL_GPUTransferBuffer* transferBuffer;
+    SDL_GPUFence* fence;
+} GBE_UploadBatch;
+
+typedef struct GBE_UploadQueue {
+    SDL_GPUDevice* device;
+    Uint32 bytesPerFrame;
+
+    // Each batch keeps its transfer buffer between submissions; it's only written to
+    // again after its fence says the GPU is done reading it.
+    GBE_UploadBatch batches[GBE_UPLOAD_QUEUE_MAX_BATCHES];
+
+    // Uploads not fully submitted yet, oldest first.
+    GBE_QueuedUpload* pending;
+    int numPending;
+    int maxPending;
+
+    // Uploads fully submitted, waiting on their batch's fence.
+    GBE_QueuedUpload* waiting;
+    int numWaiting;
+    int maxWaiting;
+
+    // Running totals: bytes sent to the GPU, and pumps that had data to send but every
+    // batch was still in flight. If stalls keeps climbing, the budget's too small.
+    Uint64 bytesUploaded;
+    Uint64 stalls;
+} GBE_UploadQueue;
+
+bool GBE_CreateUploadQueue(GBE_Context* context, Uint32 bytesPerFrame, GBE_UploadQueue* queue);
+
+// Waits for anything in flight to finish (calling those callbacks as usual), then drops
+// whatever hasn't been submitted yet, calling its callbacks with succeeded = false.
+void GBE_DestroyUploadQueue(GBE_UploadQueue* queue);
+
+// Queues `size` bytes of `data` to be copied into `buffer` at `offset`. Nothing is
+// copied here, so `data` has to stay put until the callback is called.
+bool GBE_QueueUpload(GBE_UploadQueue* queue, const void* data, Uint32 size, SDL_GPUBuffer* buffer, Uint32 offset, GBE_UploadCallback callback, void* userdata);
+
+// Call once per frame. Calls the callbacks for anything that's finished, then submits
+// up to bytesPerFrame of what's still pending.
+void GBE_PumpUploadQueue(GBE_UploadQueue* queue);
+
+// Submits everything left and blocks until the GPU has all of it. For load screens.
+void GBE_FlushUploadQueue(GBE_UploadQueue* queue);
+
+// True while anything is pending or in flight.
+bool GBE_UploadQueueBusy(const GBE_UploadQueue* queue);
+
+#endif /* GBE_UploadQueue_h */
@@ -139,7 +139,7 @@ GBE_Matrix4x4 GBE_Matrix4x4Translation(GBE_Vector3 t)
     return (GBE_Matrix4x4) {
         1, 0, 0, 0,
         0, 1, 0, 0,
-        0, 0, 0, 1,
+        0, 0, 1, 0,
         t.x, t.y, t.z, 1
     };
 }
@@ -207,3 +207,49 @@ GBE_Matrix4x4 GBE_Matrix4x4Transpose(GBE_Matrix4x4 m)
         m.m14, m.m24, m.m34, m.m44
     };
 }
+
+// With vectors multiplied on the left (v * m), each clip space coordinate is the dot
+// product of the vector with one of the matrix's columns, so each plane falls out of
+// adding or subtracting columns. SDL's clip space has 0 <= z <= w.
+GBE_Frustum GBE_FrustumFromMatrix(GBE_Matrix4x4 m)
+{
+    GBE_Vector4 x = { m.m11, m.m21, m.m31, m.m41 };
+    GBE_Vector4 y = { m.m12, m.m22, m.m32, m.m42 };
+    GBE_Vector4 z = { m.m13, m.m23, m.m33, m.m43 };
+    GBE_Vector4 w = { m.m14, m.m24, m.m34, m.m44 };
+
+    GBE_Frustum frustum = {{
+        { w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w }, // left
+        { w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w }, // right
+        { w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w }, // bottom
+        { w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w }, // top
+        { z.x, z.y, z.z, z.w },                         // near
+        { w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w }  // far
+    }};
+
+    // Normalized planes give real distances, so spheres can be tested with their radius.
+    for (int i = 0; i < 6; i++) {
+        GBE_Vector4* plane = &frustum.planes[i];
+        float length = sqrtf(plane->x * plane->x + plane->y * plane->y + plane->z * plane->z);
+        if (length > 0.0f) {
+            plane->x /= length;
+            plane->y /= length;
+            plane->z /= length;
+            plane->w /= length;
+        }
+    }
+
+    return frustum;
+}
+
+bool GBE_FrustumIntersectsSphere(GBE_Frustum frustum, GBE_Vector3 center, float radius)
+{
+    for (int i = 0; i < 6; i++) {
+        GBE_Vector4 plane = frustum.planes[i];
+        if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) {
+            return false;
+        }
+    }
+
+    return true;
+}
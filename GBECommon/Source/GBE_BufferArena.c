@@ -0,0 +1,304 @@
+//
+//  GBE_BufferArena.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_BufferArena.h>
+
+// What's going on at the start of each minimum-sized chunk of the buffer.
+enum {
+    BLOCK_NONE = 0, // not the start of a block
+    BLOCK_FREE,
+    BLOCK_USED
+};
+
+static Uint32 BlockBytes(int order)
+{
+    return (Uint32)GBE_ARENA_MIN_BLOCK_SIZE << order;
+}
+
+static int OrderForSize(Uint32 size)
+{
+    Uint32 chunks = (size + GBE_ARENA_MIN_BLOCK_SIZE - 1) / GBE_ARENA_MIN_BLOCK_SIZE;
+    int order = 0;
+    while ((1u << order) < chunks) {
+        order++;
+    }
+    return order;
+}
+
+static void PushFree(GBE_BufferArena* arena, Sint32 block, int order)
+{
+    arena->blockState[block] = BLOCK_FREE;
+    arena->blockOrder[block] = (Uint8)order;
+    arena->prevFree[block] = -1;
+    arena->nextFree[block] = arena->freeLists[order];
+    if (arena->freeLists[order] >= 0) {
+        arena->prevFree[arena->freeLists[order]] = block;
+    }
+    arena->freeLists[order] = block;
+}
+
+static void RemoveFree(GBE_BufferArena* arena, Sint32 block)
+{
+    int order = arena->blockOrder[block];
+    Sint32 prev = arena->prevFree[block];
+    Sint32 next = arena->nextFree[block];
+
+    if (prev >= 0) {
+        arena->nextFree[prev] = next;
+    }
+    else {
+        arena->freeLists[order] = next;
+    }
+
+    if (next >= 0) {
+        arena->prevFree[next] = prev;
+    }
+
+    arena->blockState[block] = BLOCK_NONE;
+}
+
+static void ResetBlocks(GBE_BufferArena* arena)
+{
+    Uint32 numChunks = arena->capacity / GBE_ARENA_MIN_BLOCK_SIZE;
+    SDL_memset(arena->blockState, BLOCK_NONE, numChunks);
+    for (int i = 0; i < GBE_ARENA_MAX_ORDERS; i++) {
+        arena->freeLists[i] = -1;
+    }
+
+    PushFree(arena, 0, arena->maxOrder);
+    arena->bytesInUse = 0;
+    arena->numAllocations = 0;
+}
+
+// Finds the smallest free block that's big enough, splitting bigger ones in half until
+// it's the right size. Returns the block's chunk index, or -1 if nothing fits.
+static Sint32 AllocBlock(GBE_BufferArena* arena, int order)
+{
+    int available = order;
+    while (available <= arena->maxOrder && arena->freeLists[available] < 0) {
+        available++;
+    }
+    if (available > arena->maxOrder) {
+        return -1;
+    }
+
+    Sint32 block = arena->freeLists[available];
+    RemoveFree(arena, block);
+
+    // Every split leaves the upper half free for someone else.
+    while (available > order) {
+        available--;
+        PushFree(arena, block + (1 << available), available);
+    }
+
+    arena->blockState[block] = BLOCK_USED;
+    arena->blockOrder[block] = (Uint8)order;
+    arena->bytesInUse += BlockBytes(order);
+    arena->numAllocations++;
+    return block;
+}
+
+static void FreeBlock(GBE_BufferArena* arena, Sint32 block)
+{
+    int order = arena->blockOrder[block];
+    arena->bytesInUse -= BlockBytes(order);
+    arena->numAllocations--;
+
+    // Merge with our buddy for as long as it's free too.
+    while (order < arena->maxOrder) {
+        Sint32 buddy = block ^ (1 << order);
+        if (arena->blockState[buddy] != BLOCK_FREE || arena->blockOrder[buddy] != order) {
+            break;
+        }
+
+        RemoveFree(arena, buddy);
+        arena->blockState[block] = BLOCK_NONE;
+        block = SDL_min(block, buddy);
+        order++;
+    }
+
+    PushFree(arena, block, order);
+}
+
+// Fills in where a range's data lives, given the block backing it.
+static void PlaceRange(GBE_BufferRange* range, Sint32 block)
+{
+    Uint32 blockOffset = (Uint32)block * GBE_ARENA_MIN_BLOCK_SIZE;
+    range->block = (Uint32)block;
+    range->offset = (blockOffset + range->stride - 1) / range->stride * range->stride;
+    range->firstElement = range->offset / range->stride;
+}
+
+bool GBE_CreateBufferArena(GBE_Context* context, SDL_GPUBufferUsageFlags usage, Uint32 capacity, GBE_BufferArena* arena)
+{
+    SDL_assert(context != NULL);
+
+    if (!GBE_CreateBufferArenaBlocks(capacity, arena)) {
+        return false;
+    }
+
+    arena->device = context->device;
+    arena->usage = usage;
+
+    SDL_GPUBufferCreateInfo createInfo = {
+        .usage = usage,
+        .size = arena->capacity
+    };
+    arena->buffer = SDL_CreateGPUBuffer(context->device, &createInfo);
+    if (arena->buffer == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create buffer arena: %s", SDL_GetError());
+        GBE_DestroyBufferArena(arena);
+        return false;
+    }
+
+    return true;
+}
+
+bool GBE_CreateBufferArenaBlocks(Uint32 capacity, GBE_BufferArena* arena)
+{
+    SDL_assert(arena != NULL);
+
+    SDL_zerop(arena);
+
+    int maxOrder = OrderForSize(SDL_max(capacity, 1));
+    if (maxOrder >= GBE_ARENA_MAX_ORDERS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "A %u byte buffer arena is too big.", capacity);
+        return false;
+    }
+
+    arena->maxOrder = maxOrder;
+    arena->capacity = BlockBytes(maxOrder);
+
+    Uint32 numChunks = arena->capacity / GBE_ARENA_MIN_BLOCK_SIZE;
+    arena->blockOrder = SDL_malloc(numChunks);
+    arena->blockState = SDL_malloc(numChunks);
+    arena->nextFree = SDL_malloc(sizeof(Sint32) * numChunks);
+    arena->prevFree = SDL_malloc(sizeof(Sint32) * numChunks);
+    if (arena->blockOrder == NULL || arena->blockState == NULL || arena->nextFree == NULL || arena->prevFree == NULL) {
+        GBE_DestroyBufferArena(arena);
+        return false;
+    }
+
+    ResetBlocks(arena);
+    return true;
+}
+
+void GBE_DestroyBufferArena(GBE_BufferArena* arena)
+{
+    if (arena->buffer != NULL) {
+        SDL_ReleaseGPUBuffer(arena->device, arena->buffer);
+    }
+
+    SDL_free(arena->blockOrder);
+    SDL_free(arena->blockState);
+    SDL_free(arena->nextFree);
+    SDL_free(arena->prevFree);
+    SDL_zerop(arena);
+}
+
+bool GBE_BufferArenaAlloc(GBE_BufferArena* arena, Uint32 count, Uint32 stride, GBE_BufferRange* range)
+{
+    SDL_assert(stride > 0);
+
+    // Blocks always start on a multiple of the minimum block size. If the stride doesn't
+    // divide evenly into that, leave room to slide the data up to the next multiple of it.
+    Uint64 size = (Uint64)count * stride;
+    Uint64 padding = GBE_ARENA_MIN_BLOCK_SIZE % stride != 0 ? stride - 1 : 0;
+    if (size + padding > arena->capacity) {
+        return false;
+    }
+
+    Sint32 block = AllocBlock(arena, OrderForSize((Uint32)(size + padding)));
+    if (block < 0) {
+        return false;
+    }
+
+    range->size = (Uint32)size;
+    range->stride = stride;
+    PlaceRange(range, block);
+    return true;
+}
+
+void GBE_BufferArenaFree(GBE_BufferArena* arena, GBE_BufferRange* range)
+{
+    SDL_assert(arena->blockState[range->block] == BLOCK_USED);
+
+    FreeBlock(arena, (Sint32)range->block);
+    SDL_zerop(range);
+}
+
+typedef struct LiveRange {
+    GBE_BufferRange* range;
+    int order;
+} LiveRange;
+
+// Biggest blocks first: placing them in that order leaves no gaps at all.
+static int SDLCALL CompareLiveRanges(const void* a, const void* b)
+{
+    const LiveRange* left = (const LiveRange*)a;
+    const LiveRange* right = (const LiveRange*)b;
+    if (left->order != right->order) {
+        return right->order - left->order;
+    }
+    return left->range->block < right->range->block ? -1 : left->range->block > right->range->block;
+}
+
+bool GBE_DefragmentBufferArena(GBE_BufferArena* arena, SDL_GPUCopyPass* copyPass, GBE_BufferRange** ranges, int count)
+{
+    if ((Uint32)count != arena->numAllocations) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Defragmenting needs all %u live ranges, but was given %d.", arena->numAllocations, count);
+        return false;
+    }
+
+    LiveRange* live = SDL_malloc(sizeof(LiveRange) * SDL_max(count, 1));
+    if (live == NULL) {
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        live[i].range = ranges[i];
+        live[i].order = arena->blockOrder[ranges[i]->block];
+    }
+    SDL_qsort(live, count, sizeof(LiveRange), CompareLiveRanges);
+
+    SDL_GPUBufferCreateInfo createInfo = {
+        .usage = arena->usage,
+        .size = arena->capacity
+    };
+    SDL_GPUBuffer* newBuffer = SDL_CreateGPUBuffer(arena->device, &createInfo);
+    if (newBuffer == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create buffer for defragmenting: %s", SDL_GetError());
+        SDL_free(live);
+        return false;
+    }
+
+    // Start the book-keeping over from scratch and place everything again, copying each
+    // range's contents from where it was to where it's going.
+    ResetBlocks(arena);
+    for (int i = 0; i < count; i++) {
+        GBE_BufferRange* range = live[i].range;
+        SDL_GPUBufferLocation source = {
+            .buffer = arena->buffer,
+            .offset = range->offset
+        };
+
+        Sint32 block = AllocBlock(arena, live[i].order);
+        SDL_assert(block >= 0);
+        PlaceRange(range, block);
+
+        SDL_GPUBufferLocation destination = {
+            .buffer = newBuffer,
+            .offset = range->offset
+        };
+        SDL_CopyGPUBufferToBuffer(copyPass, &source, &destination, range->size, false);
+    }
+
+    // SDL keeps the old buffer alive until the copies out of it are done.
+    SDL_ReleaseGPUBuffer(arena->device, arena->buffer);
+    arena->buffer = newBuffer;
+
+    SDL_free(live);
+    return true;
+}
@@ -0,0 +1,396 @@
+//
+//  GBE_DrawList.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_DrawList.h>
+
+// Uniform data for each draw starts on a 16 byte boundary, the strictest alignment
+// uniform data can ask for.
+#define GBE_DRAW_UNIFORM_ALIGNMENT 16
+
+Uint64 GBE_MakeDrawKey(Uint32 layer, Uint32 pipeline, Uint32 material, float depth, bool backToFront)
+{
+    // Non-negative floats sort the same way as their bit patterns do as integers.
+    Uint32 depthBits;
+    depth = SDL_max(depth, 0.0f);
+    SDL_memcpy(&depthBits, &depth, sizeof(depthBits));
+    if (backToFront) {
+        depthBits = ~depthBits;
+    }
+
+    return ((Uint64)(layer & 0xf) << 60) | ((Uint64)(pipeline & 0xfff) << 48) |
+        ((Uint64)(material & 0xffff) << 32) | depthBits;
+}
+
+bool GBE_CreateDrawList(Uint32 maxPackets, Uint32 uniformsCapacity, GBE_DrawList* list)
+{
+    SDL_assert(list != NULL);
+
+    SDL_zerop(list);
+    maxPackets = SDL_max(maxPackets, 16);
+    uniformsCapacity = SDL_max(uniformsCapacity, 1024);
+
+    list->packets = SDL_malloc(sizeof(GBE_DrawPacket) * maxPackets);
+    list->order = SDL_malloc(sizeof(GBE_DrawSortEntry) * maxPackets);
+    list->scratch = SDL_malloc(sizeof(GBE_DrawSortEntry) * maxPackets);
+    list->uniforms = SDL_malloc(uniformsCapacity);
+    if (list->packets == NULL || list->order == NULL || list->scratch == NULL || list->uniforms == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory creating a draw list for %u draws.", maxPackets);
+        GBE_DestroyDrawList(list);
+        return false;
+    }
+
+    list->maxPackets = maxPackets;
+    list->uniformsCapacity = uniformsCapacity;
+    return true;
+}
+
+void GBE_DestroyDrawList(GBE_DrawList* list)
+{
+    SDL_free(list->packets);
+    SDL_free(list->order);
+    SDL_free(list->scratch);
+    SDL_free(list->uniforms);
+    SDL_free(list->commands);
+    SDL_zerop(list);
+}
+
+void GBE_ResetDrawList(GBE_DrawList* list)
+{
+    list->numPackets = 0;
+    list->uniformsUsed = 0;
+    list->sorted = false;
+    list->baked = false;
+    list->numCommands = 0;
+}
+
+static bool GrowPackets(GBE_DrawList* list)
+{
+    Uint32 maxPackets = list->maxPackets * 2;
+    GBE_DrawPacket* packets = SDL_realloc(list->packets, sizeof(GBE_DrawPacket) * maxPackets);
+    if (packets == NULL) {
+        return false;
+    }
+    list->packets = packets;
+
+    GBE_DrawSortEntry* order = SDL_realloc(list->order, sizeof(GBE_DrawSortEntry) * maxPackets);
+    if (order == NULL) {
+        return false;
+    }
+    list->order = order;
+
+    // The scratch array is only used during a sort, so there's nothing in it worth copying.
+    GBE_DrawSortEntry* scratch = SDL_malloc(sizeof(GBE_DrawSortEntry) * maxPackets);
+    if (scratch == NULL) {
+        return false;
+    }
+    SDL_free(list->scratch);
+    list->scratch = scratch;
+    list->maxPackets = maxPackets;
+    return true;
+}
+
+static bool GrowUniforms(GBE_DrawList* list, Uint32 needed)
+{
+    Uint32 capacity = list->uniformsCapacity;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    Uint8* uniforms = SDL_realloc(list->uniforms, capacity);
+    if (uniforms == NULL) {
+        return false;
+    }
+    list->uniforms = uniforms;
+    list->uniformsCapacity = capacity;
+    return true;
+}
+
+bool GBE_AddDraw(GBE_DrawList* list, const GBE_DrawPacket* packet, const void* uniforms, Uint32 uniformSize)
+{
+    if (list->numPackets == list->maxPackets && !GrowPackets(list)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory growing a draw list past %u draws.", list->maxPackets);
+        return false;
+    }
+
+    Uint32 uniformOffset = 0;
+    if (uniforms == NULL) {
+        uniformSize = 0;
+    }
+    if (uniformSize > 0) {
+        uniformOffset = (list->uniformsUsed + GBE_DRAW_UNIFORM_ALIGNMENT - 1) & ~(Uint32)(GBE_DRAW_UNIFORM_ALIGNMENT - 1);
+        if (uniformOffset + uniformSize > list->uniformsCapacity && !GrowUniforms(list, uniformOffset + uniformSize)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory growing a draw list's uniform data.");
+            return false;
+        }
+        SDL_memcpy(list->uniforms + uniformOffset, uniforms, uniformSize);
+        list->uniformsUsed = uniformOffset + uniformSize;
+    }
+
+    GBE_DrawPacket* added = &list->packets[list->numPackets];
+    *added = *packet;
+    added->uniformOffset = uniformOffset;
+    added->uniformSize = uniformSize;
+
+    list->order[list->numPackets] = (GBE_DrawSortEntry) { .key = packet->key, .packet = list->numPackets };
+    list->numPackets++;
+    list->sorted = false;
+    list->baked = false;
+    return true;
+}
+
+void GBE_SortDrawList(GBE_DrawList* list)
+{
+    Uint32 count = list->numPackets;
+    if (list->sorted || count < 2) {
+        list->sorted = true;
+        return;
+    }
+
+    // Least significant byte first, one counting sort per byte; each pass is stable, so
+    // the whole thing is. All eight histograms are built in one read of the keys, and
+    // bytes every key agrees on (usually the layer, often the pipeline) skip their pass.
+    Uint32 histograms[8][256];
+    SDL_zeroa(histograms);
+    for (Uint32 i = 0; i < count; i++) {
+        Uint64 key = list->order[i].key;
+        for (int byte = 0; byte < 8; byte++) {
+            histograms[byte][(key >> (byte * 8)) & 0xff]++;
+        }
+    }
+
+    GBE_DrawSortEntry* source = list->order;
+    GBE_DrawSortEntry* destination = list->scratch;
+    for (int byte = 0; byte < 8; byte++) {
+        Uint32* histogram = histograms[byte];
+        if (histogram[(source[0].key >> (byte * 8)) & 0xff] == count) {
+            continue;
+        }
+
+        Uint32 offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            Uint32 bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for (Uint32 i = 0; i < count; i++) {
+            Uint32 bucket = (Uint32)(source[i].key >> (byte * 8)) & 0xff;
+            destination[histogram[bucket]++] = source[i];
+        }
+
+        GBE_DrawSortEntry* swap = source;
+        source = destination;
+        destination = swap;
+    }
+
+    // An odd number of passes leaves the result in the scratch array; swap the two so
+    // `order` always has it.
+    list->scratch = destination;
+    list->order = source;
+    list->sorted = true;
+}
+
+// Plays back a baked list's commands straight into SDL. The render pass's record of what's
+// bound isn't kept up to date along the way, so it's cleared at the end.
+static void ReplayCommands(const GBE_DrawList* list, GBE_RenderPass* renderPass)
+{
+    for (Uint32 i = 0; i < list->numCommands; i++) {
+        const GBE_DrawCommand* command = &list->commands[i];
+        const GBE_DrawPacket* packet = &list->packets[command->packet];
+
+        switch (command->type) {
+            case GBE_DRAW_COMMAND_BIND_PIPELINE:
+                SDL_BindGPUGraphicsPipeline(renderPass->pass, packet->pipeline);
+                break;
+            case GBE_DRAW_COMMAND_BIND_VERTEX_BUFFER:
+                SDL_BindGPUVertexBuffers(renderPass->pass, 0, &packet->vertexBuffer, 1);
+                break;
+            case GBE_DRAW_COMMAND_BIND_INDEX_BUFFER:
+                SDL_BindGPUIndexBuffer(renderPass->pass, &packet->indexBuffer, packet->indexElementSize);
+                break;
+            case GBE_DRAW_COMMAND_BIND_STORAGE_BUFFER:
+                SDL_BindGPUVertexStorageBuffers(renderPass->pass, 0, &packet->storageBuffer, 1);
+                break;
+            case GBE_DRAW_COMMAND_PUSH_UNIFORMS:
+                SDL_PushGPUVertexUniformData(renderPass->commandBuffer, 0, list->uniforms + packet->uniformOffset, packet->uniformSize);
+                break;
+            case GBE_DRAW_COMMAND_DRAW:
+                if (packet->indexBuffer.buffer != NULL) {
+                    SDL_DrawGPUIndexedPrimitives(renderPass->pass, packet->count, packet->numInstances, packet->first, packet->vertexOffset, 0);
+                }
+                else {
+                    SDL_DrawGPUPrimitives(renderPass->pass, packet->count, packet->numInstances, packet->first, 0);
+                }
+                renderPass->draws++;
+                continue;
+        }
+        renderPass->issued++;
+    }
+
+    renderPass->skipped += list->bakedSkipped;
+    GBE_InvalidateRenderPassState(renderPass);
+}
+
+void GBE_ReplayDrawList(const GBE_DrawList* list, GBE_RenderPass* renderPass)
+{
+    // With filtering off, every call is meant to go through, which the baked commands
+    // don't do.
+    if (list->baked && renderPass->filter) {
+        ReplayCommands(list, renderPass);
+        return;
+    }
+
+    GBE_ReplayDrawListRange(list, renderPass, 0, list->numPackets);
+}
+
+void GBE_ReplayDrawListRange(const GBE_DrawList* list, GBE_RenderPass* renderPass, Uint32 first, Uint32 count)
+{
+    Uint32 end = first + SDL_min(count, list->numPackets - SDL_min(first, list->numPackets));
+    for (Uint32 i = first; i < end; i++) {
+        const GBE_DrawPacket* packet = &list->packets[list->order[i].packet];
+
+        GBE_BindPipeline(renderPass, packet->pipeline);
+        GBE_BindVertexBuffers(renderPass, 0, &packet->vertexBuffer, 1);
+        if (packet->storageBuffer != NULL) {
+            GBE_BindVertexStorageBuffers(renderPass, 0, &packet->storageBuffer, 1);
+        }
+        if (packet->uniformSize > 0) {
+            GBE_PushVertexUniforms(renderPass, 0, list->uniforms + packet->uniformOffset, packet->uniformSize);
+        }
+
+        if (packet->indexBuffer.buffer != NULL) {
+            GBE_BindIndexBuffer(renderPass, &packet->indexBuffer, packet->indexElementSize);
+            GBE_DrawIndexedPrimitives(renderPass, packet->count, packet->numInstances, packet->first, packet->vertexOffset, 0);
+        }
+        else {
+            GBE_DrawPrimitives(renderPass, packet->count, packet->numInstances, packet->first, 0);
+        }
+    }
+}
+
+bool GBE_BeginStaticDrawList(GBE_DrawList* list, Uint64 stamp)
+{
+    list->isStatic = true;
+    if (list->baked && list->stamp == stamp) {
+        return false;
+    }
+
+    GBE_ResetDrawList(list);
+    list->stamp = stamp;
+    return true;
+}
+
+static bool AddCommand(GBE_DrawList* list, GBE_DrawCommandType type, Uint32 packet)
+{
+    if (list->numCommands == list->maxCommands) {
+        Uint32 maxCommands = SDL_max(list->maxCommands * 2, list->numPackets * 2);
+        GBE_DrawCommand* commands = SDL_realloc(list->commands, sizeof(GBE_DrawCommand) * maxCommands);
+        if (commands == NULL) {
+            return false;
+        }
+        list->commands = commands;
+        list->maxCommands = maxCommands;
+    }
+
+    list->commands[list->numCommands++] = (GBE_DrawCommand) { .type = type, .packet = packet };
+    return true;
+}
+
+bool GBE_BakeDrawList(GBE_DrawList* list)
+{
+    GBE_SortDrawList(list);
+    list->numCommands = 0;
+    list->bakedSkipped = 0;
+    list->baked = false;
+
+    // The same comparisons GBE_RenderPass makes, made once here instead of every frame.
+    // The first packet is compared against nothing, so it binds everything it uses.
+    const GBE_DrawPacket* previous = NULL;
+    const GBE_DrawPacket* storage = NULL;
+    const GBE_DrawPacket* indexed = NULL;
+    const GBE_DrawPacket* pushed = NULL;
+    bool ok = true;
+    for (Uint32 i = 0; i < list->numPackets && ok; i++) {
+        Uint32 index = list->order[i].packet;
+        const GBE_DrawPacket* packet = &list->packets[index];
+
+        if (previous == NULL || packet->pipeline != previous->pipeline) {
+            ok = ok && AddCommand(list, GBE_DRAW_COMMAND_BIND_PIPELINE, index);
+        }
+        else {
+            list->bakedSkipped++;
+        }
+
+        if (previous == NULL || packet->vertexBuffer.buffer != previous->vertexBuffer.buffer ||
+            packet->vertexBuffer.offset != previous->vertexBuffer.offset) {
+            ok = ok && AddCommand(list, GBE_DRAW_COMMAND_BIND_VERTEX_BUFFER, index);
+        }
+        else {
+            list->bakedSkipped++;
+        }
+
+        if (packet->storageBuffer != NULL) {
+            if (storage == NULL || packet->storageBuffer != storage->storageBuffer) {
+                ok = ok && AddCommand(list, GBE_DRAW_COMMAND_BIND_STORAGE_BUFFER, index);
+                storage = packet;
+            }
+            else {
+                list->bakedSkipped++;
+            }
+        }
+
+        if (packet->uniformSize > 0) {
+            if (pushed == NULL || pushed->uniformSize != packet->uniformSize ||
+                SDL_memcmp(list->uniforms + pushed->uniformOffset, list->uniforms + packet->uniformOffset, packet->uniformSize) != 0) {
+                ok = ok && AddCommand(list, GBE_DRAW_COMMAND_PUSH_UNIFORMS, index);
+                pushed = packet;
+            }
+            else {
+                list->bakedSkipped++;
+            }
+        }
+
+        if (packet->indexBuffer.buffer != NULL) {
+            if (indexed == NULL || packet->indexBuffer.buffer != indexed->indexBuffer.buffer ||
+                packet->indexBuffer.offset != indexed->indexBuffer.offset || packet->indexElementSize != indexed->indexElementSize) {
+                ok = ok && AddCommand(list, GBE_DRAW_COMMAND_BIND_INDEX_BUFFER, index);
+                indexed = packet;
+            }
+            else {
+                list->bakedSkipped++;
+            }
+        }
+
+        ok = ok && AddCommand(list, GBE_DRAW_COMMAND_DRAW, index);
+        previous = packet;
+    }
+
+    if (!ok) {
+        // Replay still works without the commands, it just doesn't save anything.
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory baking a draw list of %u draws.", list->numPackets);
+        list->numCommands = 0;
+        return false;
+    }
+
+    list->baked = true;
+    return true;
+}
+
+void GBE_InvalidateDrawList(GBE_DrawList* list)
+{
+    list->baked = false;
+}
+
+Uint64 GBE_HashStamp(Uint64 stamp, const void* data, size_t size)
+{
+    // FNV-1a, starting from its offset basis rather than 0.
+    const Uint8* bytes = data;
+    stamp ^= 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        stamp ^= bytes[i];
+        stamp *= 0x100000001b3ull;
+    }
+    return stamp;
+}
@@ -0,0 +1,514 @@
+//
+//  GBE_Frame.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_Frame.h>
+#include <GBECommon/GBE_ReleaseQueue.h>
+
+// Releases the fences of frames the GPU has finished and advances completedFrames past
+// them. Frames finish in the order they were submitted, so stop at the first one that
+// hasn't. With `wait`, blocks until at least the oldest outstanding frame is done.
+static void RetireFrames(GBE_Context* context, bool wait)
+{
+    GBE_FrameFences* frameFences = &context->frameFences;
+    while (frameFences->completedFrames < context->frameNumber) {
+        SDL_GPUFence** fence = &frameFences->fences[frameFences->completedFrames % GBE_MAX_FRAME_FENCES];
+        if (*fence != NULL) {
+            if (wait) {
+                SDL_WaitForGPUFences(context->device, true, fence, 1);
+                wait = false;
+            }
+            else if (!SDL_QueryGPUFence(context->device, *fence)) {
+                break;
+            }
+
+            SDL_ReleaseGPUFence(context->device, *fence);
+            *fence = NULL;
+        }
+
+        frameFences->completedFrames++;
+    }
+}
+
+// Records how long it took from input arriving to the GPU finishing the frame that
+// reacted to it, for any such frames that have finished. Fences are only checked here,
+// at the start of a frame, so that's as close as we get to when the GPU finished: each
+// sample is an upper bound.
+static void CollectLatencySamples(GBE_Context* context)
+{
+    GBE_FrameStats* stats = &context->stats;
+    for (int i = 0; i < GBE_MAX_LATENCY_PROBES; i++) {
+        if (stats->latencyFrames[i] == 0 || stats->latencyFrames[i] > context->frameFences.completedFrames) {
+            continue;
+        }
+
+        stats->latencyTotalNS += SDL_GetTicksNS() - stats->latencyInputNS[i];
+        stats->latencySamples++;
+        stats->latencyFrames[i] = 0;
+    }
+}
+
+// Marks the frame about to be submitted as one to measure input latency with, if
+// there's input waiting and a free probe.
+static void StartLatencyProbe(GBE_Context* context)
+{
+    GBE_FrameStats* stats = &context->stats;
+    if (!stats->enabled || stats->pendingInputNS == 0) {
+        return;
+    }
+
+    for (int i = 0; i < GBE_MAX_LATENCY_PROBES; i++) {
+        if (stats->latencyFrames[i] == 0) {
+            stats->latencyFrames[i] = context->frameNumber + 1;
+            stats->latencyInputNS[i] = stats->pendingInputNS;
+            stats->pendingInputNS = 0;
+            return;
+        }
+    }
+}
+
+// Makes sure there's a depth buffer matching the frame's target, replacing the old one
+// if the target's been resized. Frames still in flight may be using the old one, so it
+// goes through the release queue rather than straight away.
+static bool PrepareDepthTarget(GBE_Context* context, GBE_Frame* frame)
+{
+    if (!context->useDepthTarget || frame->target == NULL) {
+        return true;
+    }
+
+    if (context->depthTarget == NULL || context->depthTargetWidth != frame->width || context->depthTargetHeight != frame->height) {
+        GBE_DeferRelease(context, GBE_RESOURCE_TEXTURE, context->depthTarget);
+
+        SDL_GPUTextureCreateInfo depthInfo = {
+            .type = SDL_GPU_TEXTURETYPE_2D,
+            .format = context->caps.depthFormat,
+            .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET,
+            .width = frame->width,
+            .height = frame->height,
+            .layer_count_or_depth = 1,
+            .num_levels = 1
+        };
+
+        context->depthTarget = SDL_CreateGPUTexture(context->device, &depthInfo);
+        if (context->depthTarget == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create a %ux%u depth buffer: %s", frame->width, frame->height, SDL_GetError());
+            return false;
+        }
+        context->depthTargetWidth = frame->width;
+        context->depthTargetHeight = frame->height;
+    }
+
+    frame->depthTarget = context->depthTarget;
+    return true;
+}
+
+static void LogFrameStats(GBE_Context* context)
+{
+    GBE_FrameStats* stats = &context->stats;
+    Uint64 now = SDL_GetTicksNS();
+    if (stats->intervalStartNS == 0) {
+        stats->intervalStartNS = now;
+        return;
+    }
+
+    stats->intervalFrames++;
+    Uint64 elapsedNS = now - stats->intervalStartNS;
+    if (elapsedNS < SDL_NS_PER_SECOND) {
+        return;
+    }
+
+    double seconds = (double)elapsedNS / SDL_NS_PER_SECOND;
+    double latencyMS = stats->latencySamples > 0 ? (double)stats->latencyTotalNS / stats->latencySamples / SDL_NS_PER_MS : 0.0;
+    SDL_Log("%s, %u frames in flight: %.1f fps (%.2f ms/frame), input to GPU completion at most %.2f ms over %u samples, %llu frames skipped so far",
+        GBE_GetPresentModeName(context->target.presentMode), context->target.framesInFlight,
+        stats->intervalFrames / seconds, seconds * 1000.0 / stats->intervalFrames, latencyMS, stats->latencySamples,
+        (unsigned long long)context->policy.framesSkipped);
+
+    stats->intervalStartNS = now;
+    stats->intervalFrames = 0;
+    stats->latencyTotalNS = 0;
+    stats->latencySamples = 0;
+}
+
+SDL_AppResult GBE_BeginFrame(GBE_Context* context, GBE_Frame* frame)
+{
+    SDL_assert(context != NULL);
+    SDL_assert(frame != NULL);
+
+    SDL_zerop(frame);
+
+    // Find out which earlier frames the GPU has finished, and let go of anything that
+    // was only waiting on them.
+    RetireFrames(context, false);
+    GBE_ProcessReleases(context);
+
+    if (context->stats.enabled) {
+        CollectLatencySamples(context);
+    }
+
+    frame->commandBuffer = SDL_AcquireGPUCommandBuffer(context->device);
+    if (frame->commandBuffer == NULL) {
+        SDL_Log("SDL_AcquireGPUCommandBuffer failed: %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+
+    if (context->headless) {
+        frame->target = context->offscreenTarget;
+        frame->width = context->target.width;
+        frame->height = context->target.height;
+    }
+    else if (!SDL_WaitAndAcquireGPUSwapchainTexture(frame->commandBuffer, context->window, &frame->target, &frame->width, &frame->height)) {
+        SDL_Log("SDL_WaitAndAcquireGPUSwapchainTexture: %s", SDL_GetError());
+        GBE_CancelFrame(context, frame);
+        return SDL_APP_FAILURE;
+    }
+
+    // The swapchain texture's size is the final word on how big the target is, and we
+    // get it for free here, so keep the cached size honest even if a resize event hasn't
+    // come through yet.
+    if (!context->headless && frame->target != NULL) {
+        context->target.width = frame->width;
+        context->target.height = frame->height;
+    }
+
+    if (!PrepareDepthTarget(context, frame)) {
+        GBE_CancelFrame(context, frame);
+        return SDL_APP_FAILURE;
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+void GBE_CancelFrame(GBE_Context* context, GBE_Frame* frame)
+{
+    if (frame->commandBuffer == NULL) {
+        return;
+    }
+
+    if (!context->headless && frame->target != NULL) {
+        SDL_SubmitGPUCommandBuffer(frame->commandBuffer);
+    }
+    else {
+        SDL_CancelGPUCommandBuffer(frame->commandBuffer);
+    }
+    frame->commandBuffer = NULL;
+}
+
+SDL_AppResult GBE_EndFrame(GBE_Context* context, GBE_Frame* frame)
+{
+    SDL_assert(context != NULL);
+    SDL_assert(frame != NULL);
+
+    // This frame's fence goes where the oldest one we're tracking is. That's only still in
+    // use if the GPU is more than GBE_MAX_FRAME_FENCES frames behind, so this hardly ever
+    // waits.
+    if (context->frameNumber - context->frameFences.completedFrames >= GBE_MAX_FRAME_FENCES) {
+        RetireFrames(context, true);
+    }
+
+    StartLatencyProbe(context);
+
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(frame->commandBuffer);
+    frame->commandBuffer = NULL;
+    if (fence == NULL) {
+        SDL_Log("SDL_SubmitGPUCommandBufferAndAcquireFence failed: %s", SDL_GetError());
+        return SDL_APP_FAILURE;
+    }
+    context->frameFences.fences[context->frameNumber % GBE_MAX_FRAME_FENCES] = fence;
+
+    if (context->stats.enabled) {
+        LogFrameStats(context);
+    }
+
+    // Whatever needed redrawing has been.
+    context->policy.dirty = 0;
+
+    context->frameNumber++;
+    if (context->maxFrames != 0 && context->frameNumber >= context->maxFrames) {
+        return SDL_APP_SUCCESS;
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+// Slows SDL_AppIterate down to the idle rate, or puts it back to SDL's default.
+static void SetIdle(GBE_Context* context, bool idle)
+{
+    GBE_FramePolicy* policy = &context->policy;
+    if (idle == policy->idle) {
+        return;
+    }
+
+    if (!idle) {
+        SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, NULL);
+    }
+    else if (policy->idleRate == 0) {
+        SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, "waitevent");
+    }
+    else {
+        char rate[16];
+        SDL_snprintf(rate, sizeof(rate), "%u", policy->idleRate);
+        SDL_SetHint(SDL_HINT_MAIN_CALLBACK_RATE, rate);
+    }
+    policy->idle = idle;
+}
+
+bool GBE_ShouldRender(GBE_Context* context)
+{
+    GBE_FramePolicy* policy = &context->policy;
+    if (!policy->onDemand) {
+        return true;
+    }
+
+    bool render = policy->dirty != 0 || policy->animating;
+    SetIdle(context, !render);
+    if (!render) {
+        policy->framesSkipped++;
+    }
+    return render;
+}
+
+void GBE_RequestRedraw(GBE_Context* context, GBE_RedrawReason reason)
+{
+    context->policy.dirty |= reason;
+}
+
+void GBE_SetAnimating(GBE_Context* context, bool animating)
+{
+    context->policy.animating = animating;
+}
+
+SDL_GPUTextureFormat GBE_GetTargetFormat(GBE_Context* context)
+{
+    return context->target.format;
+}
+
+SDL_GPUTextureFormat GBE_GetDepthFormat(GBE_Context* context)
+{
+    return context->useDepthTarget ? context->caps.depthFormat : SDL_GPU_TEXTUREFORMAT_INVALID;
+}
+
+void GBE_GetTargetSize(GBE_Context* context, Uint32* width, Uint32* height)
+{
+    *width = context->target.width;
+    *height = context->target.height;
+}
+
+void GBE_RefreshTargetState(GBE_Context* context)
+{
+    // The offscreen target never changes after it's created.
+    if (context->headless) {
+        return;
+    }
+
+    GBE_TargetState* target = &context->target;
+    target->format = SDL_GetGPUSwapchainTextureFormat(context->device, context->window);
+
+    int width = 0, height = 0;
+    SDL_GetWindowSizeInPixels(context->window, &width, &height);
+    target->width = (Uint32)width;
+    target->height = (Uint32)height;
+
+    target->supportedPresentModes = 0;
+    for (int mode = SDL_GPU_PRESENTMODE_VSYNC; mode <= SDL_GPU_PRESENTMODE_MAILBOX; mode++) {
+        if (SDL_WindowSupportsGPUPresentMode(context->device, context->window, (SDL_GPUPresentMode)mode)) {
+            target->supportedPresentModes |= 1u << mode;
+        }
+    }
+
+    target->supportedCompositions = 0;
+    for (int composition = SDL_GPU_SWAPCHAINCOMPOSITION_SDR; composition <= SDL_GPU_SWAPCHAINCOMPOSITION_HDR10_ST2084; composition++) {
+        if (SDL_WindowSupportsGPUSwapchainComposition(context->device, context->window, (SDL_GPUSwapchainComposition)composition)) {
+            target->supportedCompositions |= 1u << composition;
+        }
+    }
+}
+
+// Names match the command line options GBE_ApplyCommandLine takes.
+static const char* kPresentModeNames[] = { "vsync", "immediate", "mailbox" };
+
+const char* GBE_GetPresentModeName(SDL_GPUPresentMode presentMode)
+{
+    if ((size_t)presentMode < SDL_arraysize(kPresentModeNames)) {
+        return kPresentModeNames[presentMode];
+    }
+
+    return "unknown";
+}
+
+bool GBE_ParsePresentMode(const char* name, SDL_GPUPresentMode* presentMode)
+{
+    for (size_t i = 0; i < SDL_arraysize(kPresentModeNames); i++) {
+        if (SDL_strcasecmp(name, kPresentModeNames[i]) == 0) {
+            *presentMode = (SDL_GPUPresentMode)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool SupportsPresentMode(GBE_Context* context, SDL_GPUPresentMode presentMode)
+{
+    return (context->target.supportedPresentModes & (1u << presentMode)) != 0;
+}
+
+static bool ApplySwapchainParameters(GBE_Context* context, SDL_GPUSwapchainComposition composition, SDL_GPUPresentMode presentMode)
+{
+    if (!SDL_SetGPUSwapchainParameters(context->device, context->window, composition, presentMode)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "SDL_SetGPUSwapchainParameters failed: %s", SDL_GetError());
+        return false;
+    }
+
+    context->target.composition = composition;
+    context->target.presentMode = presentMode;
+
+    // HDR compositions come with their own swapchain formats.
+    context->target.format = SDL_GetGPUSwapchainTextureFormat(context->device, context->window);
+    return true;
+}
+
+SDL_GPUPresentMode GBE_SetPresentMode(GBE_Context* context, SDL_GPUPresentMode presentMode)
+{
+    // No swapchain, nothing to present.
+    if (context->headless) {
+        return context->target.presentMode;
+    }
+
+    SDL_GPUPresentMode wanted = presentMode;
+    if (presentMode == SDL_GPU_PRESENTMODE_IMMEDIATE && !SupportsPresentMode(context, presentMode)) {
+        presentMode = SDL_GPU_PRESENTMODE_MAILBOX;
+    }
+    if (presentMode == SDL_GPU_PRESENTMODE_MAILBOX && !SupportsPresentMode(context, presentMode)) {
+        presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+    }
+
+    if (presentMode != wanted) {
+        SDL_Log("Present mode %s isn't supported here, using %s instead.", GBE_GetPresentModeName(wanted), GBE_GetPresentModeName(presentMode));
+    }
+
+    if (presentMode != context->target.presentMode) {
+        ApplySwapchainParameters(context, context->target.composition, presentMode);
+    }
+
+    return context->target.presentMode;
+}
+
+SDL_GPUSwapchainComposition GBE_SetSwapchainComposition(GBE_Context* context, SDL_GPUSwapchainComposition composition)
+{
+    if (context->headless) {
+        return context->target.composition;
+    }
+
+    // SDR is the only composition every window supports.
+    if ((context->target.supportedCompositions & (1u << composition)) == 0) {
+        SDL_Log("Swapchain composition %d isn't supported here, using SDR instead.", composition);
+        composition = SDL_GPU_SWAPCHAINCOMPOSITION_SDR;
+    }
+
+    if (composition != context->target.composition) {
+        ApplySwapchainParameters(context, composition, context->target.presentMode);
+    }
+
+    return context->target.composition;
+}
+
+bool GBE_SetFramesInFlight(GBE_Context* context, Uint32 framesInFlight)
+{
+    framesInFlight = SDL_clamp(framesInFlight, 1, 3);
+    if (framesInFlight == context->target.framesInFlight) {
+        return true;
+    }
+
+    // Note that this stalls until the GPU's caught up, so it's not something to do
+    // every frame.
+    if (!SDL_SetGPUAllowedFramesInFlight(context->device, framesInFlight)) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "SDL_SetGPUAllowedFramesInFlight failed: %s", SDL_GetError());
+        return false;
+    }
+
+    context->target.framesInFlight = framesInFlight;
+    return true;
+}
+
+// Events that mean someone's using the app: keys and text, the mouse, gamepad buttons and
+// sticks, touches and the pen. Raw joystick axes, balls and hats, gamepad sensors and
+// touchpads, and devices coming and going can fire constantly without anyone touching
+// anything, so they don't count.
+static bool IsInputEvent(Uint32 type)
+{
+    switch (type) {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+    case SDL_EVENT_TEXT_EDITING:
+    case SDL_EVENT_TEXT_INPUT:
+    case SDL_EVENT_MOUSE_MOTION:
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+    case SDL_EVENT_MOUSE_WHEEL:
+    case SDL_EVENT_GAMEPAD_AXIS_MOTION:
+    case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
+    case SDL_EVENT_GAMEPAD_BUTTON_UP:
+    case SDL_EVENT_FINGER_DOWN:
+    case SDL_EVENT_FINGER_UP:
+    case SDL_EVENT_FINGER_MOTION:
+    case SDL_EVENT_PEN_DOWN:
+    case SDL_EVENT_PEN_UP:
+    case SDL_EVENT_PEN_BUTTON_DOWN:
+    case SDL_EVENT_PEN_BUTTON_UP:
+    case SDL_EVENT_PEN_MOTION:
+    case SDL_EVENT_PEN_AXIS:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void GBE_HandleEvent(GBE_Context* context, const SDL_Event* event)
+{
+    if (IsInputEvent(event->type)) {
+        GBE_RequestRedraw(context, GBE_REDRAW_INPUT);
+    }
+
+    // Input gets timestamped so the frame stats can tell how long it takes to show up.
+    if (event->type == SDL_EVENT_KEY_DOWN || event->type == SDL_EVENT_MOUSE_BUTTON_DOWN) {
+        if (context->stats.enabled && context->stats.pendingInputNS == 0) {
+            context->stats.pendingInputNS = event->common.timestamp;
+        }
+        return;
+    }
+
+    if (event->type < SDL_EVENT_WINDOW_FIRST || event->type > SDL_EVENT_WINDOW_LAST) {
+        return;
+    }
+
+    if (context->window == NULL || event->window.windowID != SDL_GetWindowID(context->window)) {
+        return;
+    }
+
+    switch (event->type) {
+    case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+        context->target.width = (Uint32)event->window.data1;
+        context->target.height = (Uint32)event->window.data2;
+        GBE_RequestRedraw(context, GBE_REDRAW_RESIZE);
+        break;
+
+    // A different display can mean different present modes, compositions or even
+    // swapchain formats, so look everything up again.
+    case SDL_EVENT_WINDOW_DISPLAY_CHANGED:
+        GBE_RefreshTargetState(context);
+        GBE_RequestRedraw(context, GBE_REDRAW_RESIZE);
+        break;
+
+    // The window's contents may have been lost, and have to be drawn again.
+    case SDL_EVENT_WINDOW_EXPOSED:
+    case SDL_EVENT_WINDOW_SHOWN:
+    case SDL_EVENT_WINDOW_RESTORED:
+        GBE_RequestRedraw(context, GBE_REDRAW_EXPOSED);
+        break;
+
+    default:
+        break;
+    }
+}
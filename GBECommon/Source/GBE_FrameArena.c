@@ -0,0 +1,128 @@
+//
+//  GBE_FrameArena.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_FrameArena.h>
+
+// Regions start on cache line boundaries, so different threads' arenas never share one.
+#define GBE_ARENA_REGION_ALIGNMENT GBE_CACHE_LINE_SIZE
+
+SDL_COMPILE_TIME_ASSERT(GBE_JobArena_size, sizeof(GBE_JobArena) % GBE_CACHE_LINE_SIZE == 0);
+
+bool GBE_CreateFrameArena(size_t capacity, int numFrames, GBE_FrameArena* arena)
+{
+    SDL_assert(arena != NULL);
+
+    SDL_zerop(arena);
+    numFrames = SDL_clamp(numFrames, 1, GBE_MAX_ARENA_FRAMES);
+    capacity = (capacity + GBE_ARENA_REGION_ALIGNMENT - 1) & ~(size_t)(GBE_ARENA_REGION_ALIGNMENT - 1);
+
+    arena->memory = SDL_aligned_alloc(GBE_ARENA_REGION_ALIGNMENT, capacity * numFrames);
+    if (arena->memory == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory creating a frame arena of %zu bytes per frame.", capacity);
+        return false;
+    }
+
+    arena->capacity = capacity;
+    arena->numFrames = numFrames;
+    arena->region = arena->memory;
+    return true;
+}
+
+void GBE_DestroyFrameArena(GBE_FrameArena* arena)
+{
+    SDL_aligned_free(arena->memory);
+    SDL_zerop(arena);
+}
+
+void GBE_ResetFrameArena(GBE_FrameArena* arena, Uint64 frameNumber)
+{
+    arena->region = arena->memory + arena->capacity * (size_t)(frameNumber % (Uint64)arena->numFrames);
+    arena->used = 0;
+}
+
+void* GBE_FrameArenaAlloc(GBE_FrameArena* arena, size_t size, size_t alignment)
+{
+    SDL_assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    // Regions are only aligned to GBE_ARENA_REGION_ALIGNMENT, so bigger alignments go by
+    // the address rather than the offset.
+    uintptr_t next = (uintptr_t)(arena->region + arena->used);
+    size_t start = arena->used + (((next + alignment - 1) & ~(uintptr_t)(alignment - 1)) - next);
+    if (start > arena->capacity || size > arena->capacity - start) {
+        arena->overflows++;
+        return NULL;
+    }
+
+    arena->used = start + size;
+    arena->highWaterMark = SDL_max(arena->highWaterMark, arena->used);
+    arena->allocations++;
+    return arena->region + start;
+}
+
+bool GBE_CreateJobArenas(GBE_JobSystem* jobs, size_t capacity, int numFrames, GBE_JobArenas* arenas)
+{
+    SDL_assert(jobs != NULL);
+    SDL_assert(arenas != NULL);
+
+    SDL_zerop(arenas);
+    arenas->jobs = jobs;
+    arenas->arenas = SDL_aligned_alloc(GBE_CACHE_LINE_SIZE, sizeof(GBE_JobArena) * jobs->numThreads);
+    if (arenas->arenas == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory creating frame arenas for %d threads.", jobs->numThreads);
+        return false;
+    }
+    SDL_memset(arenas->arenas, 0, sizeof(GBE_JobArena) * jobs->numThreads);
+    arenas->numArenas = jobs->numThreads;
+
+    for (int i = 0; i < arenas->numArenas; i++) {
+        if (!GBE_CreateFrameArena(capacity, numFrames, &arenas->arenas[i].arena)) {
+            GBE_DestroyJobArenas(arenas);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void GBE_DestroyJobArenas(GBE_JobArenas* arenas)
+{
+    for (int i = 0; i < arenas->numArenas; i++) {
+        GBE_DestroyFrameArena(&arenas->arenas[i].arena);
+    }
+    SDL_aligned_free(arenas->arenas);
+    SDL_zerop(arenas);
+}
+
+void GBE_ResetJobArenas(GBE_JobArenas* arenas, Uint64 frameNumber)
+{
+    for (int i = 0; i < arenas->numArenas; i++) {
+        GBE_ResetFrameArena(&arenas->arenas[i].arena, frameNumber);
+    }
+}
+
+void* GBE_JobArenaAlloc(GBE_JobArenas* arenas, size_t size, size_t alignment)
+{
+    int thread = GBE_GetJobThreadIndex(arenas->jobs);
+    SDL_assert(thread >= 0 && "Job arenas can only be allocated from by the job system's own threads.");
+    return GBE_FrameArenaAlloc(&arenas->arenas[thread].arena, size, alignment);
+}
+
+size_t GBE_GetJobArenasHighWaterMark(const GBE_JobArenas* arenas)
+{
+    size_t total = 0;
+    for (int i = 0; i < arenas->numArenas; i++) {
+        total += arenas->arenas[i].arena.highWaterMark;
+    }
+    return total;
+}
+
+Uint64 GBE_GetJobArenasOverflows(const GBE_JobArenas* arenas)
+{
+    Uint64 total = 0;
+    for (int i = 0; i < arenas->numArenas; i++) {
+        total += arenas->arenas[i].arena.overflows;
+    }
+    return total;
+}
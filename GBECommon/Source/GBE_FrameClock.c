@@ -0,0 +1,108 @@
+//
+//  GBE_FrameClock.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_FrameClock.h>
+
+void GBE_ResetFrameClock(GBE_FrameClock* clock, Uint64 fixedStepNS)
+{
+    SDL_assert(clock != NULL);
+
+    SDL_zerop(clock);
+    clock->lastTickNS = SDL_GetTicksNS();
+    clock->smoothing = 0.1;
+    clock->fixedStepNS = fixedStepNS;
+}
+
+void GBE_TickFrameClock(GBE_FrameClock* clock)
+{
+    Uint64 now = SDL_GetTicksNS();
+    Uint64 deltaNS = SDL_min(now - clock->lastTickNS, GBE_FRAME_CLOCK_MAX_DELTA_NS);
+    clock->lastTickNS = now;
+
+    // The first tick has nothing to average with yet.
+    if (clock->frames == 0) {
+        clock->smoothedDeltaNS = (double)deltaNS;
+    }
+    else {
+        clock->smoothedDeltaNS += (deltaNS - clock->smoothedDeltaNS) * clock->smoothing;
+    }
+    clock->deltaNS = deltaNS;
+    clock->elapsedNS += deltaNS;
+    clock->history[clock->frames % GBE_FRAME_CLOCK_HISTORY] = deltaNS;
+    clock->historyCount = (Uint32)SDL_min(clock->frames + 1, GBE_FRAME_CLOCK_HISTORY);
+    clock->frames++;
+
+    if (clock->fixedStepNS == 0) {
+        return;
+    }
+
+    clock->accumulatorNS += deltaNS;
+    Uint64 limitNS = GBE_FRAME_CLOCK_MAX_STEPS * clock->fixedStepNS;
+    if (clock->accumulatorNS >= limitNS + clock->fixedStepNS) {
+        Uint64 dropped = (clock->accumulatorNS - limitNS) / clock->fixedStepNS;
+        clock->accumulatorNS -= dropped * clock->fixedStepNS;
+        clock->stepsDropped += dropped;
+    }
+}
+
+double GBE_GetSmoothedDeltaSeconds(const GBE_FrameClock* clock)
+{
+    return clock->smoothedDeltaNS / SDL_NS_PER_SECOND;
+}
+
+bool GBE_NextFixedStep(GBE_FrameClock* clock)
+{
+    if (clock->fixedStepNS == 0 || clock->accumulatorNS < clock->fixedStepNS) {
+        return false;
+    }
+
+    clock->accumulatorNS -= clock->fixedStepNS;
+    clock->stepsTaken++;
+    return true;
+}
+
+double GBE_GetFixedStepSeconds(const GBE_FrameClock* clock)
+{
+    return (double)clock->fixedStepNS / SDL_NS_PER_SECOND;
+}
+
+float GBE_GetFrameClockAlpha(const GBE_FrameClock* clock)
+{
+    if (clock->fixedStepNS == 0) {
+        return 1.0f;
+    }
+    return (float)((double)clock->accumulatorNS / clock->fixedStepNS);
+}
+
+void GBE_SummarizeFrameTimes(const GBE_FrameClock* clock, GBE_FrameTimeSummary* summary)
+{
+    SDL_zerop(summary);
+    summary->samples = clock->historyCount;
+    if (clock->historyCount == 0) {
+        return;
+    }
+
+    Uint64 minNS = clock->history[0];
+    Uint64 maxNS = clock->history[0];
+    double totalNS = 0;
+    for (Uint32 i = 0; i < clock->historyCount; i++) {
+        minNS = SDL_min(minNS, clock->history[i]);
+        maxNS = SDL_max(maxNS, clock->history[i]);
+        totalNS += (double)clock->history[i];
+    }
+    double averageNS = totalNS / clock->historyCount;
+
+    double variance = 0;
+    for (Uint32 i = 0; i < clock->historyCount; i++) {
+        double difference = clock->history[i] - averageNS;
+        variance += difference * difference;
+    }
+    variance /= clock->historyCount;
+
+    summary->minMS = (double)minNS / SDL_NS_PER_MS;
+    summary->averageMS = averageNS / SDL_NS_PER_MS;
+    summary->maxMS = (double)maxNS / SDL_NS_PER_MS;
+    summary->jitterMS = SDL_sqrt(variance) / SDL_NS_PER_MS;
+}
@@ -6,17 +6,30 @@
 //
 
 #include <GBECommon/GBE_Init.h>
+#include <GBECommon/GBE_Frame.h>
+#include <GBECommon/GBE_ReleaseQueue.h>
+#include <GBECommon/GBE_PipelineCache.h>
 
-SDL_AppResult GBE_CommonInit(GBE_Context* appContext, const char* windowTitle)
+// Milliseconds since a performance counter reading, for the startup timing log.
+static double ElapsedMS(Uint64 start)
 {
-    SDL_assert(appContext != NULL);
-    SDL_assert(windowTitle != NULL);
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
 
-    // Initialize the video and event subsystems
-    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't initialize SDL: %s", SDL_GetError());
-        return SDL_APP_FAILURE;
-    }
+void GBE_DefaultInitConfig(GBE_InitConfig* config, const char* windowTitle)
+{
+    SDL_assert(config != NULL);
+
+    SDL_zerop(config);
+    config->windowTitle = windowTitle;
+    config->windowWidth = 800;
+    config->windowHeight = 600;
+
+#ifdef NDEBUG
+    config->debugMode = false;
+#else
+    config->debugMode = true;
+#endif
 
     // SDL runs through a list of known GPU backends to find one that matches the list of shader
     // formats you give it, in this order:
@@ -25,64 +38,419 @@ SDL_AppResult GBE_CommonInit(GBE_Context* appContext, const char* windowTitle)
     // - Direct3D 12
     //
     // So if your hardware supports Vulkan, it's going to use that. I want to actually test my
-    // Direct3D shaders, so I try only DXIL first, and if that fails I'll try the others.
+    // Direct3D shaders, so I prefer DXIL on its own first, and only if that's not available do
+    // I hand over the others.
+    config->shaderFormats[0] = SDL_GPU_SHADERFORMAT_DXIL;
+    config->shaderFormats[1] = SDL_GPU_SHADERFORMAT_SPIRV | SDL_GPU_SHADERFORMAT_MSL;
+    config->numShaderFormats = 2;
 
-    SDL_GPUShaderFormat shaderFormats = SDL_GPU_SHADERFORMAT_DXIL;
-    SDL_GPUDevice* device = SDL_CreateGPUDevice(shaderFormats, true, NULL);
-    if (device == NULL) {
-        shaderFormats = SDL_GPU_SHADERFORMAT_SPIRV |
-                        SDL_GPU_SHADERFORMAT_MSL;
+    config->offscreenFormat = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+
+    config->storageTimeoutMS = 5000;
+
+    config->presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+    config->composition = SDL_GPU_SWAPCHAINCOMPOSITION_SDR;
+    config->framesInFlight = 2;
+}
+
+void GBE_ApplyCommandLine(GBE_InitConfig* config, int argc, char** argv)
+{
+    SDL_assert(config != NULL);
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (SDL_strcmp(arg, "--headless") == 0) {
+            config->headless = true;
+        }
+        else if (SDL_strcmp(arg, "--debug") == 0) {
+            config->debugMode = true;
+        }
+        else if (SDL_strcmp(arg, "--no-debug") == 0) {
+            config->debugMode = false;
+        }
+        else if (SDL_strcmp(arg, "--stats") == 0) {
+            config->logFrameStats = true;
+        }
+        else if (SDL_strcmp(arg, "--on-demand") == 0) {
+            config->renderOnDemand = true;
+        }
+        else if (SDL_strcmp(arg, "--continuous") == 0) {
+            config->renderOnDemand = false;
+        }
+        else if (SDL_strcmp(arg, "--idle-rate") == 0 && value != NULL) {
+            config->idleRate = (Uint32)SDL_strtoul(value, NULL, 10);
+            config->renderOnDemand = true;
+            i++;
+        }
+        else if (SDL_strcmp(arg, "--run-for") == 0 && value != NULL) {
+            config->runSeconds = (Uint32)SDL_strtoul(value, NULL, 10);
+            i++;
+        }
+        else if (SDL_strcmp(arg, "--present-mode") == 0 && value != NULL) {
+            if (!GBE_ParsePresentMode(value, &config->presentMode)) {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Ignoring --present-mode %s; expected vsync, immediate or mailbox.", value);
+            }
+            i++;
+        }
+        else if (SDL_strcmp(arg, "--frames-in-flight") == 0 && value != NULL) {
+            config->framesInFlight = (Uint32)SDL_strtoul(value, NULL, 10);
+            i++;
+        }
+        else if (SDL_strcmp(arg, "--size") == 0 && value != NULL) {
+            int width, height;
+            if (SDL_sscanf(value, "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+                config->windowWidth = width;
+                config->windowHeight = height;
+            }
+            else {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Ignoring --size %s; expected something like 800x600.", value);
+            }
+            i++;
+        }
+        else if (SDL_strcmp(arg, "--frames") == 0 && value != NULL) {
+            config->maxFrames = SDL_strtoull(value, NULL, 10);
+            i++;
+        }
+        else if (SDL_strcmp(arg, "--driver") == 0 && value != NULL) {
+            config->preferredDriver = value;
+            i++;
+        }
+        else if (SDL_strcmp(arg, "--pipeline-cache") == 0 && value != NULL) {
+            config->pipelineCachePath = value;
+            i++;
+        }
+    }
+}
+
+SDL_AppResult GBE_CommonInit(GBE_Context* appContext, const char* windowTitle)
+{
+    GBE_InitConfig config;
+    GBE_DefaultInitConfig(&config, windowTitle);
+    return GBE_CommonInitWithConfig(appContext, &config);
+}
+
+// Creating a GPU device is expensive (and with debugMode on, very expensive), so rather
+// than creating devices until one sticks, ask SDL which of our preferred format sets it
+// can actually run and only create a device for that one.
+static SDL_GPUDevice* CreateDevice(const GBE_InitConfig* config)
+{
+    SDL_GPUDevice* device = NULL;
+    for (int i = 0; i < config->numShaderFormats && device == NULL; i++) {
+        SDL_GPUShaderFormat shaderFormats = config->shaderFormats[i];
+        if (!SDL_GPUSupportsShaderFormats(shaderFormats, config->preferredDriver)) {
+            continue;
+        }
 
-        device = SDL_CreateGPUDevice(shaderFormats, true, NULL);
+        device = SDL_CreateGPUDevice(shaderFormats, config->debugMode, config->preferredDriver);
         if (device == NULL) {
-            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't not create GPU device: %s", SDL_GetError());
-            return SDL_APP_FAILURE;
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create GPU device for shader formats 0x%x: %s", shaderFormats, SDL_GetError());
         }
     }
 
-    SDL_Log("Using %s GPU implementation.", SDL_GetGPUDeviceDriver(device));
+    return device;
+}
 
-    SDL_WindowFlags windowFlags = SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_RESIZABLE;
-    SDL_Window* window = SDL_CreateWindow(windowTitle, 800, 600, windowFlags);
+// Depth formats in order of preference; SDL only guarantees that one of D24_UNORM and
+// D32_FLOAT (and one of the matching stencil formats) is available.
+static const SDL_GPUTextureFormat kDepthFormats[] = {
+    SDL_GPU_TEXTUREFORMAT_D32_FLOAT,
+    SDL_GPU_TEXTUREFORMAT_D24_UNORM,
+    SDL_GPU_TEXTUREFORMAT_D16_UNORM
+};
 
-    if (window == NULL) {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create window: %s", SDL_GetError());
-        return SDL_APP_FAILURE;
+static const SDL_GPUTextureFormat kDepthStencilFormats[] = {
+    SDL_GPU_TEXTUREFORMAT_D24_UNORM_S8_UINT,
+    SDL_GPU_TEXTUREFORMAT_D32_FLOAT_S8_UINT
+};
+
+static SDL_GPUTextureFormat FirstSupportedDepthFormat(SDL_GPUDevice* device, const SDL_GPUTextureFormat* formats, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (SDL_GPUTextureSupportsFormat(device, formats[i], SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)) {
+            return formats[i];
+        }
     }
 
-    if (!SDL_ClaimWindowForGPUDevice(device, window)) {
-        SDL_Log("SDL_ClaimWindowForGPUDevice failed: %s", SDL_GetError());
+    return SDL_GPU_TEXTUREFORMAT_INVALID;
+}
+
+// On most desktop platforms title storage is ready the moment it's opened, and by the
+// time the device and window exist it's had plenty of time anyway. SDL doesn't give us
+// anything to block on, so if it still isn't ready, back off gradually until it is or
+// until we've waited long enough to call it a failure.
+static bool WaitForStorage(SDL_Storage* storage, Uint32 timeoutMS)
+{
+    Uint64 deadline = SDL_GetTicks() + timeoutMS;
+    Uint32 backoffMS = 1;
+
+    while (!SDL_StorageReady(storage)) {
+        if (SDL_GetTicks() >= deadline) {
+            return false;
+        }
+
+        SDL_Delay(backoffMS);
+        backoffMS = SDL_min(backoffMS * 2, 16);
+    }
+
+    return true;
+}
+
+// Files read on a thread of their own while the device and window are created, which
+// have to stay on this thread. Reading a file doesn't touch the video driver, so that's
+// safe to overlap with them. For now that's just the pipeline cache file.
+typedef struct StartupReader {
+    SDL_Thread* thread;
+    const char* pipelineCachePath;
+    void* pipelineCache;
+    size_t pipelineCacheSize;
+    double readMS;
+} StartupReader;
+
+static int SDLCALL ReadStartupFiles(void* data)
+{
+    StartupReader* reader = data;
+    Uint64 began = SDL_GetPerformanceCounter();
+    reader->pipelineCache = SDL_LoadFile(reader->pipelineCachePath, &reader->pipelineCacheSize);
+    reader->readMS = ElapsedMS(began);
+    return 0;
+}
+
+// Timer callbacks run on a thread of SDL's, but pushing events is fine from any thread.
+static Uint32 SDLCALL QuitWhenTimeIsUp(void* userdata, SDL_TimerID timerID, Uint32 interval)
+{
+    SDL_Event event = { .type = SDL_EVENT_QUIT };
+    SDL_PushEvent(&event);
+    return 0;
+}
+
+SDL_AppResult GBE_CommonInitWithConfig(GBE_Context* appContext, const GBE_InitConfig* config)
+{
+    SDL_assert(appContext != NULL);
+    SDL_assert(config != NULL);
+    SDL_assert(config->windowTitle != NULL);
+
+    Uint64 startupBegan = SDL_GetPerformanceCounter();
+
+    // A headless context still needs SDL's video subsystem (that's where the Vulkan loader
+    // lives), but it can't count on there being a display to talk to, so unless someone's
+    // asked for a specific video driver, use SDL's offscreen one.
+    if (config->headless && SDL_GetHint(SDL_HINT_VIDEO_DRIVER) == NULL) {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    }
+
+    // Initialize the video and event subsystems
+    Uint64 phaseBegan = SDL_GetPerformanceCounter();
+    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't initialize SDL: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
+    double sdlInitMS = ElapsedMS(phaseBegan);
 
     // SDL has some functionality to help us locate a game's resource files; here I'm using
-    // their Storage abstraction.
+    // their Storage abstraction. Opening it first gives it the whole rest of startup to
+    // become ready on platforms where that takes a while.
+    phaseBegan = SDL_GetPerformanceCounter();
     SDL_Storage* storage = SDL_OpenTitleStorage(NULL, 0);
     if (storage == NULL) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to open title storage: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
+    appContext->titleStorage = storage;
+    double storageOpenMS = ElapsedMS(phaseBegan);
 
-    // I don't think this is necessary on desktop platforms, but on some devices
-    // the storage instance might not be available immediately, so we busy wait
-    // until it is.
-    while (!SDL_StorageReady(storage)) {
-        SDL_Delay(1);
+    // If the reader thread can't be started, the files are read on this thread once the
+    // window's been made instead.
+    StartupReader reader = { .pipelineCachePath = config->pipelineCachePath };
+    if (reader.pipelineCachePath != NULL) {
+        reader.thread = SDL_CreateThread(ReadStartupFiles, "GBE startup reader", &reader);
     }
 
-    appContext->window = window;
+    // The device and the window are made one after the other, on this thread: both go
+    // through the video driver (and on Vulkan, the loader), which isn't safe to call from
+    // two threads at once. The startup reader reads its files meanwhile.
+    phaseBegan = SDL_GetPerformanceCounter();
+    SDL_GPUDevice* device = CreateDevice(config);
+    double deviceMS = ElapsedMS(phaseBegan);
+
+    phaseBegan = SDL_GetPerformanceCounter();
+    SDL_Window* window = NULL;
+    if (!config->headless && device != NULL) {
+        SDL_WindowFlags windowFlags = SDL_WINDOW_HIGH_PIXEL_DENSITY | SDL_WINDOW_RESIZABLE;
+        window = SDL_CreateWindow(config->windowTitle, config->windowWidth, config->windowHeight, windowFlags);
+    }
+    double windowMS = ElapsedMS(phaseBegan);
+
+    // How long the reader took past the device and window being ready, if it ran at all.
+    phaseBegan = SDL_GetPerformanceCounter();
+    if (reader.thread != NULL) {
+        SDL_WaitThread(reader.thread, NULL);
+    }
+    else if (reader.pipelineCachePath != NULL) {
+        ReadStartupFiles(&reader);
+    }
+    double readerWaitMS = ElapsedMS(phaseBegan);
+
+    // Stash everything right away so GBE_Quit can clean up if anything below fails.
     appContext->device = device;
-    appContext->titleStorage = storage;
+    appContext->window = window;
+    appContext->pipelineCache.path = config->pipelineCachePath;
+    appContext->pipelineCache.startupFile = reader.pipelineCache;
+    appContext->pipelineCache.startupFileSize = reader.pipelineCacheSize;
+    appContext->headless = config->headless;
+    appContext->maxFrames = config->maxFrames;
+    appContext->releaseQueue.trackResources = config->debugMode;
+    appContext->useDepthTarget = config->depthBuffer;
+
+    if (device == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create a GPU device for any of the requested shader formats.");
+        return SDL_APP_FAILURE;
+    }
+
+    SDL_Log("Using %s GPU implementation.", SDL_GetGPUDeviceDriver(device));
+
+    // Look up everything we'll want to know about the device later while we're here.
+    appContext->caps.driver = SDL_GetGPUDeviceDriver(device);
+    appContext->caps.shaderFormats = SDL_GetGPUShaderFormats(device);
+    appContext->caps.depthFormat = FirstSupportedDepthFormat(device, kDepthFormats, SDL_arraysize(kDepthFormats));
+    appContext->caps.depthStencilFormat = FirstSupportedDepthFormat(device, kDepthStencilFormats, SDL_arraysize(kDepthStencilFormats));
+    if (appContext->useDepthTarget && appContext->caps.depthFormat == SDL_GPU_TEXTUREFORMAT_INVALID) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "This device has no depth format we can render into; drawing without a depth buffer.");
+        appContext->useDepthTarget = false;
+    }
+
+    phaseBegan = SDL_GetPerformanceCounter();
+    if (config->headless) {
+        // No window means no swapchain, so make our own texture to render into. It's
+        // also marked as sampleable so its contents can be copied or read back later.
+        SDL_GPUTextureCreateInfo targetInfo = {
+            .type = SDL_GPU_TEXTURETYPE_2D,
+            .format = config->offscreenFormat,
+            .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+            .width = (Uint32)config->windowWidth,
+            .height = (Uint32)config->windowHeight,
+            .layer_count_or_depth = 1,
+            .num_levels = 1
+        };
+
+        SDL_GPUTexture* offscreenTarget = SDL_CreateGPUTexture(device, &targetInfo);
+        if (offscreenTarget == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create offscreen render target: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        appContext->offscreenTarget = offscreenTarget;
+        appContext->target.format = targetInfo.format;
+        appContext->target.width = targetInfo.width;
+        appContext->target.height = targetInfo.height;
+        SDL_Log("Running headless, rendering into a %ux%u offscreen target.", targetInfo.width, targetInfo.height);
+    }
+    else {
+        if (window == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create window: %s", SDL_GetError());
+            return SDL_APP_FAILURE;
+        }
+
+        if (!SDL_ClaimWindowForGPUDevice(device, window)) {
+            SDL_Log("SDL_ClaimWindowForGPUDevice failed: %s", SDL_GetError());
+            SDL_DestroyWindow(window);
+            appContext->window = NULL;
+            return SDL_APP_FAILURE;
+        }
+    }
+
+    // SDL starts every swapchain out with these; switch to whatever we've been asked
+    // for (or the closest thing the window supports).
+    appContext->target.presentMode = SDL_GPU_PRESENTMODE_VSYNC;
+    appContext->target.composition = SDL_GPU_SWAPCHAINCOMPOSITION_SDR;
+    appContext->target.framesInFlight = 2;
+    GBE_RefreshTargetState(appContext);
+    GBE_SetSwapchainComposition(appContext, config->composition);
+    GBE_SetPresentMode(appContext, config->presentMode);
+    GBE_SetFramesInFlight(appContext, config->framesInFlight);
+    appContext->stats.enabled = config->logFrameStats;
+    appContext->policy.onDemand = config->renderOnDemand;
+    appContext->policy.idleRate = config->idleRate;
+
+    // Without a window there are no events to flag a redraw, so after the first frame an
+    // on-demand run would never draw another, and would never get to maxFrames.
+    if (config->headless && config->renderOnDemand && config->maxFrames != 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Drawing every frame: headless runs can't count frames drawn on demand.");
+        appContext->policy.onDemand = false;
+    }
+    appContext->policy.dirty = GBE_REDRAW_CONTENT;
+    double targetMS = ElapsedMS(phaseBegan);
+
+    phaseBegan = SDL_GetPerformanceCounter();
+    if (!WaitForStorage(storage, config->storageTimeoutMS)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Title storage still wasn't ready after %u ms.", config->storageTimeoutMS);
+        return SDL_APP_FAILURE;
+    }
+    double storageWaitMS = ElapsedMS(phaseBegan);
+
+    SDL_Log("Startup took %.2f ms: SDL_Init %.2f ms, storage open %.2f ms, GPU device %.2f ms%s, "
+            "window %.2f ms, %s %.2f ms, storage wait %.2f ms.",
+        ElapsedMS(startupBegan), sdlInitMS, storageOpenMS, deviceMS, config->debugMode ? " (debug mode)" : "",
+        windowMS, config->headless ? "offscreen target" : "window claim", targetMS, storageWaitMS);
+    if (reader.pipelineCachePath != NULL) {
+        SDL_Log("Reading the pipeline cache took %.2f ms %s, %.2f ms of it after the device and window were ready.",
+            reader.readMS, reader.thread != NULL ? "alongside them" : "after them", readerWaitMS);
+    }
+
+    // Shaders come out of title storage, so this has to wait until it's ready.
+    if (config->pipelineCachePath != NULL) {
+        GBE_PrewarmPipelineCacheFromFile(appContext, config->pipelineCachePath,
+            appContext->pipelineCache.startupFile, appContext->pipelineCache.startupFileSize);
+        appContext->pipelineCache.startupFile = NULL;
+    }
+
+    if (config->runSeconds > 0) {
+        appContext->quitTimer = SDL_AddTimer(config->runSeconds * 1000, QuitWhenTimeIsUp, NULL);
+    }
+
     return SDL_APP_CONTINUE;
 }
 
 void GBE_Quit(GBE_Context* appContext)
 {
+    if (appContext->quitTimer != 0) {
+        SDL_RemoveTimer(appContext->quitTimer);
+    }
+
     if (appContext->titleStorage != NULL) {
         SDL_CloseStorage(appContext->titleStorage);
     }
 
+    // Only still here if startup failed before it got to prewarming.
+    SDL_free(appContext->pipelineCache.startupFile);
+
     if (appContext->device != NULL) {
+        // Cached pipelines join the release queue, then anything the app handed to
+        // GBE_DeferRelease goes; anything it registered but never released gets reported.
+        if (appContext->pipelineCache.path != NULL) {
+            GBE_SavePipelineCache(appContext, appContext->pipelineCache.path);
+        }
+        GBE_DestroyPipelineCache(appContext);
+        GBE_FlushReleases(appContext);
+        GBE_ReportLeaks(appContext);
+        SDL_free(appContext->releaseQueue.pending);
+        SDL_free(appContext->releaseQueue.tracked);
+
+        for (int i = 0; i < GBE_MAX_FRAME_FENCES; i++) {
+            if (appContext->frameFences.fences[i] != NULL) {
+                SDL_ReleaseGPUFence(appContext->device, appContext->frameFences.fences[i]);
+            }
+        }
+
+        if (appContext->offscreenTarget != NULL) {
+            SDL_ReleaseGPUTexture(appContext->device, appContext->offscreenTarget);
+        }
+
+        if (appContext->depthTarget != NULL) {
+            SDL_ReleaseGPUTexture(appContext->device, appContext->depthTarget);
+        }
+
         if (appContext->window != NULL) {
             SDL_ReleaseWindowFromGPUDevice(appContext->device, appContext->window);
             SDL_DestroyWindow(appContext->window);
@@ -0,0 +1,363 @@
+//
+//  GBE_Jobs.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_Jobs.h>
+
+#define GBE_JOB_MASK (GBE_JOB_DEQUE_SIZE - 1)
+
+// How many times an idle worker looks for a job before going to sleep.
+#define GBE_JOB_SPINS 64
+
+// The deque follows Chase and Lev's "Dynamic Circular Work-Stealing Deque" (with a fixed
+// size). SDL's atomic loads, stores and compare-and-swaps are all full barriers, which
+// covers the ordering the algorithm needs. The indices are free-running and wrap around;
+// only their difference matters.
+
+static bool PushJob(GBE_JobThread* thread, GBE_Job* job)
+{
+    Uint32 bottom = SDL_GetAtomicU32(&thread->bottom);
+    Uint32 top = SDL_GetAtomicU32(&thread->top);
+    if ((Sint32)(bottom - top) >= GBE_JOB_DEQUE_SIZE) {
+        return false;
+    }
+
+    SDL_SetAtomicPointer((void**)&thread->slots[bottom & GBE_JOB_MASK], job);
+    SDL_SetAtomicU32(&thread->bottom, bottom + 1);
+    return true;
+}
+
+// Takes the job pushed most recently. Only the deque's owner calls this.
+static GBE_Job* PopJob(GBE_JobThread* thread)
+{
+    Uint32 bottom = SDL_GetAtomicU32(&thread->bottom) - 1;
+    SDL_SetAtomicU32(&thread->bottom, bottom);
+    Uint32 top = SDL_GetAtomicU32(&thread->top);
+
+    if ((Sint32)(bottom - top) < 0) {
+        // Empty.
+        SDL_SetAtomicU32(&thread->bottom, top);
+        return NULL;
+    }
+
+    GBE_Job* job = SDL_GetAtomicPointer((void**)&thread->slots[bottom & GBE_JOB_MASK]);
+    if (bottom != top) {
+        return job;
+    }
+
+    // The last job in the deque: a thief could be taking it at the same time, and whoever
+    // moves `top` first gets it.
+    if (!SDL_CompareAndSwapAtomicU32(&thread->top, top, top + 1)) {
+        job = NULL;
+    }
+    SDL_SetAtomicU32(&thread->bottom, top + 1);
+    return job;
+}
+
+// Takes the oldest job from another thread's deque. Gives up rather than retrying if
+// another thief got there first.
+static GBE_Job* StealJob(GBE_JobThread* thread)
+{
+    Uint32 top = SDL_GetAtomicU32(&thread->top);
+    Uint32 bottom = SDL_GetAtomicU32(&thread->bottom);
+    if ((Sint32)(bottom - top) <= 0) {
+        return NULL;
+    }
+
+    GBE_Job* job = SDL_GetAtomicPointer((void**)&thread->slots[top & GBE_JOB_MASK]);
+    if (!SDL_CompareAndSwapAtomicU32(&thread->top, top, top + 1)) {
+        return NULL;
+    }
+    return job;
+}
+
+// Our own newest job, or else the oldest job of another thread, starting somewhere random
+// so thieves spread out.
+static GBE_Job* FindJob(GBE_JobSystem* jobs, GBE_JobThread* self)
+{
+    GBE_Job* job = PopJob(self);
+    if (job != NULL || jobs->numThreads == 1) {
+        return job;
+    }
+
+    self->random ^= self->random << 13;
+    self->random ^= self->random >> 17;
+    self->random ^= self->random << 5;
+    int start = (int)(self->random % (Uint32)jobs->numThreads);
+    for (int i = 0; i < jobs->numThreads; i++) {
+        GBE_JobThread* victim = &jobs->threads[(start + i) % jobs->numThreads];
+        if (victim == self) {
+            continue;
+        }
+
+        job = StealJob(victim);
+        if (job != NULL) {
+            self->stolen++;
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+static void StartJob(GBE_JobSystem* jobs, const GBE_Job* description);
+
+// Runs a GBE_ParallelFor range, first handing off halves of it to other threads until
+// what's left is no bigger than the grain size.
+static void RunRange(GBE_JobSystem* jobs, const GBE_Job* job)
+{
+    GBE_Job half = {
+        .rangeFunction = job->rangeFunction,
+        .data = job->data,
+        .counter = job->counter,
+        .grain = job->grain
+    };
+
+    Uint32 begin = job->begin;
+    Uint32 end = job->end;
+    while (end - begin > job->grain) {
+        Uint32 middle = begin + (end - begin) / 2;
+        half.begin = middle;
+        half.end = end;
+        StartJob(jobs, &half);
+        end = middle;
+    }
+
+    job->rangeFunction(job->data, begin, end);
+}
+
+// Runs a job and counts it off its counter.
+static void RunJob(GBE_JobSystem* jobs, GBE_JobThread* self, const GBE_Job* job)
+{
+    if (job->rangeFunction != NULL) {
+        RunRange(jobs, job);
+    }
+    else {
+        job->function(job->data);
+    }
+
+    self->executed++;
+    if (job->counter != NULL) {
+        SDL_AddAtomicInt(&job->counter->pending, -1);
+    }
+}
+
+// Runs a job taken from a deque, then frees its slot in its owner's ring.
+static void ExecuteJob(GBE_JobSystem* jobs, GBE_JobThread* self, GBE_Job* job)
+{
+    GBE_Job copy = {
+        .function = job->function,
+        .data = job->data,
+        .counter = job->counter,
+        .rangeFunction = job->rangeFunction,
+        .begin = job->begin,
+        .end = job->end,
+        .grain = job->grain
+    };
+    SDL_SetAtomicInt(&job->busy, 0);
+    RunJob(jobs, self, &copy);
+}
+
+static GBE_JobThread* GetCurrentThread(GBE_JobSystem* jobs)
+{
+    GBE_JobThread* self = SDL_GetTLS(&jobs->currentThread);
+    SDL_assert(self != NULL && "Jobs can only be started or waited on from the job system's own threads.");
+    return self;
+}
+
+static void StartJob(GBE_JobSystem* jobs, const GBE_Job* description)
+{
+    GBE_JobThread* self = GetCurrentThread(jobs);
+    if (description->counter != NULL) {
+        SDL_AddAtomicInt(&description->counter->pending, 1);
+    }
+
+    GBE_Job* job = &self->pool[self->nextJob & GBE_JOB_MASK];
+    if (SDL_GetAtomicInt(&job->busy) == 0) {
+        job->function = description->function;
+        job->data = description->data;
+        job->counter = description->counter;
+        job->rangeFunction = description->rangeFunction;
+        job->begin = description->begin;
+        job->end = description->end;
+        job->grain = description->grain;
+        SDL_SetAtomicInt(&job->busy, 1);
+
+        if (PushJob(self, job)) {
+            self->nextJob++;
+            if (SDL_GetAtomicInt(&jobs->sleepers) > 0) {
+                SDL_SignalSemaphore(jobs->wake);
+            }
+            return;
+        }
+        SDL_SetAtomicInt(&job->busy, 0);
+    }
+
+    // Out of room; better to do it now than to wait for some.
+    self->ranInline++;
+    RunJob(jobs, self, description);
+}
+
+static int SDLCALL JobWorker(void* data)
+{
+    GBE_JobThread* self = data;
+    GBE_JobSystem* jobs = self->jobs;
+    SDL_SetTLS(&jobs->currentThread, self, NULL);
+
+    int spins = 0;
+    while (SDL_GetAtomicInt(&jobs->quit) == 0) {
+        GBE_Job* job = FindJob(jobs, self);
+        if (job != NULL) {
+            ExecuteJob(jobs, self, job);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < GBE_JOB_SPINS) {
+            SDL_CPUPauseInstruction();
+            continue;
+        }
+
+        // Announce we're going to sleep before looking one last time, so anything pushed
+        // after that look sees us and wakes us up.
+        SDL_AddAtomicInt(&jobs->sleepers, 1);
+        job = FindJob(jobs, self);
+        if (job == NULL && SDL_GetAtomicInt(&jobs->quit) == 0) {
+            SDL_WaitSemaphore(jobs->wake);
+        }
+        SDL_AddAtomicInt(&jobs->sleepers, -1);
+
+        if (job != NULL) {
+            ExecuteJob(jobs, self, job);
+        }
+        spins = 0;
+    }
+
+    return 0;
+}
+
+bool GBE_CreateJobSystem(int numThreads, GBE_JobSystem* jobs)
+{
+    SDL_assert(jobs != NULL);
+
+    SDL_zerop(jobs);
+    if (numThreads <= 0) {
+        numThreads = SDL_GetNumLogicalCPUCores();
+    }
+    numThreads = SDL_clamp(numThreads, 1, GBE_MAX_JOB_THREADS);
+
+    jobs->threads = SDL_calloc(numThreads, sizeof(GBE_JobThread));
+    jobs->wake = SDL_CreateSemaphore(0);
+    if (jobs->threads == NULL || jobs->wake == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create a job system: %s", SDL_GetError());
+        GBE_DestroyJobSystem(jobs);
+        return false;
+    }
+
+    jobs->numThreads = numThreads;
+    for (int i = 0; i < numThreads; i++) {
+        GBE_JobThread* thread = &jobs->threads[i];
+        thread->jobs = jobs;
+        thread->index = i;
+        thread->random = 0x9e3779b9u * (Uint32)(i + 1);
+    }
+
+    // We're thread 0.
+    SDL_SetTLS(&jobs->currentThread, &jobs->threads[0], NULL);
+
+    for (int i = 1; i < numThreads; i++) {
+        char name[32];
+        SDL_snprintf(name, sizeof(name), "GBE job %d", i);
+        jobs->threads[i].thread = SDL_CreateThread(JobWorker, name, &jobs->threads[i]);
+        if (jobs->threads[i].thread == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to start job thread %d: %s", i, SDL_GetError());
+            GBE_DestroyJobSystem(jobs);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void GBE_DestroyJobSystem(GBE_JobSystem* jobs)
+{
+    SDL_SetAtomicInt(&jobs->quit, 1);
+    if (jobs->threads != NULL) {
+        for (int i = 1; i < jobs->numThreads; i++) {
+            SDL_SignalSemaphore(jobs->wake);
+        }
+        for (int i = 1; i < jobs->numThreads; i++) {
+            if (jobs->threads[i].thread != NULL) {
+                SDL_WaitThread(jobs->threads[i].thread, NULL);
+            }
+        }
+    }
+
+    if (jobs->wake != NULL) {
+        SDL_DestroySemaphore(jobs->wake);
+        SDL_SetTLS(&jobs->currentThread, NULL, NULL);
+    }
+    SDL_free(jobs->threads);
+    SDL_zerop(jobs);
+}
+
+int GBE_GetJobThreadIndex(GBE_JobSystem* jobs)
+{
+    const GBE_JobThread* self = SDL_GetTLS(&jobs->currentThread);
+    return self != NULL ? self->index : -1;
+}
+
+void GBE_RunJob(GBE_JobSystem* jobs, GBE_JobFunction function, void* data, GBE_JobCounter* counter)
+{
+    SDL_assert(function != NULL);
+
+    GBE_Job description = {
+        .function = function,
+        .data = data,
+        .counter = counter
+    };
+    StartJob(jobs, &description);
+}
+
+void GBE_WaitForCounter(GBE_JobSystem* jobs, GBE_JobCounter* counter)
+{
+    GBE_JobThread* self = GetCurrentThread(jobs);
+    while (SDL_GetAtomicInt(&counter->pending) > 0) {
+        GBE_Job* job = FindJob(jobs, self);
+        if (job != NULL) {
+            ExecuteJob(jobs, self, job);
+        }
+        else {
+            SDL_CPUPauseInstruction();
+        }
+    }
+}
+
+void GBE_ParallelFor(GBE_JobSystem* jobs, Uint32 count, Uint32 minGrain, GBE_RangeFunction function, void* data)
+{
+    SDL_assert(function != NULL);
+    if (count == 0) {
+        return;
+    }
+
+    // About four pieces per thread leaves room to even out pieces that take longer than
+    // others.
+    Uint32 grain = count / ((Uint32)jobs->numThreads * 4);
+    grain = SDL_max(grain, SDL_max(minGrain, 1));
+
+    // The calling thread starts on the whole range itself, handing halves of it off as it
+    // goes, then helps with whatever's left.
+    GBE_JobCounter counter;
+    SDL_SetAtomicInt(&counter.pending, 0);
+    GBE_Job root = {
+        .rangeFunction = function,
+        .data = data,
+        .counter = &counter,
+        .begin = 0,
+        .end = count,
+        .grain = grain
+    };
+    RunRange(jobs, &root);
+    GBE_WaitForCounter(jobs, &counter);
+}
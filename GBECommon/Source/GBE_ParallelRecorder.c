@@ -0,0 +1,272 @@
+//
+//  GBE_ParallelRecorder.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_ParallelRecorder.h>
+#include <GBECommon/GBE_ReleaseQueue.h>
+
+// Begins chunk `index`'s render pass. Only the first chunk clears, and cycles the targets
+// while it's at it; the others load what the chunks before them drew. The last one
+// doesn't need the depth buffer kept afterwards.
+static bool BeginChunkPass(GBE_ParallelRecorder* recorder, int index, int numChunks, GBE_RenderPass* renderPass)
+{
+    GBE_RecordChunk* chunk = &recorder->chunks[index];
+    bool first = index == 0;
+
+    SDL_GPUColorTargetInfo colorInfo = {
+        .texture = recorder->colorTarget,
+        .clear_color = recorder->clearColor,
+        .load_op = first ? SDL_GPU_LOADOP_CLEAR : SDL_GPU_LOADOP_LOAD,
+        .store_op = SDL_GPU_STOREOP_STORE,
+        .cycle = first
+    };
+    SDL_GPUDepthStencilTargetInfo depthInfo = {
+        .texture = recorder->depthTarget,
+        .clear_depth = 1.0f,
+        .load_op = first ? SDL_GPU_LOADOP_CLEAR : SDL_GPU_LOADOP_LOAD,
+        .store_op = index == numChunks - 1 ? SDL_GPU_STOREOP_DONT_CARE : SDL_GPU_STOREOP_STORE,
+        .stencil_load_op = SDL_GPU_LOADOP_DONT_CARE,
+        .stencil_store_op = SDL_GPU_STOREOP_DONT_CARE,
+        .cycle = first
+    };
+
+    if (!GBE_BeginRenderPass(renderPass, chunk->commandBuffer, &colorInfo, 1, recorder->depthTarget != NULL ? &depthInfo : NULL)) {
+        chunk->failed = true;
+        return false;
+    }
+    renderPass->filter = recorder->filter;
+    return true;
+}
+
+// Acquires chunk `index`'s command buffer on the calling thread, which is the one that has
+// to record and submit it, and begins its render pass. Returns false, with the command
+// buffer given back, if either fails.
+static bool BeginChunk(GBE_ParallelRecorder* recorder, int index, GBE_RenderPass* renderPass)
+{
+    GBE_RecordChunk* chunk = &recorder->chunks[index];
+    chunk->commandBuffer = SDL_AcquireGPUCommandBuffer(recorder->context->device);
+    if (chunk->commandBuffer == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_AcquireGPUCommandBuffer failed: %s", SDL_GetError());
+        chunk->failed = true;
+        return false;
+    }
+
+    if (!BeginChunkPass(recorder, index, recorder->numActiveChunks, renderPass)) {
+        SDL_CancelGPUCommandBuffer(chunk->commandBuffer);
+        chunk->commandBuffer = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Records a chunk's draws into its render pass (if it began) and ends it, then waits for
+// the chunk before it to be submitted, submits this one and lets the next one go. A chunk
+// that failed still takes its turn, so the ones after it aren't left waiting.
+static void FinishChunk(GBE_ParallelRecorder* recorder, int index, GBE_RenderPass* renderPass, bool began)
+{
+    GBE_RecordChunk* chunk = &recorder->chunks[index];
+    if (began) {
+        Uint64 recordBegan = SDL_GetTicksNS();
+        recorder->function(recorder->userData, renderPass, chunk->first, chunk->count);
+        GBE_EndRenderPass(renderPass);
+
+        chunk->issued = renderPass->issued;
+        chunk->skipped = renderPass->skipped;
+        chunk->draws = renderPass->draws;
+        chunk->recordNS = SDL_GetTicksNS() - recordBegan;
+    }
+
+    if (index > 0) {
+        SDL_WaitSemaphore(chunk->turn);
+    }
+    if (chunk->commandBuffer != NULL) {
+        if (!SDL_SubmitGPUCommandBuffer(chunk->commandBuffer)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_SubmitGPUCommandBuffer failed: %s", SDL_GetError());
+            chunk->failed = true;
+        }
+        chunk->commandBuffer = NULL;
+    }
+    if (index + 1 < recorder->numActiveChunks) {
+        SDL_SignalSemaphore(recorder->chunks[index + 1].turn);
+    }
+}
+
+static int SDLCALL RecordWorker(void* data)
+{
+    GBE_RecordChunk* chunk = data;
+    GBE_ParallelRecorder* recorder = chunk->recorder;
+    int index = (int)(chunk - recorder->chunks);
+
+    for (;;) {
+        SDL_WaitSemaphore(chunk->start);
+        if (SDL_GetAtomicInt(&recorder->quit) != 0) {
+            break;
+        }
+
+        GBE_RenderPass renderPass;
+        bool began = BeginChunk(recorder, index, &renderPass);
+        FinishChunk(recorder, index, &renderPass, began);
+        SDL_SignalSemaphore(recorder->done);
+    }
+
+    return 0;
+}
+
+bool GBE_CreateParallelRecorder(GBE_Context* context, int numThreads, GBE_ParallelRecorder* recorder)
+{
+    SDL_assert(context != NULL);
+    SDL_assert(recorder != NULL);
+
+    SDL_zerop(recorder);
+    recorder->context = context;
+    recorder->numThreads = SDL_clamp(numThreads, 1, GBE_MAX_RECORD_THREADS);
+
+    recorder->done = SDL_CreateSemaphore(0);
+    if (recorder->done == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create a semaphore: %s", SDL_GetError());
+        return false;
+    }
+
+    // The first chunk is always recorded by the caller, so it doesn't get a thread.
+    for (int i = 1; i < recorder->numThreads; i++) {
+        GBE_RecordChunk* chunk = &recorder->chunks[i];
+        chunk->recorder = recorder;
+        chunk->start = SDL_CreateSemaphore(0);
+        chunk->turn = SDL_CreateSemaphore(0);
+
+        char name[32];
+        SDL_snprintf(name, sizeof(name), "GBE record %d", i);
+        chunk->thread = chunk->start != NULL && chunk->turn != NULL ? SDL_CreateThread(RecordWorker, name, chunk) : NULL;
+        if (chunk->thread == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to start recording thread %d: %s", i, SDL_GetError());
+            GBE_DestroyParallelRecorder(recorder);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void GBE_DestroyParallelRecorder(GBE_ParallelRecorder* recorder)
+{
+    SDL_SetAtomicInt(&recorder->quit, 1);
+    for (int i = 1; i < GBE_MAX_RECORD_THREADS; i++) {
+        GBE_RecordChunk* chunk = &recorder->chunks[i];
+        if (chunk->thread != NULL) {
+            SDL_SignalSemaphore(chunk->start);
+            SDL_WaitThread(chunk->thread, NULL);
+        }
+        if (chunk->start != NULL) {
+            SDL_DestroySemaphore(chunk->start);
+        }
+        if (chunk->turn != NULL) {
+            SDL_DestroySemaphore(chunk->turn);
+        }
+    }
+
+    if (recorder->done != NULL) {
+        SDL_DestroySemaphore(recorder->done);
+    }
+    if (recorder->context != NULL) {
+        GBE_DeferRelease(recorder->context, GBE_RESOURCE_TEXTURE, recorder->colorTarget);
+    }
+    SDL_zerop(recorder);
+}
+
+// Makes sure the color texture the chunks draw into matches the frame's size, replacing
+// it through the release queue if not, since frames in flight may still be using it.
+static bool PrepareColorTarget(GBE_ParallelRecorder* recorder, GBE_Frame* frame)
+{
+    if (recorder->colorTarget != NULL && recorder->width == frame->width && recorder->height == frame->height) {
+        return true;
+    }
+
+    GBE_DeferRelease(recorder->context, GBE_RESOURCE_TEXTURE, recorder->colorTarget);
+
+    // It's drawn into, then blitted from, which counts as sampling it.
+    SDL_GPUTextureCreateInfo createInfo = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = GBE_GetTargetFormat(recorder->context),
+        .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER,
+        .width = frame->width,
+        .height = frame->height,
+        .layer_count_or_depth = 1,
+        .num_levels = 1
+    };
+    recorder->colorTarget = SDL_CreateGPUTexture(recorder->context->device, &createInfo);
+    if (recorder->colorTarget == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create a %ux%u texture to record into: %s", frame->width, frame->height, SDL_GetError());
+        return false;
+    }
+
+    recorder->width = frame->width;
+    recorder->height = frame->height;
+    return true;
+}
+
+bool GBE_RecordInParallel(GBE_ParallelRecorder* recorder, GBE_Frame* frame, SDL_FColor clearColor, bool filter,
+    Uint32 count, GBE_RecordFunction function, void* userData)
+{
+    SDL_assert(function != NULL);
+
+    if (frame->target == NULL) {
+        return true;
+    }
+    if (!PrepareColorTarget(recorder, frame)) {
+        return false;
+    }
+
+    recorder->function = function;
+    recorder->userData = userData;
+    recorder->clearColor = clearColor;
+    recorder->depthTarget = frame->depthTarget;
+    recorder->filter = filter;
+
+    // No more chunks than draws, but always at least one so the targets get cleared.
+    int numChunks = (int)SDL_min((Uint32)recorder->numThreads, SDL_max(count, 1));
+    recorder->numActiveChunks = numChunks;
+    for (int i = 0; i < numChunks; i++) {
+        GBE_RecordChunk* chunk = &recorder->chunks[i];
+        chunk->first = (Uint32)((Uint64)count * i / numChunks);
+        chunk->count = (Uint32)((Uint64)count * (i + 1) / numChunks) - chunk->first;
+        chunk->failed = false;
+        chunk->issued = chunk->skipped = chunk->draws = 0;
+        chunk->recordNS = 0;
+    }
+
+    // The first chunk's pass begins before any worker's does, so the targets have been
+    // cycled by the time the others load them. Every chunk has been submitted, in order,
+    // once the workers are done.
+    GBE_RenderPass renderPass;
+    bool began = BeginChunk(recorder, 0, &renderPass);
+    for (int i = 1; i < numChunks; i++) {
+        SDL_SignalSemaphore(recorder->chunks[i].start);
+    }
+    FinishChunk(recorder, 0, &renderPass, began);
+    for (int i = 1; i < numChunks; i++) {
+        SDL_WaitSemaphore(recorder->done);
+    }
+
+    bool ok = true;
+    recorder->issued = recorder->skipped = recorder->draws = 0;
+    recorder->slowestChunkNS = 0;
+    for (int i = 0; i < numChunks; i++) {
+        GBE_RecordChunk* chunk = &recorder->chunks[i];
+        ok = ok && !chunk->failed;
+
+        recorder->issued += chunk->issued;
+        recorder->skipped += chunk->skipped;
+        recorder->draws += chunk->draws;
+        recorder->slowestChunkNS = SDL_max(recorder->slowestChunkNS, chunk->recordNS);
+    }
+
+    SDL_GPUBlitInfo blitInfo = {
+        .source = { .texture = recorder->colorTarget, .w = recorder->width, .h = recorder->height },
+        .destination = { .texture = frame->target, .w = frame->width, .h = frame->height },
+        .load_op = SDL_GPU_LOADOP_DONT_CARE,
+        .filter = SDL_GPU_FILTER_NEAREST
+    };
+    SDL_BlitGPUTexture(frame->commandBuffer, &blitInfo);
+    return ok;
+}
@@ -0,0 +1,148 @@
+//
+//  GBE_Pipeline.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_Pipeline.h>
+
+void GBE_InitPipelineDesc(GBE_PipelineDesc* desc, GBE_PipelinePreset preset,
+    SDL_GPUTextureFormat colorFormat, SDL_GPUTextureFormat depthFormat)
+{
+    SDL_assert(desc != NULL);
+
+    SDL_zerop(desc);
+    desc->vertexShader.stage = SDL_GPU_SHADERSTAGE_VERTEX;
+    desc->fragmentShader.stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
+    desc->primitiveType = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
+    desc->rasterizerState.fill_mode = SDL_GPU_FILLMODE_FILL;
+    desc->rasterizerState.cull_mode = SDL_GPU_CULLMODE_BACK;
+    desc->rasterizerState.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE;
+    desc->colorFormat = colorFormat;
+    desc->depthFormat = depthFormat;
+
+    SDL_GPUColorTargetBlendState* blend = &desc->blendState;
+    blend->color_blend_op = SDL_GPU_BLENDOP_ADD;
+    blend->alpha_blend_op = SDL_GPU_BLENDOP_ADD;
+
+    switch (preset) {
+    case GBE_PIPELINE_ALPHA_BLEND:
+        blend->enable_blend = true;
+        blend->src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
+        blend->dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+        blend->src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        blend->dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+        break;
+
+    case GBE_PIPELINE_ADDITIVE:
+        blend->enable_blend = true;
+        blend->src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
+        blend->dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        blend->src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ZERO;
+        blend->dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        break;
+
+    default:
+        // Blending off entirely, rather than blending with factors that happen to
+        // overwrite: the GPU can skip reading the target back.
+        blend->enable_blend = false;
+        blend->src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        blend->dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ZERO;
+        blend->src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        blend->dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ZERO;
+        break;
+    }
+
+    // Everything tests against the depth buffer, but only opaque things write to it.
+    // LESS_OR_EQUAL lets blended passes draw over the opaque surfaces they decorate.
+    if (depthFormat != SDL_GPU_TEXTUREFORMAT_INVALID) {
+        desc->depthStencilState.enable_depth_test = true;
+        desc->depthStencilState.enable_depth_write = preset == GBE_PIPELINE_OPAQUE;
+        desc->depthStencilState.compare_op = preset == GBE_PIPELINE_OPAQUE ? SDL_GPU_COMPAREOP_LESS : SDL_GPU_COMPAREOP_LESS_OR_EQUAL;
+    }
+}
+
+bool GBE_AddPipelineVertexBuffer(GBE_PipelineDesc* desc, Uint32 slot, Uint32 pitch, SDL_GPUVertexInputRate inputRate)
+{
+    if (desc->numVertexBuffers >= GBE_MAX_PIPELINE_VERTEX_BUFFERS) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Pipeline descriptions can only have %d vertex buffers.", GBE_MAX_PIPELINE_VERTEX_BUFFERS);
+        return false;
+    }
+
+    desc->vertexBuffers[desc->numVertexBuffers++] = (SDL_GPUVertexBufferDescription) {
+        .slot = slot,
+        .pitch = pitch,
+        .input_rate = inputRate,
+        .instance_step_rate = 0
+    };
+    return true;
+}
+
+bool GBE_AddPipelineVertexAttribute(GBE_PipelineDesc* desc, Uint32 bufferSlot, Uint32 location,
+    SDL_GPUVertexElementFormat format, Uint32 offset)
+{
+    if (desc->numVertexAttributes >= GBE_MAX_PIPELINE_VERTEX_ATTRIBUTES) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Pipeline descriptions can only have %d vertex attributes.", GBE_MAX_PIPELINE_VERTEX_ATTRIBUTES);
+        return false;
+    }
+
+    desc->vertexAttributes[desc->numVertexAttributes++] = (SDL_GPUVertexAttribute) {
+        .location = location,
+        .buffer_slot = bufferSlot,
+        .format = format,
+        .offset = offset
+    };
+    return true;
+}
+
+SDL_GPUGraphicsPipeline* GBE_CreatePipeline(GBE_Context* context, const GBE_PipelineDesc* desc)
+{
+    SDL_assert(context != NULL);
+    SDL_assert(desc != NULL);
+
+    SDL_GPUShader* vertexShader = GBE_LoadShader(context, &desc->vertexShader);
+    if (vertexShader == NULL) {
+        return NULL;
+    }
+
+    SDL_GPUShader* fragmentShader = GBE_LoadShader(context, &desc->fragmentShader);
+    if (fragmentShader == NULL) {
+        SDL_ReleaseGPUShader(context->device, vertexShader);
+        return NULL;
+    }
+
+    SDL_GPUColorTargetDescription colorTarget = {
+        .format = desc->colorFormat,
+        .blend_state = desc->blendState
+    };
+
+    bool hasDepth = desc->depthFormat != SDL_GPU_TEXTUREFORMAT_INVALID;
+    SDL_GPUGraphicsPipelineCreateInfo createInfo = {
+        .vertex_shader = vertexShader,
+        .fragment_shader = fragmentShader,
+        .vertex_input_state = {
+            .vertex_buffer_descriptions = desc->vertexBuffers,
+            .num_vertex_buffers = desc->numVertexBuffers,
+            .vertex_attributes = desc->vertexAttributes,
+            .num_vertex_attributes = desc->numVertexAttributes
+        },
+        .primitive_type = desc->primitiveType,
+        .rasterizer_state = desc->rasterizerState,
+        .depth_stencil_state = desc->depthStencilState,
+        .target_info = {
+            .color_target_descriptions = &colorTarget,
+            .num_color_targets = 1,
+            .depth_stencil_format = hasDepth ? desc->depthFormat : SDL_GPU_TEXTUREFORMAT_INVALID,
+            .has_depth_stencil_target = hasDepth
+        }
+    };
+
+    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(context->device, &createInfo);
+    if (pipeline == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create graphics pipeline: %s", SDL_GetError());
+    }
+
+    // The pipeline holds on to what it needs from the shaders.
+    SDL_ReleaseGPUShader(context->device, vertexShader);
+    SDL_ReleaseGPUShader(context->device, fragmentShader);
+    return pipeline;
+}
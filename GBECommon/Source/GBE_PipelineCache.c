@@ -0,0 +1,583 @@
+//
+//  GBE_PipelineCache.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_PipelineCache.h>
+#include <GBECommon/GBE_ReleaseQueue.h>
+
+// The biggest a canonical description can get: a couple of hundred 32-bit values with
+// every vertex buffer and attribute in use, plus the shader names.
+#define GBE_MAX_PIPELINE_KEY_SIZE 2048
+
+// Saved pipeline cache files start with this. Change the last character whenever the
+// canonical encoding changes, so old files are ignored rather than misread.
+static const char kCacheFileMagic[8] = { 'G', 'B', 'E', 'P', 'I', 'P', 'E', '1' };
+
+typedef struct GBE_CachedPipeline {
+    // The canonical encoding of the pipeline's description, and its hash.
+    Uint8* key;
+    Uint32 keySize;
+    Uint64 hash;
+
+    SDL_GPUGraphicsPipeline* pipeline;
+    int refCount;
+} GBE_CachedPipeline;
+
+// Turns a description into its canonical byte encoding, or a byte encoding back into a
+// description, with the same code walking the fields either way so the two can't drift
+// apart. Every value is stored as 32 bits, little endian; strings are stored as their
+// length plus one (0 for NULL), then their bytes and a terminator, padded to 4 bytes, so
+// decoded strings can point straight into the encoding.
+typedef struct KeyCodec {
+    Uint8* data;
+    Uint32 size;
+    Uint32 capacity;
+    bool decoding;
+    bool failed;
+} KeyCodec;
+
+static void CodeValue(KeyCodec* codec, Uint32* value)
+{
+    if (codec->failed || codec->size + 4 > codec->capacity) {
+        codec->failed = true;
+        return;
+    }
+
+    if (codec->decoding) {
+        Uint32 stored;
+        SDL_memcpy(&stored, codec->data + codec->size, 4);
+        *value = SDL_Swap32LE(stored);
+    }
+    else {
+        Uint32 stored = SDL_Swap32LE(*value);
+        SDL_memcpy(codec->data + codec->size, &stored, 4);
+    }
+    codec->size += 4;
+}
+
+static void CodeFloat(KeyCodec* codec, float* value)
+{
+    Uint32 bits;
+    SDL_memcpy(&bits, value, 4);
+    CodeValue(codec, &bits);
+    SDL_memcpy(value, &bits, 4);
+}
+
+static void CodeString(KeyCodec* codec, const char** string)
+{
+    Uint32 length = *string != NULL ? (Uint32)SDL_strlen(*string) + 1 : 0;
+    CodeValue(codec, &length);
+    if (codec->failed || length == 0) {
+        *string = NULL;
+        return;
+    }
+
+    Uint32 paddedSize = (length + 3) & ~3u;
+    if (codec->size + paddedSize > codec->capacity) {
+        codec->failed = true;
+        return;
+    }
+
+    if (codec->decoding) {
+        const char* stored = (const char*)codec->data + codec->size;
+        if (stored[length - 1] != '\0') {
+            codec->failed = true;
+            return;
+        }
+        *string = stored;
+    }
+    else {
+        SDL_memset(codec->data + codec->size, 0, paddedSize);
+        SDL_memcpy(codec->data + codec->size, *string, length - 1);
+    }
+    codec->size += paddedSize;
+}
+
+// Enums, bools and small integers all go through CodeValue as 32-bit values.
+#define CODE_FIELD(codec, field) do { \
+        Uint32 value_ = (Uint32)(field); \
+        CodeValue((codec), &value_); \
+        (field) = value_; \
+    } while (0)
+
+static void CodeShader(KeyCodec* codec, GBE_LoadShaderInfo* shader)
+{
+    CodeString(codec, &shader->path);
+    CODE_FIELD(codec, shader->stage);
+    CODE_FIELD(codec, shader->features);
+    CodeString(codec, &shader->entryPoint);
+    CODE_FIELD(codec, shader->samplerCount);
+    CODE_FIELD(codec, shader->uniformBufferCount);
+    CODE_FIELD(codec, shader->storageBufferCount);
+    CODE_FIELD(codec, shader->storageTextureCount);
+}
+
+static void CodeStencilOps(KeyCodec* codec, SDL_GPUStencilOpState* state)
+{
+    CODE_FIELD(codec, state->fail_op);
+    CODE_FIELD(codec, state->pass_op);
+    CODE_FIELD(codec, state->depth_fail_op);
+    CODE_FIELD(codec, state->compare_op);
+}
+
+static bool CodeDesc(KeyCodec* codec, GBE_PipelineDesc* desc)
+{
+    CodeShader(codec, &desc->vertexShader);
+    CodeShader(codec, &desc->fragmentShader);
+
+    CODE_FIELD(codec, desc->numVertexBuffers);
+    if (desc->numVertexBuffers > GBE_MAX_PIPELINE_VERTEX_BUFFERS) {
+        return false;
+    }
+    for (Uint32 i = 0; i < desc->numVertexBuffers; i++) {
+        SDL_GPUVertexBufferDescription* buffer = &desc->vertexBuffers[i];
+        CODE_FIELD(codec, buffer->slot);
+        CODE_FIELD(codec, buffer->pitch);
+        CODE_FIELD(codec, buffer->input_rate);
+        CODE_FIELD(codec, buffer->instance_step_rate);
+    }
+
+    CODE_FIELD(codec, desc->numVertexAttributes);
+    if (desc->numVertexAttributes > GBE_MAX_PIPELINE_VERTEX_ATTRIBUTES) {
+        return false;
+    }
+    for (Uint32 i = 0; i < desc->numVertexAttributes; i++) {
+        SDL_GPUVertexAttribute* attribute = &desc->vertexAttributes[i];
+        CODE_FIELD(codec, attribute->location);
+        CODE_FIELD(codec, attribute->buffer_slot);
+        CODE_FIELD(codec, attribute->format);
+        CODE_FIELD(codec, attribute->offset);
+    }
+
+    CODE_FIELD(codec, desc->primitiveType);
+
+    SDL_GPURasterizerState* rasterizer = &desc->rasterizerState;
+    CODE_FIELD(codec, rasterizer->fill_mode);
+    CODE_FIELD(codec, rasterizer->cull_mode);
+    CODE_FIELD(codec, rasterizer->front_face);
+    CodeFloat(codec, &rasterizer->depth_bias_constant_factor);
+    CodeFloat(codec, &rasterizer->depth_bias_clamp);
+    CodeFloat(codec, &rasterizer->depth_bias_slope_factor);
+    CODE_FIELD(codec, rasterizer->enable_depth_bias);
+    CODE_FIELD(codec, rasterizer->enable_depth_clip);
+
+    CODE_FIELD(codec, desc->colorFormat);
+    SDL_GPUColorTargetBlendState* blend = &desc->blendState;
+    CODE_FIELD(codec, blend->src_color_blendfactor);
+    CODE_FIELD(codec, blend->dst_color_blendfactor);
+    CODE_FIELD(codec, blend->color_blend_op);
+    CODE_FIELD(codec, blend->src_alpha_blendfactor);
+    CODE_FIELD(codec, blend->dst_alpha_blendfactor);
+    CODE_FIELD(codec, blend->alpha_blend_op);
+    CODE_FIELD(codec, blend->color_write_mask);
+    CODE_FIELD(codec, blend->enable_blend);
+    CODE_FIELD(codec, blend->enable_color_write_mask);
+
+    CODE_FIELD(codec, desc->depthFormat);
+    SDL_GPUDepthStencilState* depthStencil = &desc->depthStencilState;
+    CODE_FIELD(codec, depthStencil->compare_op);
+    CodeStencilOps(codec, &depthStencil->back_stencil_state);
+    CodeStencilOps(codec, &depthStencil->front_stencil_state);
+    CODE_FIELD(codec, depthStencil->compare_mask);
+    CODE_FIELD(codec, depthStencil->write_mask);
+    CODE_FIELD(codec, depthStencil->enable_depth_test);
+    CODE_FIELD(codec, depthStencil->enable_depth_write);
+    CODE_FIELD(codec, depthStencil->enable_stencil_test);
+
+    return !codec->failed;
+}
+
+// Puts a description in the one form every equivalent description shares.
+static void Canonicalize(GBE_PipelineDesc* desc)
+{
+    // Insertion sorts; there are only ever a handful of these.
+    for (Uint32 i = 1; i < desc->numVertexBuffers; i++) {
+        SDL_GPUVertexBufferDescription buffer = desc->vertexBuffers[i];
+        Uint32 j = i;
+        for (; j > 0 && desc->vertexBuffers[j - 1].slot > buffer.slot; j--) {
+            desc->vertexBuffers[j] = desc->vertexBuffers[j - 1];
+        }
+        desc->vertexBuffers[j] = buffer;
+    }
+
+    for (Uint32 i = 1; i < desc->numVertexAttributes; i++) {
+        SDL_GPUVertexAttribute attribute = desc->vertexAttributes[i];
+        Uint32 j = i;
+        for (; j > 0 && desc->vertexAttributes[j - 1].location > attribute.location; j--) {
+            desc->vertexAttributes[j] = desc->vertexAttributes[j - 1];
+        }
+        desc->vertexAttributes[j] = attribute;
+    }
+
+    // SDL ignores the step rate; it's always 1.
+    for (Uint32 i = 0; i < desc->numVertexBuffers; i++) {
+        desc->vertexBuffers[i].instance_step_rate = 0;
+    }
+
+    if (!desc->rasterizerState.enable_depth_bias) {
+        desc->rasterizerState.depth_bias_constant_factor = 0;
+        desc->rasterizerState.depth_bias_clamp = 0;
+        desc->rasterizerState.depth_bias_slope_factor = 0;
+    }
+
+    SDL_GPUColorTargetBlendState* blend = &desc->blendState;
+    if (!blend->enable_blend) {
+        blend->src_color_blendfactor = SDL_GPU_BLENDFACTOR_INVALID;
+        blend->dst_color_blendfactor = SDL_GPU_BLENDFACTOR_INVALID;
+        blend->color_blend_op = SDL_GPU_BLENDOP_INVALID;
+        blend->src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_INVALID;
+        blend->dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_INVALID;
+        blend->alpha_blend_op = SDL_GPU_BLENDOP_INVALID;
+    }
+    if (!blend->enable_color_write_mask) {
+        blend->color_write_mask = 0;
+    }
+
+    SDL_GPUDepthStencilState* depthStencil = &desc->depthStencilState;
+    if (desc->depthFormat == SDL_GPU_TEXTUREFORMAT_INVALID) {
+        SDL_zerop(depthStencil);
+    }
+    if (!depthStencil->enable_depth_test) {
+        depthStencil->enable_depth_write = false;
+        depthStencil->compare_op = SDL_GPU_COMPAREOP_INVALID;
+    }
+    if (!depthStencil->enable_stencil_test) {
+        SDL_zero(depthStencil->back_stencil_state);
+        SDL_zero(depthStencil->front_stencil_state);
+        depthStencil->compare_mask = 0;
+        depthStencil->write_mask = 0;
+    }
+}
+
+// FNV-1a; plenty for telling a few hundred descriptions apart before comparing bytes.
+static Uint64 HashKey(const Uint8* key, Uint32 keySize)
+{
+    Uint64 hash = 0xcbf29ce484222325ull;
+    for (Uint32 i = 0; i < keySize; i++) {
+        hash = (hash ^ key[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static bool EncodeKey(const GBE_PipelineDesc* desc, Uint8* key, Uint32* keySize)
+{
+    GBE_PipelineDesc canonical = *desc;
+    Canonicalize(&canonical);
+
+    KeyCodec codec = { .data = key, .capacity = GBE_MAX_PIPELINE_KEY_SIZE };
+    if (!CodeDesc(&codec, &canonical)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Pipeline description is too big to cache.");
+        return false;
+    }
+
+    *keySize = codec.size;
+    return true;
+}
+
+static GBE_CachedPipeline* FindEntry(GBE_PipelineCache* cache, const Uint8* key, Uint32 keySize, Uint64 hash)
+{
+    if (cache->numSlots == 0) {
+        return NULL;
+    }
+
+    Uint32 mask = (Uint32)cache->numSlots - 1;
+    for (Uint32 i = (Uint32)hash & mask; cache->slots[i] != NULL; i = (i + 1) & mask) {
+        GBE_CachedPipeline* entry = cache->slots[i];
+        if (entry->hash == hash && entry->keySize == keySize && SDL_memcmp(entry->key, key, keySize) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void InsertSlot(GBE_PipelineCache* cache, GBE_CachedPipeline* entry)
+{
+    Uint32 mask = (Uint32)cache->numSlots - 1;
+    Uint32 i = (Uint32)entry->hash & mask;
+    while (cache->slots[i] != NULL) {
+        i = (i + 1) & mask;
+    }
+    cache->slots[i] = entry;
+}
+
+// Takes an entry out of the hash table. Rather than leaving a marker behind, entries
+// further along the same run slide back into the gap if their home slot is at or before
+// it, so every entry can still be reached from its home slot without passing an empty one.
+static void RemoveSlot(GBE_PipelineCache* cache, GBE_CachedPipeline* entry)
+{
+    Uint32 mask = (Uint32)cache->numSlots - 1;
+    Uint32 gap = (Uint32)entry->hash & mask;
+    while (cache->slots[gap] != entry) {
+        gap = (gap + 1) & mask;
+    }
+
+    for (Uint32 next = (gap + 1) & mask; cache->slots[next] != NULL; next = (next + 1) & mask) {
+        Uint32 home = (Uint32)cache->slots[next]->hash & mask;
+        if (((next - home) & mask) >= ((next - gap) & mask)) {
+            cache->slots[gap] = cache->slots[next];
+            gap = next;
+        }
+    }
+    cache->slots[gap] = NULL;
+}
+
+// Makes sure there's room for one more entry in the hash table without it getting more
+// than 3/4 full, rebuilding it twice the size if not.
+static bool ReserveSlot(GBE_PipelineCache* cache)
+{
+    if ((cache->numEntries + 1) * 4 <= cache->numSlots * 3) {
+        return true;
+    }
+
+    int numSlots = cache->numSlots > 0 ? cache->numSlots * 2 : 32;
+    GBE_CachedPipeline** slots = SDL_calloc(numSlots, sizeof(GBE_CachedPipeline*));
+    if (slots == NULL) {
+        return false;
+    }
+
+    SDL_free(cache->slots);
+    cache->slots = slots;
+    cache->numSlots = numSlots;
+    for (int i = 0; i < cache->numEntries; i++) {
+        InsertSlot(cache, cache->entries[i]);
+    }
+    return true;
+}
+
+static GBE_CachedPipeline* AddEntry(GBE_PipelineCache* cache, const Uint8* key, Uint32 keySize, Uint64 hash,
+    SDL_GPUGraphicsPipeline* pipeline)
+{
+    if (!ReserveSlot(cache)) {
+        return NULL;
+    }
+
+    if (cache->numEntries == cache->maxEntries) {
+        int maxEntries = cache->maxEntries > 0 ? cache->maxEntries * 2 : 16;
+        GBE_CachedPipeline** entries = SDL_realloc(cache->entries, sizeof(GBE_CachedPipeline*) * maxEntries);
+        if (entries == NULL) {
+            return NULL;
+        }
+        cache->entries = entries;
+        cache->maxEntries = maxEntries;
+    }
+
+    GBE_CachedPipeline* entry = SDL_calloc(1, sizeof(GBE_CachedPipeline));
+    Uint8* entryKey = SDL_malloc(keySize);
+    if (entry == NULL || entryKey == NULL) {
+        SDL_free(entry);
+        SDL_free(entryKey);
+        return NULL;
+    }
+
+    SDL_memcpy(entryKey, key, keySize);
+    entry->key = entryKey;
+    entry->keySize = keySize;
+    entry->hash = hash;
+    entry->pipeline = pipeline;
+    cache->entries[cache->numEntries++] = entry;
+    InsertSlot(cache, entry);
+    return entry;
+}
+
+static void RemoveEntry(GBE_Context* context, int index)
+{
+    GBE_PipelineCache* cache = &context->pipelineCache;
+    GBE_CachedPipeline* entry = cache->entries[index];
+    GBE_DeferRelease(context, GBE_RESOURCE_GRAPHICS_PIPELINE, entry->pipeline);
+    RemoveSlot(cache, entry);
+    SDL_free(entry->key);
+    SDL_free(entry);
+    cache->entries[index] = cache->entries[--cache->numEntries];
+}
+
+SDL_GPUGraphicsPipeline* GBE_AcquireCachedPipeline(GBE_Context* context, const GBE_PipelineDesc* desc)
+{
+    SDL_assert(context != NULL);
+    SDL_assert(desc != NULL);
+
+    GBE_PipelineCache* cache = &context->pipelineCache;
+    Uint8 key[GBE_MAX_PIPELINE_KEY_SIZE];
+    Uint32 keySize;
+    if (!EncodeKey(desc, key, &keySize)) {
+        return NULL;
+    }
+
+    Uint64 hash = HashKey(key, keySize);
+    GBE_CachedPipeline* entry = FindEntry(cache, key, keySize, hash);
+    if (entry != NULL) {
+        cache->hits++;
+        entry->refCount++;
+        return entry->pipeline;
+    }
+
+    cache->misses++;
+    SDL_GPUGraphicsPipeline* pipeline = GBE_CreatePipeline(context, desc);
+    if (pipeline == NULL) {
+        return NULL;
+    }
+
+    entry = AddEntry(cache, key, keySize, hash, pipeline);
+    if (entry == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory caching a pipeline.");
+        SDL_ReleaseGPUGraphicsPipeline(context->device, pipeline);
+        return NULL;
+    }
+
+    entry->refCount = 1;
+    return pipeline;
+}
+
+void GBE_ReleaseCachedPipeline(GBE_Context* context, SDL_GPUGraphicsPipeline* pipeline)
+{
+    if (pipeline == NULL) {
+        return;
+    }
+
+    GBE_PipelineCache* cache = &context->pipelineCache;
+    for (int i = 0; i < cache->numEntries; i++) {
+        GBE_CachedPipeline* entry = cache->entries[i];
+        if (entry->pipeline == pipeline) {
+            if (entry->refCount > 0) {
+                entry->refCount--;
+            }
+            else {
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Cached pipeline released more times than it was acquired.");
+            }
+            return;
+        }
+    }
+
+    SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "GBE_ReleaseCachedPipeline was given a pipeline that isn't cached.");
+}
+
+int GBE_TrimPipelineCache(GBE_Context* context)
+{
+    GBE_PipelineCache* cache = &context->pipelineCache;
+    int trimmed = 0;
+    for (int i = cache->numEntries - 1; i >= 0; i--) {
+        if (cache->entries[i]->refCount == 0) {
+            RemoveEntry(context, i);
+            trimmed++;
+        }
+    }
+    return trimmed;
+}
+
+bool GBE_SavePipelineCache(GBE_Context* context, const char* path)
+{
+    GBE_PipelineCache* cache = &context->pipelineCache;
+    SDL_IOStream* stream = SDL_IOFromFile(path, "wb");
+    if (stream == NULL) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't save the pipeline cache to '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    bool written = SDL_WriteIO(stream, kCacheFileMagic, sizeof(kCacheFileMagic)) == sizeof(kCacheFileMagic);
+    for (int i = 0; i < cache->numEntries && written; i++) {
+        GBE_CachedPipeline* entry = cache->entries[i];
+        written = SDL_WriteU32LE(stream, entry->keySize) && SDL_WriteIO(stream, entry->key, entry->keySize) == entry->keySize;
+    }
+
+    if (!SDL_CloseIO(stream) || !written) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't save the pipeline cache to '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    SDL_Log("Saved %d pipeline descriptions to '%s'.", cache->numEntries, path);
+    return true;
+}
+
+bool GBE_PrewarmPipelineCache(GBE_Context* context, const char* path)
+{
+    size_t fileSize;
+    void* file = SDL_LoadFile(path, &fileSize);
+    return GBE_PrewarmPipelineCacheFromFile(context, path, file, fileSize);
+}
+
+bool GBE_PrewarmPipelineCacheFromFile(GBE_Context* context, const char* path, void* fileData, size_t fileSize)
+{
+    GBE_PipelineCache* cache = &context->pipelineCache;
+    Uint8* file = fileData;
+    if (file == NULL) {
+        SDL_Log("No pipeline cache at '%s' yet; it'll be saved at exit.", path);
+        return false;
+    }
+
+    if (fileSize < sizeof(kCacheFileMagic) || SDL_memcmp(file, kCacheFileMagic, sizeof(kCacheFileMagic)) != 0) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "'%s' isn't a pipeline cache this version understands; ignoring it.", path);
+        SDL_free(file);
+        return false;
+    }
+
+    Uint64 began = SDL_GetTicksNS();
+    Uint32 created = 0, skipped = 0;
+    size_t position = sizeof(kCacheFileMagic);
+    while (position + 4 <= fileSize) {
+        Uint32 keySize;
+        SDL_memcpy(&keySize, file + position, 4);
+        keySize = SDL_Swap32LE(keySize);
+        position += 4;
+        if (keySize > GBE_MAX_PIPELINE_KEY_SIZE || keySize > fileSize - position) {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "'%s' is truncated; stopping there.", path);
+            break;
+        }
+
+        Uint8* key = file + position;
+        position += keySize;
+
+        // The decoded description's shader names point into the file's contents, which
+        // stick around until everything's been created.
+        GBE_PipelineDesc desc;
+        SDL_zero(desc);
+        KeyCodec codec = { .data = key, .capacity = keySize, .decoding = true };
+        if (!CodeDesc(&codec, &desc) || codec.size != keySize) {
+            skipped++;
+            continue;
+        }
+
+        Uint64 hash = HashKey(key, keySize);
+        if (FindEntry(cache, key, keySize, hash) != NULL) {
+            continue;
+        }
+
+        SDL_GPUGraphicsPipeline* pipeline = GBE_CreatePipeline(context, &desc);
+        if (pipeline == NULL) {
+            skipped++;
+            continue;
+        }
+
+        if (AddEntry(cache, key, keySize, hash, pipeline) == NULL) {
+            SDL_ReleaseGPUGraphicsPipeline(context->device, pipeline);
+            skipped++;
+            continue;
+        }
+        created++;
+    }
+    SDL_free(file);
+
+    cache->prewarmed += created;
+    SDL_Log("Prewarmed %u pipelines from '%s' in %.2f ms (%u skipped).", created, path,
+        (double)(SDL_GetTicksNS() - began) / SDL_NS_PER_MS, skipped);
+    return true;
+}
+
+void GBE_DestroyPipelineCache(GBE_Context* context)
+{
+    GBE_PipelineCache* cache = &context->pipelineCache;
+    if (cache->hits + cache->misses > 0) {
+        SDL_Log("Pipeline cache: %u hits, %u misses, %d pipelines (%u prewarmed).",
+            cache->hits, cache->misses, cache->numEntries, cache->prewarmed);
+    }
+
+    while (cache->numEntries > 0) {
+        RemoveEntry(context, cache->numEntries - 1);
+    }
+
+    SDL_free(cache->entries);
+    cache->entries = NULL;
+    cache->maxEntries = 0;
+    SDL_free(cache->slots);
+    cache->slots = NULL;
+    cache->numSlots = 0;
+}
@@ -0,0 +1,157 @@
+//
+//  GBE_ReleaseQueue.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_ReleaseQueue.h>
+
+static const char* kResourceTypeNames[] = {
+    "buffer",
+    "transfer buffer",
+    "texture",
+    "sampler",
+    "shader",
+    "graphics pipeline",
+    "compute pipeline"
+};
+
+static void ReleaseResource(SDL_GPUDevice* device, GBE_ResourceType type, void* resource)
+{
+    switch (type) {
+    case GBE_RESOURCE_BUFFER:
+        SDL_ReleaseGPUBuffer(device, resource);
+        break;
+    case GBE_RESOURCE_TRANSFER_BUFFER:
+        SDL_ReleaseGPUTransferBuffer(device, resource);
+        break;
+    case GBE_RESOURCE_TEXTURE:
+        SDL_ReleaseGPUTexture(device, resource);
+        break;
+    case GBE_RESOURCE_SAMPLER:
+        SDL_ReleaseGPUSampler(device, resource);
+        break;
+    case GBE_RESOURCE_SHADER:
+        SDL_ReleaseGPUShader(device, resource);
+        break;
+    case GBE_RESOURCE_GRAPHICS_PIPELINE:
+        SDL_ReleaseGPUGraphicsPipeline(device, resource);
+        break;
+    case GBE_RESOURCE_COMPUTE_PIPELINE:
+        SDL_ReleaseGPUComputePipeline(device, resource);
+        break;
+    }
+}
+
+void GBE_TrackResource(GBE_Context* context, GBE_ResourceType type, void* resource, const char* name)
+{
+    GBE_ReleaseQueue* queue = &context->releaseQueue;
+    if (!queue->trackResources || resource == NULL) {
+        return;
+    }
+
+    if (queue->numTracked == queue->maxTracked) {
+        int maxTracked = queue->maxTracked > 0 ? queue->maxTracked * 2 : 64;
+        GBE_TrackedResource* tracked = SDL_realloc(queue->tracked, sizeof(GBE_TrackedResource) * maxTracked);
+        if (tracked == NULL) {
+            return;
+        }
+        queue->tracked = tracked;
+        queue->maxTracked = maxTracked;
+    }
+
+    queue->tracked[queue->numTracked++] = (GBE_TrackedResource) {
+        .type = type,
+        .resource = resource,
+        .name = name
+    };
+}
+
+static void Untrack(GBE_ReleaseQueue* queue, void* resource)
+{
+    // Resources tend to be released in the reverse order they were made, so look from
+    // the end. This is only on in debug mode; a linear search is fine.
+    for (int i = queue->numTracked - 1; i >= 0; i--) {
+        if (queue->tracked[i].resource == resource) {
+            queue->tracked[i] = queue->tracked[--queue->numTracked];
+            return;
+        }
+    }
+}
+
+void GBE_DeferRelease(GBE_Context* context, GBE_ResourceType type, void* resource)
+{
+    GBE_ReleaseQueue* queue = &context->releaseQueue;
+    if (resource == NULL) {
+        return;
+    }
+
+    if (queue->trackResources) {
+        Untrack(queue, resource);
+    }
+
+    if (queue->numPending == queue->maxPending) {
+        int maxPending = queue->maxPending > 0 ? queue->maxPending * 2 : 64;
+        GBE_PendingRelease* pending = SDL_realloc(queue->pending, sizeof(GBE_PendingRelease) * maxPending);
+        if (pending == NULL) {
+            // Better a stall than a leak.
+            SDL_WaitForGPUIdle(context->device);
+            ReleaseResource(context->device, type, resource);
+            queue->released++;
+            return;
+        }
+        queue->pending = pending;
+        queue->maxPending = maxPending;
+    }
+
+    // frameNumber counts submitted frames, so it's also the number of the frame being
+    // recorded right now (or the next one, between frames): the last that could use this.
+    queue->pending[queue->numPending++] = (GBE_PendingRelease) {
+        .type = type,
+        .resource = resource,
+        .frame = context->frameNumber
+    };
+}
+
+static void ReleaseBefore(GBE_Context* context, Uint64 frame)
+{
+    GBE_ReleaseQueue* queue = &context->releaseQueue;
+
+    // Entries are queued in frame order, so the releasable ones are all at the front.
+    int count = 0;
+    while (count < queue->numPending && queue->pending[count].frame < frame) {
+        ReleaseResource(context->device, queue->pending[count].type, queue->pending[count].resource);
+        count++;
+    }
+
+    if (count > 0) {
+        queue->numPending -= count;
+        SDL_memmove(queue->pending, queue->pending + count, sizeof(GBE_PendingRelease) * queue->numPending);
+        queue->released += count;
+    }
+}
+
+void GBE_ProcessReleases(GBE_Context* context)
+{
+    ReleaseBefore(context, context->frameFences.completedFrames);
+}
+
+void GBE_FlushReleases(GBE_Context* context)
+{
+    GBE_ReleaseQueue* queue = &context->releaseQueue;
+    if (queue->numPending > 0) {
+        SDL_WaitForGPUIdle(context->device);
+        ReleaseBefore(context, SDL_MAX_UINT64);
+    }
+}
+
+int GBE_ReportLeaks(GBE_Context* context)
+{
+    GBE_ReleaseQueue* queue = &context->releaseQueue;
+    for (int i = 0; i < queue->numTracked; i++) {
+        const GBE_TrackedResource* tracked = &queue->tracked[i];
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Leaked %s %s (%p)", kResourceTypeNames[tracked->type],
+            tracked->name != NULL ? tracked->name : "(unnamed)", tracked->resource);
+    }
+
+    return queue->numTracked;
+}
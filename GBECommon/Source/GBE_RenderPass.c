@@ -0,0 +1,210 @@
+//
+//  GBE_RenderPass.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_RenderPass.h>
+
+bool GBE_BeginRenderPass(GBE_RenderPass* renderPass, SDL_GPUCommandBuffer* commandBuffer,
+    const SDL_GPUColorTargetInfo* colorTargets, Uint32 numColorTargets,
+    const SDL_GPUDepthStencilTargetInfo* depthStencilTarget)
+{
+    SDL_assert(renderPass != NULL);
+    SDL_assert(commandBuffer != NULL);
+
+    SDL_zerop(renderPass);
+    renderPass->commandBuffer = commandBuffer;
+    renderPass->filter = true;
+
+    renderPass->pass = SDL_BeginGPURenderPass(commandBuffer, colorTargets, numColorTargets, depthStencilTarget);
+    if (renderPass->pass == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_BeginGPURenderPass failed: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void GBE_EndRenderPass(GBE_RenderPass* renderPass)
+{
+    if (renderPass->pass != NULL) {
+        SDL_EndGPURenderPass(renderPass->pass);
+        renderPass->pass = NULL;
+    }
+}
+
+void GBE_InvalidateRenderPassState(GBE_RenderPass* renderPass)
+{
+    renderPass->pipeline = NULL;
+    SDL_zeroa(renderPass->vertexBuffers);
+    SDL_zero(renderPass->indexBuffer);
+    SDL_zeroa(renderPass->vertexStorageBuffers);
+    SDL_zeroa(renderPass->fragmentStorageBuffers);
+    for (int i = 0; i < GBE_RENDER_PASS_UNIFORM_SLOTS; i++) {
+        renderPass->vertexUniforms[i].size = 0;
+        renderPass->fragmentUniforms[i].size = 0;
+    }
+}
+
+// Whether a call can be dropped, counting it either way.
+static bool Skip(GBE_RenderPass* renderPass, bool redundant)
+{
+    if (redundant && renderPass->filter) {
+        renderPass->skipped++;
+        return true;
+    }
+
+    renderPass->issued++;
+    return false;
+}
+
+void GBE_BindPipeline(GBE_RenderPass* renderPass, SDL_GPUGraphicsPipeline* pipeline)
+{
+    if (Skip(renderPass, pipeline == renderPass->pipeline)) {
+        return;
+    }
+
+    SDL_BindGPUGraphicsPipeline(renderPass->pass, pipeline);
+    renderPass->pipeline = pipeline;
+}
+
+void GBE_BindVertexBuffers(GBE_RenderPass* renderPass, Uint32 firstSlot, const SDL_GPUBufferBinding* bindings, Uint32 numBindings)
+{
+    // Only the slots that actually changed get rebound, as one call covering the first
+    // through the last of them.
+    Uint32 first = numBindings, last = 0;
+    for (Uint32 i = 0; i < numBindings; i++) {
+        Uint32 slot = firstSlot + i;
+        bool same = slot < GBE_RENDER_PASS_VERTEX_BUFFERS && bindings[i].buffer != NULL &&
+            renderPass->vertexBuffers[slot].buffer == bindings[i].buffer &&
+            renderPass->vertexBuffers[slot].offset == bindings[i].offset;
+        if (!same) {
+            first = SDL_min(first, i);
+            last = i;
+        }
+    }
+
+    if (numBindings == 0 || Skip(renderPass, first == numBindings)) {
+        return;
+    }
+    if (!renderPass->filter) {
+        first = 0;
+        last = numBindings - 1;
+    }
+
+    SDL_BindGPUVertexBuffers(renderPass->pass, firstSlot + first, bindings + first, last - first + 1);
+    for (Uint32 i = first; i <= last && firstSlot + i < GBE_RENDER_PASS_VERTEX_BUFFERS; i++) {
+        renderPass->vertexBuffers[firstSlot + i] = bindings[i];
+    }
+}
+
+void GBE_BindIndexBuffer(GBE_RenderPass* renderPass, const SDL_GPUBufferBinding* binding, SDL_GPUIndexElementSize elementSize)
+{
+    bool same = binding->buffer != NULL && renderPass->indexBuffer.buffer == binding->buffer &&
+        renderPass->indexBuffer.offset == binding->offset && renderPass->indexElementSize == elementSize;
+    if (Skip(renderPass, same)) {
+        return;
+    }
+
+    SDL_BindGPUIndexBuffer(renderPass->pass, binding, elementSize);
+    renderPass->indexBuffer = *binding;
+    renderPass->indexElementSize = elementSize;
+}
+
+// Storage buffers are bound the same way for both stages; `shadow` is the stage's array.
+static bool StorageBuffersBound(SDL_GPUBuffer** shadow, Uint32 firstSlot, SDL_GPUBuffer* const* buffers, Uint32 numBuffers)
+{
+    for (Uint32 i = 0; i < numBuffers; i++) {
+        Uint32 slot = firstSlot + i;
+        if (slot >= GBE_RENDER_PASS_STORAGE_BUFFERS || buffers[i] == NULL || shadow[slot] != buffers[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void RememberStorageBuffers(SDL_GPUBuffer** shadow, Uint32 firstSlot, SDL_GPUBuffer* const* buffers, Uint32 numBuffers)
+{
+    for (Uint32 i = 0; i < numBuffers && firstSlot + i < GBE_RENDER_PASS_STORAGE_BUFFERS; i++) {
+        shadow[firstSlot + i] = buffers[i];
+    }
+}
+
+void GBE_BindVertexStorageBuffers(GBE_RenderPass* renderPass, Uint32 firstSlot, SDL_GPUBuffer* const* buffers, Uint32 numBuffers)
+{
+    if (Skip(renderPass, StorageBuffersBound(renderPass->vertexStorageBuffers, firstSlot, buffers, numBuffers))) {
+        return;
+    }
+
+    SDL_BindGPUVertexStorageBuffers(renderPass->pass, firstSlot, buffers, numBuffers);
+    RememberStorageBuffers(renderPass->vertexStorageBuffers, firstSlot, buffers, numBuffers);
+}
+
+void GBE_BindFragmentStorageBuffers(GBE_RenderPass* renderPass, Uint32 firstSlot, SDL_GPUBuffer* const* buffers, Uint32 numBuffers)
+{
+    if (Skip(renderPass, StorageBuffersBound(renderPass->fragmentStorageBuffers, firstSlot, buffers, numBuffers))) {
+        return;
+    }
+
+    SDL_BindGPUFragmentStorageBuffers(renderPass->pass, firstSlot, buffers, numBuffers);
+    RememberStorageBuffers(renderPass->fragmentStorageBuffers, firstSlot, buffers, numBuffers);
+}
+
+// Compares a push against what's in the slot, and keeps a copy of it if it's going
+// through. Pushes too big to keep empty the slot, so the next one always goes through.
+static bool UniformsPushed(GBE_ShadowedUniforms* slots, Uint32 slot, const void* data, Uint32 size)
+{
+    if (slot >= GBE_RENDER_PASS_UNIFORM_SLOTS) {
+        return false;
+    }
+
+    GBE_ShadowedUniforms* shadow = &slots[slot];
+    if (size > GBE_RENDER_PASS_MAX_SHADOWED_UNIFORMS) {
+        shadow->size = 0;
+        return false;
+    }
+
+    if (shadow->size == size && SDL_memcmp(shadow->data, data, size) == 0) {
+        return true;
+    }
+
+    SDL_memcpy(shadow->data, data, size);
+    shadow->size = size;
+    return false;
+}
+
+void GBE_PushVertexUniforms(GBE_RenderPass* renderPass, Uint32 slot, const void* data, Uint32 size)
+{
+    if (Skip(renderPass, UniformsPushed(renderPass->vertexUniforms, slot, data, size))) {
+        return;
+    }
+
+    SDL_PushGPUVertexUniformData(renderPass->commandBuffer, slot, data, size);
+}
+
+void GBE_PushFragmentUniforms(GBE_RenderPass* renderPass, Uint32 slot, const void* data, Uint32 size)
+{
+    if (Skip(renderPass, UniformsPushed(renderPass->fragmentUniforms, slot, data, size))) {
+        return;
+    }
+
+    SDL_PushGPUFragmentUniformData(renderPass->commandBuffer, slot, data, size);
+}
+
+void GBE_DrawPrimitives(GBE_RenderPass* renderPass, Uint32 numVertices, Uint32 numInstances, Uint32 firstVertex, Uint32 firstInstance)
+{
+    SDL_DrawGPUPrimitives(renderPass->pass, numVertices, numInstances, firstVertex, firstInstance);
+    renderPass->draws++;
+}
+
+void GBE_DrawIndexedPrimitives(GBE_RenderPass* renderPass, Uint32 numIndices, Uint32 numInstances,
+    Uint32 firstIndex, Sint32 vertexOffset, Uint32 firstInstance)
+{
+    SDL_DrawGPUIndexedPrimitives(renderPass->pass, numIndices, numInstances, firstIndex, vertexOffset, firstInstance);
+    renderPass->draws++;
+}
+
+void GBE_DrawIndexedPrimitivesIndirect(GBE_RenderPass* renderPass, SDL_GPUBuffer* buffer, Uint32 offset, Uint32 drawCount)
+{
+    SDL_DrawGPUIndexedPrimitivesIndirect(renderPass->pass, buffer, offset, drawCount);
+    renderPass->draws++;
+}
@@ -14,32 +14,104 @@
 // 2 types of shaders (vertex and fragment/pixel) and 3 backends (Direct3D 12,
 // Metal, and Vulkan).
 
-SDL_GPUShader* GBE_LoadShader(GBE_Context* context, const GBE_LoadShaderInfo* loadShaderInfo)
+// How many variants a single permutation manifest can list.
+#define GBE_MAX_SHADER_VARIANTS 64
+
+// Reads the shader's permutation manifest (if it has one) and works out which
+// precompiled variant covers the requested feature bits. Shaders without a manifest
+// only come in their plain flavor, so every feature bit is meaningless to them.
+static bool ResolveShaderVariant(GBE_Context* context, const char* path, const char* stageExtension,
+    GBE_ShaderFeatures requested, GBE_ShaderFeatures* variantOut)
 {
-    if (loadShaderInfo->stage != SDL_GPU_SHADERSTAGE_VERTEX &&
-        loadShaderInfo->stage != SDL_GPU_SHADERSTAGE_FRAGMENT) {
-        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Invalid shader stage!");
-        return NULL;
+    *variantOut = 0;
+    if (requested == 0) {
+        return true;
+    }
+
+    char manifestPath[256];
+    SDL_snprintf(manifestPath, sizeof(manifestPath), "%s.%s.permutations", path, stageExtension);
+
+    Uint64 manifestSize;
+    if (!SDL_GetStorageFileSize(context->titleStorage, manifestPath, &manifestSize)) {
+        return true;
+    }
+
+    char* manifest = SDL_malloc(manifestSize + 1);
+    if (!SDL_ReadStorageFile(context->titleStorage, manifestPath, manifest, manifestSize)) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to read file '%s': %s", manifestPath, SDL_GetError());
+        SDL_free(manifest);
+        return false;
+    }
+    manifest[manifestSize] = '\0';
+
+    GBE_ShaderFeatures knownFeatures = 0;
+    GBE_ShaderFeatures variants[GBE_MAX_SHADER_VARIANTS];
+    int numVariants = 0;
+
+    char* lineState;
+    for (char* line = SDL_strtok_r(manifest, "\r\n", &lineState); line != NULL; line = SDL_strtok_r(NULL, "\r\n", &lineState)) {
+        char* wordState;
+        const char* directive = SDL_strtok_r(line, " \t", &wordState);
+        const char* value = SDL_strtok_r(NULL, " \t", &wordState);
+        if (directive == NULL || directive[0] == '#') {
+            continue;
+        }
+
+        if (value != NULL && SDL_strcmp(directive, "feature") == 0) {
+            unsigned long bit = SDL_strtoul(value, NULL, 0);
+            if (bit < 32) {
+                knownFeatures |= 1u << bit;
+            }
+        }
+        else if (value != NULL && SDL_strcmp(directive, "variant") == 0 && numVariants < GBE_MAX_SHADER_VARIANTS) {
+            variants[numVariants++] = (GBE_ShaderFeatures)SDL_strtoul(value, NULL, 0);
+        }
+        else {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Ignoring unrecognized line in '%s': %s", manifestPath, line);
+        }
     }
+    SDL_free(manifest);
 
+    // Feature bits this shader doesn't know about don't change its code, so drop them
+    // before looking for a matching variant.
+    GBE_ShaderFeatures wanted = requested & knownFeatures;
+    if (wanted == 0) {
+        return true;
+    }
+
+    for (int i = 0; i < numVariants; i++) {
+        if (variants[i] == wanted) {
+            *variantOut = wanted;
+            return true;
+        }
+    }
+
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+        "'%s' doesn't list variant 0x%x; add it and re-run compile-shader-permutations.sh", manifestPath, wanted);
+    return false;
+}
+
+// Picks the best shader format the device takes and reads in the matching file:
+// <baseName>.<extension>.spv, .msl or .dxil. The caller frees the code.
+static void* LoadShaderCode(GBE_Context* context, const char* baseName, const char* extension, const char* mslEntryPoint,
+    SDL_GPUShaderFormat* format, const char** entryPoint, size_t* codeSize)
+{
     SDL_GPUShaderFormat backendFormats = SDL_GetGPUShaderFormats(context->device);
-    SDL_GPUShaderFormat format = SDL_GPU_SHADERFORMAT_INVALID;
 
     char fullPath[256];
-    const char* extraExtension = loadShaderInfo->stage == SDL_GPU_SHADERSTAGE_VERTEX ? "vert" : "frag";
-    const char* entryPoint = "main";
+    *entryPoint = "main";
     if (backendFormats & SDL_GPU_SHADERFORMAT_SPIRV) {
-        SDL_snprintf(fullPath, sizeof(fullPath), "%s.%s.spv", loadShaderInfo->path, extraExtension);
-        format = SDL_GPU_SHADERFORMAT_SPIRV;
+        SDL_snprintf(fullPath, sizeof(fullPath), "%s.%s.spv", baseName, extension);
+        *format = SDL_GPU_SHADERFORMAT_SPIRV;
     }
     else if (backendFormats & SDL_GPU_SHADERFORMAT_MSL) {
-        SDL_snprintf(fullPath, sizeof(fullPath), "%s.%s.msl", loadShaderInfo->path, extraExtension);
-        entryPoint = loadShaderInfo->stage == SDL_GPU_SHADERSTAGE_VERTEX ? "vertex_main" : "fragment_main";
-        format = SDL_GPU_SHADERFORMAT_MSL;
+        SDL_snprintf(fullPath, sizeof(fullPath), "%s.%s.msl", baseName, extension);
+        *entryPoint = mslEntryPoint;
+        *format = SDL_GPU_SHADERFORMAT_MSL;
     }
     else if (backendFormats & SDL_GPU_SHADERFORMAT_DXIL) {
-        SDL_snprintf(fullPath, sizeof(fullPath), "%s.%s.dxil", loadShaderInfo->path, extraExtension);
-        format = SDL_GPU_SHADERFORMAT_DXIL;
+        SDL_snprintf(fullPath, sizeof(fullPath), "%s.%s.dxil", baseName, extension);
+        *format = SDL_GPU_SHADERFORMAT_DXIL;
     }
     else {
         SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Unrecognized backend shader format!");
@@ -47,20 +119,57 @@ SDL_GPUShader* GBE_LoadShader(GBE_Context* context, const GBE_LoadShaderInfo* lo
     }
     SDL_Log("Loading shader file %s...", fullPath);
 
-    Uint64 codeSize;
-    void* code;
-    if (!SDL_GetStorageFileSize(context->titleStorage, fullPath, &codeSize)) {
+    Uint64 fileSize;
+    if (!SDL_GetStorageFileSize(context->titleStorage, fullPath, &fileSize)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to determine size of file '%s': %s", fullPath, SDL_GetError());
         return NULL;
     }
 
-    code = SDL_malloc(codeSize);
-    if (!SDL_ReadStorageFile(context->titleStorage, fullPath, code, codeSize)) {
+    void* code = SDL_malloc(fileSize);
+    if (!SDL_ReadStorageFile(context->titleStorage, fullPath, code, fileSize)) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to read file '%s': %s", fullPath, SDL_GetError());
         SDL_free(code);
         return NULL;
     }
 
+    *codeSize = (size_t)fileSize;
+    return code;
+}
+
+SDL_GPUShader* GBE_LoadShader(GBE_Context* context, const GBE_LoadShaderInfo* loadShaderInfo)
+{
+    if (loadShaderInfo->stage != SDL_GPU_SHADERSTAGE_VERTEX &&
+        loadShaderInfo->stage != SDL_GPU_SHADERSTAGE_FRAGMENT) {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Invalid shader stage!");
+        return NULL;
+    }
+
+    const char* extraExtension = loadShaderInfo->stage == SDL_GPU_SHADERSTAGE_VERTEX ? "vert" : "frag";
+
+    // Specialized variants live alongside the plain shader, with their feature mask
+    // tacked onto the name.
+    GBE_ShaderFeatures variant;
+    if (!ResolveShaderVariant(context, loadShaderInfo->path, extraExtension, loadShaderInfo->features, &variant)) {
+        return NULL;
+    }
+
+    char baseName[224];
+    if (variant != 0) {
+        SDL_snprintf(baseName, sizeof(baseName), "%s-%x", loadShaderInfo->path, variant);
+    }
+    else {
+        SDL_strlcpy(baseName, loadShaderInfo->path, sizeof(baseName));
+    }
+
+    SDL_GPUShaderFormat format;
+    const char* entryPoint;
+    size_t codeSize;
+    const char* mslEntryPoint = loadShaderInfo->stage == SDL_GPU_SHADERSTAGE_VERTEX ? "vertex_main" : "fragment_main";
+    void* code = LoadShaderCode(context, baseName, extraExtension, mslEntryPoint, &format, &entryPoint, &codeSize);
+    if (code == NULL) {
+        return NULL;
+    }
+
     SDL_GPUShaderCreateInfo shaderInfo = {
         .code = code,
         .code_size = codeSize,
@@ -81,3 +190,38 @@ SDL_GPUShader* GBE_LoadShader(GBE_Context* context, const GBE_LoadShaderInfo* lo
     SDL_free(code);
     return shader;
 }
+
+SDL_GPUComputePipeline* GBE_LoadComputePipeline(GBE_Context* context, const GBE_LoadComputePipelineInfo* loadInfo)
+{
+    SDL_GPUShaderFormat format;
+    const char* entryPoint;
+    size_t codeSize;
+    void* code = LoadShaderCode(context, loadInfo->path, "comp", "compute_main", &format, &entryPoint, &codeSize);
+    if (code == NULL) {
+        return NULL;
+    }
+
+    SDL_GPUComputePipelineCreateInfo pipelineInfo = {
+        .code = code,
+        .code_size = codeSize,
+        .entrypoint = entryPoint,
+        .format = format,
+        .num_samplers = loadInfo->samplerCount,
+        .num_readonly_storage_textures = loadInfo->readonlyStorageTextureCount,
+        .num_readonly_storage_buffers = loadInfo->readonlyStorageBufferCount,
+        .num_readwrite_storage_textures = loadInfo->readwriteStorageTextureCount,
+        .num_readwrite_storage_buffers = loadInfo->readwriteStorageBufferCount,
+        .num_uniform_buffers = loadInfo->uniformBufferCount,
+        .threadcount_x = loadInfo->threadCountX,
+        .threadcount_y = loadInfo->threadCountY,
+        .threadcount_z = loadInfo->threadCountZ
+    };
+
+    SDL_GPUComputePipeline* pipeline = SDL_CreateGPUComputePipeline(context->device, &pipelineInfo);
+    if (pipeline == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create compute pipeline: %s", SDL_GetError());
+    }
+
+    SDL_free(code);
+    return pipeline;
+}
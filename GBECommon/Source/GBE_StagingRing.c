@@ -0,0 +1,129 @@
+//
+//  GBE_StagingRing.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_StagingRing.h>
+
+bool GBE_CreateStagingRing(GBE_Context* context, Uint32 capacity, GBE_StagingRing* ring)
+{
+    SDL_assert(context != NULL);
+    SDL_assert(ring != NULL);
+
+    SDL_zerop(ring);
+
+    SDL_GPUTransferBufferCreateInfo createInfo = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = capacity
+    };
+    ring->transferBuffer = SDL_CreateGPUTransferBuffer(context->device, &createInfo);
+    if (ring->transferBuffer == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create staging ring transfer buffer: %s", SDL_GetError());
+        return false;
+    }
+
+    ring->device = context->device;
+    ring->capacity = capacity;
+    return true;
+}
+
+void GBE_DestroyStagingRing(GBE_StagingRing* ring)
+{
+    if (ring->transferBuffer != NULL) {
+        if (ring->mapped != NULL) {
+            SDL_UnmapGPUTransferBuffer(ring->device, ring->transferBuffer);
+        }
+        SDL_ReleaseGPUTransferBuffer(ring->device, ring->transferBuffer);
+    }
+
+    SDL_free(ring->copies);
+    SDL_zerop(ring);
+}
+
+void* GBE_StagingRingAlloc(GBE_StagingRing* ring, Uint32 size, Uint32 alignment, Uint32* offset)
+{
+    SDL_assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    Uint32 start = (ring->used + alignment - 1) & ~(alignment - 1);
+    if (start > ring->capacity || size > ring->capacity - start) {
+        ring->overflows++;
+        return NULL;
+    }
+
+    // First allocation this frame: map with cycling on, so we never write over data
+    // the GPU might still be copying out of from an earlier frame.
+    if (ring->mapped == NULL) {
+        ring->mapped = SDL_MapGPUTransferBuffer(ring->device, ring->transferBuffer, true);
+        if (ring->mapped == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to map staging ring: %s", SDL_GetError());
+            return NULL;
+        }
+    }
+
+    ring->used = start + size;
+    *offset = start;
+    return ring->mapped + start;
+}
+
+bool GBE_StagingRingCopy(GBE_StagingRing* ring, Uint32 sourceOffset, SDL_GPUBuffer* buffer, Uint32 offset, Uint32 size, bool cycle)
+{
+    if (ring->numCopies == ring->maxCopies) {
+        // This only grows while the app is warming up; after that the array's big enough.
+        int maxCopies = ring->maxCopies > 0 ? ring->maxCopies * 2 : 64;
+        GBE_StagingCopy* copies = SDL_realloc(ring->copies, sizeof(GBE_StagingCopy) * maxCopies);
+        if (copies == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory queuing staging copy %d.", ring->numCopies + 1);
+            return false;
+        }
+        ring->copies = copies;
+        ring->maxCopies = maxCopies;
+    }
+
+    ring->copies[ring->numCopies++] = (GBE_StagingCopy) {
+        .sourceOffset = sourceOffset,
+        .destination = {
+            .buffer = buffer,
+            .offset = offset,
+            .size = size
+        },
+        .cycle = cycle
+    };
+    return true;
+}
+
+bool GBE_StagingRingUpload(GBE_StagingRing* ring, const void* data, Uint32 size, SDL_GPUBuffer* buffer, Uint32 offset, bool cycle)
+{
+    Uint32 sourceOffset;
+    void* staging = GBE_StagingRingAlloc(ring, size, 16, &sourceOffset);
+    if (staging == NULL) {
+        return false;
+    }
+
+    SDL_memcpy(staging, data, size);
+    return GBE_StagingRingCopy(ring, sourceOffset, buffer, offset, size, cycle);
+}
+
+void GBE_StagingRingFlush(GBE_StagingRing* ring, SDL_GPUCopyPass* copyPass)
+{
+    if (ring->mapped == NULL) {
+        return;
+    }
+
+    SDL_UnmapGPUTransferBuffer(ring->device, ring->transferBuffer);
+    ring->mapped = NULL;
+
+    for (int i = 0; i < ring->numCopies; i++) {
+        SDL_GPUTransferBufferLocation source = {
+            .transfer_buffer = ring->transferBuffer,
+            .offset = ring->copies[i].sourceOffset
+        };
+        SDL_UploadToGPUBuffer(copyPass, &source, &ring->copies[i].destination, ring->copies[i].cycle);
+    }
+
+    if (ring->used > ring->highWaterMark) {
+        ring->highWaterMark = ring->used;
+    }
+
+    ring->used = 0;
+    ring->numCopies = 0;
+}
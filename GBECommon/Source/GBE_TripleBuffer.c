@@ -0,0 +1,64 @@
+//
+//  GBE_TripleBuffer.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_TripleBuffer.h>
+
+#define GBE_TRIPLE_BUFFER_INDEX_MASK 3
+
+bool GBE_CreateTripleBuffer(size_t slotSize, GBE_TripleBuffer* buffer)
+{
+    SDL_assert(buffer != NULL);
+
+    SDL_zerop(buffer);
+    buffer->data = SDL_calloc(3, slotSize);
+    if (buffer->data == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Out of memory creating a triple buffer of %zu byte slots.", slotSize);
+        return false;
+    }
+
+    buffer->slotSize = slotSize;
+    buffer->writeSlot = 0;
+    SDL_SetAtomicInt(&buffer->middle, 1);
+    buffer->readSlot = 2;
+    return true;
+}
+
+void GBE_DestroyTripleBuffer(GBE_TripleBuffer* buffer)
+{
+    SDL_free(buffer->data);
+    SDL_zerop(buffer);
+}
+
+void* GBE_GetTripleBufferWriteSlot(GBE_TripleBuffer* buffer)
+{
+    return buffer->data + buffer->slotSize * buffer->writeSlot;
+}
+
+void GBE_PublishTripleBuffer(GBE_TripleBuffer* buffer)
+{
+    // SDL's atomic exchange is a full barrier, so everything written into the slot is
+    // visible before the slot is.
+    int previous = SDL_SetAtomicInt(&buffer->middle, buffer->writeSlot | GBE_TRIPLE_BUFFER_FRESH);
+    buffer->writeSlot = previous & GBE_TRIPLE_BUFFER_INDEX_MASK;
+
+    buffer->published++;
+    if ((previous & GBE_TRIPLE_BUFFER_FRESH) != 0) {
+        buffer->overwritten++;
+    }
+}
+
+const void* GBE_ReadTripleBuffer(GBE_TripleBuffer* buffer, bool* fresh)
+{
+    bool isFresh = (SDL_GetAtomicInt(&buffer->middle) & GBE_TRIPLE_BUFFER_FRESH) != 0;
+    if (isFresh) {
+        int previous = SDL_SetAtomicInt(&buffer->middle, buffer->readSlot);
+        buffer->readSlot = previous & GBE_TRIPLE_BUFFER_INDEX_MASK;
+    }
+
+    if (fresh != NULL) {
+        *fresh = isFresh;
+    }
+    return buffer->data + buffer->slotSize * buffer->readSlot;
+}
@@ -0,0 +1,125 @@
+//
+//  GBE_Upload.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_Upload.h>
+
+static Uint32 AlignUp(Uint32 value, Uint32 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void ReleaseUploadBuffers(GBE_Context* context, GBE_BufferUpload* uploads, int count)
+{
+    for (int i = 0; i < count; i++) {
+        if (uploads[i].buffer != NULL && uploads[i].destination == NULL) {
+            SDL_ReleaseGPUBuffer(context->device, uploads[i].buffer);
+            uploads[i].buffer = NULL;
+        }
+    }
+}
+
+bool GBE_UploadBuffers(GBE_Context* context, GBE_BufferUpload* uploads, int count)
+{
+    SDL_assert(context != NULL);
+    SDL_assert(uploads != NULL || count == 0);
+
+    // Start everything off empty so a failure part way through knows what to clean up.
+    for (int i = 0; i < count; i++) {
+        uploads[i].buffer = NULL;
+    }
+
+    // Work out how big one transfer buffer holding everything needs to be, and create
+    // the destination buffers while we're at it.
+    Uint32 transferSize = 0;
+    for (int i = 0; i < count; i++) {
+        transferSize = AlignUp(transferSize, GBE_UPLOAD_ALIGNMENT) + uploads[i].size;
+
+        if (uploads[i].destination != NULL) {
+            uploads[i].buffer = uploads[i].destination;
+            continue;
+        }
+
+        SDL_GPUBufferCreateInfo createInfo = {
+            .usage = uploads[i].usage,
+            .size = uploads[i].size
+        };
+        uploads[i].buffer = SDL_CreateGPUBuffer(context->device, &createInfo);
+        if (uploads[i].buffer == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create GPU buffer: %s", SDL_GetError());
+            ReleaseUploadBuffers(context, uploads, count);
+            return false;
+        }
+    }
+
+    if (transferSize == 0) {
+        return true;
+    }
+
+    SDL_GPUTransferBufferCreateInfo transferBufferCreateInfo = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = transferSize
+    };
+    SDL_GPUTransferBuffer* transferBuffer = SDL_CreateGPUTransferBuffer(context->device, &transferBufferCreateInfo);
+    if (transferBuffer == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create transfer buffer: %s", SDL_GetError());
+        ReleaseUploadBuffers(context, uploads, count);
+        return false;
+    }
+
+    Uint8* mapped = SDL_MapGPUTransferBuffer(context->device, transferBuffer, false);
+    if (mapped == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to map transfer buffer: %s", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(context->device, transferBuffer);
+        ReleaseUploadBuffers(context, uploads, count);
+        return false;
+    }
+
+    Uint32 offset = 0;
+    for (int i = 0; i < count; i++) {
+        offset = AlignUp(offset, GBE_UPLOAD_ALIGNMENT);
+        SDL_memcpy(mapped + offset, uploads[i].data, uploads[i].size);
+        offset += uploads[i].size;
+    }
+    SDL_UnmapGPUTransferBuffer(context->device, transferBuffer);
+
+    // One copy pass for the lot.
+    SDL_GPUCommandBuffer* cmdBuf = SDL_AcquireGPUCommandBuffer(context->device);
+    if (cmdBuf == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_AcquireGPUCommandBuffer failed: %s", SDL_GetError());
+        SDL_ReleaseGPUTransferBuffer(context->device, transferBuffer);
+        ReleaseUploadBuffers(context, uploads, count);
+        return false;
+    }
+
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
+    offset = 0;
+    for (int i = 0; i < count; i++) {
+        offset = AlignUp(offset, GBE_UPLOAD_ALIGNMENT);
+
+        SDL_GPUTransferBufferLocation source = {
+            .transfer_buffer = transferBuffer,
+            .offset = offset
+        };
+        SDL_GPUBufferRegion destination = {
+            .buffer = uploads[i].buffer,
+            .offset = uploads[i].destination != NULL ? uploads[i].destinationOffset : 0,
+            .size = uploads[i].size
+        };
+        SDL_UploadToGPUBuffer(copyPass, &source, &destination, false);
+
+        offset += uploads[i].size;
+    }
+    SDL_EndGPUCopyPass(copyPass);
+
+    bool submitted = SDL_SubmitGPUCommandBuffer(cmdBuf);
+    if (!submitted) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_SubmitGPUCommandBuffer failed: %s", SDL_GetError());
+        ReleaseUploadBuffers(context, uploads, count);
+    }
+
+    // SDL holds on to the transfer buffer until the copy's done, so we can let go of it now.
+    SDL_ReleaseGPUTransferBuffer(context->device, transferBuffer);
+    return submitted;
+}
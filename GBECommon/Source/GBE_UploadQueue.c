@@ -0,0 +1,277 @@
+//
+//  GBE_UploadQueue.c
+//  GBECommon
+//
+
+#include <GBECommon/GBE_UploadQueue.h>
+#include <GBECommon/GBE_Upload.h>
+
+static Uint32 AlignUp(Uint32 value, Uint32 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static bool Reserve(GBE_QueuedUpload** uploads, int* maxUploads, int needed)
+{
+    if (needed <= *maxUploads) {
+        return true;
+    }
+
+    int maxCount = *maxUploads > 0 ? *maxUploads * 2 : 32;
+    while (maxCount < needed) {
+        maxCount *= 2;
+    }
+
+    GBE_QueuedUpload* grown = SDL_realloc(*uploads, sizeof(GBE_QueuedUpload) * maxCount);
+    if (grown == NULL) {
+        return false;
+    }
+
+    *uploads = grown;
+    *maxUploads = maxCount;
+    return true;
+}
+
+// Calls the callbacks for everything that went out in `batch` and forgets about it.
+static void CompleteBatch(GBE_UploadQueue* queue, int batch)
+{
+    int kept = 0;
+    for (int i = 0; i < queue->numWaiting; i++) {
+        GBE_QueuedUpload* upload = &queue->waiting[i];
+        if (upload->batch != batch) {
+            queue->waiting[kept++] = *upload;
+            continue;
+        }
+
+        if (upload->callback != NULL) {
+            upload->callback(upload->userdata, upload->buffer, upload->offset, upload->size, true);
+        }
+    }
+    queue->numWaiting = kept;
+}
+
+static void RetireBatches(GBE_UploadQueue* queue, bool wait)
+{
+    for (int i = 0; i < GBE_UPLOAD_QUEUE_MAX_BATCHES; i++) {
+        GBE_UploadBatch* batch = &queue->batches[i];
+        if (batch->fence == NULL) {
+            continue;
+        }
+
+        if (wait) {
+            SDL_WaitForGPUFences(queue->device, true, &batch->fence, 1);
+        }
+        else if (!SDL_QueryGPUFence(queue->device, batch->fence)) {
+            continue;
+        }
+
+        SDL_ReleaseGPUFence(queue->device, batch->fence);
+        batch->fence = NULL;
+        CompleteBatch(queue, i);
+    }
+}
+
+// Sends up to bytesPerFrame of the pending uploads to the GPU in one batch. Returns
+// false if there was no free batch or the submission didn't work out.
+static bool SubmitBatch(GBE_UploadQueue* queue)
+{
+    int index = 0;
+    while (index < GBE_UPLOAD_QUEUE_MAX_BATCHES && queue->batches[index].fence != NULL) {
+        index++;
+    }
+    if (index == GBE_UPLOAD_QUEUE_MAX_BATCHES) {
+        queue->stalls++;
+        return false;
+    }
+
+    GBE_UploadBatch* batch = &queue->batches[index];
+    if (batch->transferBuffer == NULL) {
+        SDL_GPUTransferBufferCreateInfo createInfo = {
+            .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+            .size = queue->bytesPerFrame
+        };
+        batch->transferBuffer = SDL_CreateGPUTransferBuffer(queue->device, &createInfo);
+        if (batch->transferBuffer == NULL) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to create upload queue transfer buffer: %s", SDL_GetError());
+            return false;
+        }
+    }
+
+    SDL_GPUCommandBuffer* cmdBuf = SDL_AcquireGPUCommandBuffer(queue->device);
+    if (cmdBuf == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_AcquireGPUCommandBuffer failed: %s", SDL_GetError());
+        return false;
+    }
+
+    // The batch's fence has signaled (or it's never been used), so there's nothing reading
+    // this transfer buffer and no reason to cycle it.
+    Uint8* mapped = SDL_MapGPUTransferBuffer(queue->device, batch->transferBuffer, false);
+    if (mapped == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unable to map upload queue transfer buffer: %s", SDL_GetError());
+        SDL_CancelGPUCommandBuffer(cmdBuf);
+        return false;
+    }
+
+    // Work out what fits without touching the pending list, so a failed submit leaves it
+    // as it was. `finished` uploads go out completely; the one after may go out in part.
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(cmdBuf);
+    Uint32 used = 0;
+    Uint32 partial = 0;
+    int finished = 0;
+    while (finished < queue->numPending) {
+        const GBE_QueuedUpload* upload = &queue->pending[finished];
+        Uint32 start = AlignUp(used, GBE_UPLOAD_ALIGNMENT);
+        Uint32 remaining = upload->size - upload->submitted;
+        if (remaining > 0 && start >= queue->bytesPerFrame) {
+            break;
+        }
+
+        Uint32 chunk = SDL_min(remaining, queue->bytesPerFrame - start);
+        if (chunk > 0) {
+            SDL_memcpy(mapped + start, (const Uint8*)upload->data + upload->submitted, chunk);
+
+            SDL_GPUTransferBufferLocation source = {
+                .transfer_buffer = batch->transferBuffer,
+                .offset = start
+            };
+            SDL_GPUBufferRegion destination = {
+                .buffer = upload->buffer,
+                .offset = upload->offset + upload->submitted,
+                .size = chunk
+            };
+            SDL_UploadToGPUBuffer(copyPass, &source, &destination, false);
+            used = start + chunk;
+        }
+
+        if (chunk < remaining) {
+            partial = chunk;
+            break;
+        }
+        finished++;
+    }
+    SDL_EndGPUCopyPass(copyPass);
+    SDL_UnmapGPUTransferBuffer(queue->device, batch->transferBuffer);
+
+    batch->fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmdBuf);
+    if (batch->fence == NULL) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_SubmitGPUCommandBufferAndAcquireFence failed: %s", SDL_GetError());
+        return false;
+    }
+
+    if (!Reserve(&queue->waiting, &queue->maxWaiting, queue->numWaiting + finished)) {
+        // Can't happen in practice; the data's already on its way, only the callbacks
+        // would be lost. Wait it out so at least nothing is left half done.
+        SDL_WaitForGPUFences(queue->device, true, &batch->fence, 1);
+    }
+    else {
+        for (int i = 0; i < finished; i++) {
+            GBE_QueuedUpload* upload = &queue->waiting[queue->numWaiting++];
+            *upload = queue->pending[i];
+            upload->submitted = upload->size;
+            upload->batch = index;
+        }
+    }
+
+    queue->numPending -= finished;
+    SDL_memmove(queue->pending, queue->pending + finished, sizeof(GBE_QueuedUpload) * queue->numPending);
+    if (queue->numPending > 0) {
+        queue->pending[0].submitted += partial;
+    }
+
+    queue->bytesUploaded += used;
+    return true;
+}
+
+bool GBE_CreateUploadQueue(GBE_Context* context, Uint32 bytesPerFrame, GBE_UploadQueue* queue)
+{
+    SDL_assert(context != NULL);
+    SDL_assert(queue != NULL);
+    SDL_assert(bytesPerFrame >= GBE_UPLOAD_ALIGNMENT);
+
+    SDL_zerop(queue);
+    queue->device = context->device;
+    queue->bytesPerFrame = bytesPerFrame;
+    return true;
+}
+
+void GBE_DestroyUploadQueue(GBE_UploadQueue* queue)
+{
+    if (queue->device == NULL) {
+        return;
+    }
+
+    RetireBatches(queue, true);
+
+    for (int i = 0; i < queue->numPending; i++) {
+        GBE_QueuedUpload* upload = &queue->pending[i];
+        if (upload->callback != NULL) {
+            upload->callback(upload->userdata, upload->buffer, upload->offset, upload->size, false);
+        }
+    }
+
+    for (int i = 0; i < GBE_UPLOAD_QUEUE_MAX_BATCHES; i++) {
+        if (queue->batches[i].transferBuffer != NULL) {
+            SDL_ReleaseGPUTransferBuffer(queue->device, queue->batches[i].transferBuffer);
+        }
+    }
+
+    SDL_free(queue->pending);
+    SDL_free(queue->waiting);
+    SDL_zerop(queue);
+}
+
+bool GBE_QueueUpload(GBE_UploadQueue* queue, const void* data, Uint32 size, SDL_GPUBuffer* buffer, Uint32 offset, GBE_UploadCallback callback, void* userdata)
+{
+    SDL_assert(buffer != NULL);
+    SDL_assert(data != NULL || size == 0);
+
+    if (!Reserve(&queue->pending, &queue->maxPending, queue->numPending + 1)) {
+        return false;
+    }
+
+    queue->pending[queue->numPending++] = (GBE_QueuedUpload) {
+        .data = data,
+        .buffer = buffer,
+        .offset = offset,
+        .size = size,
+        .callback = callback,
+        .userdata = userdata,
+        .submitted = 0,
+        .batch = -1
+    };
+    return true;
+}
+
+void GBE_PumpUploadQueue(GBE_UploadQueue* queue)
+{
+    RetireBatches(queue, false);
+
+    if (queue->numPending > 0) {
+        SubmitBatch(queue);
+    }
+}
+
+void GBE_FlushUploadQueue(GBE_UploadQueue* queue)
+{
+    while (queue->numPending > 0) {
+        if (!SubmitBatch(queue)) {
+            // Out of batches: wait for the ones in flight and go again. If the submit
+            // itself is what failed there's nothing left to wait for, so give up.
+            bool anyInFlight = false;
+            for (int i = 0; i < GBE_UPLOAD_QUEUE_MAX_BATCHES; i++) {
+                anyInFlight |= queue->batches[i].fence != NULL;
+            }
+            if (!anyInFlight) {
+                break;
+            }
+            RetireBatches(queue, true);
+        }
+    }
+
+    RetireBatches(queue, true);
+}
+
+bool GBE_UploadQueueBusy(const GBE_UploadQueue* queue)
+{
+    return queue->numPending > 0 || queue->numWaiting > 0;
+}
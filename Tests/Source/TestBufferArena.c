@@ -0,0 +1,186 @@
+//
+//  TestBufferArena.c
+//  GBECommon tests
+//
+//  Hands out ranges of mixed sizes and strides from a buffer arena's buddy
+//  allocator and checks where they land: each one starts on a multiple of its
+//  stride, fits inside its block, and doesn't overlap any other. Then it frees
+//  them in a different order than they were allocated and checks the blocks
+//  all merge back into the one they started as. Only the book-keeping is
+//  created, so there's no GPU involved.
+//
+
+#include <SDL3/SDL.h>
+#include <GBECommon/GBE_BufferArena.h>
+
+#define ARENA_CAPACITY (64 * 1024)
+#define MAX_RANGES     64
+
+typedef struct TestAlloc {
+    Uint32 count;
+    Uint32 stride;
+} TestAlloc;
+
+// Strides that divide the minimum block size and ones that don't, in sizes from one
+// element up to a good chunk of the arena.
+static const TestAlloc kAllocs[] = {
+    { 1, 256 },
+    { 10, 12 },
+    { 100, 32 },
+    { 300, 24 },
+    { 1, 4 },
+    { 50, 48 },
+    { 3, 36 },
+    { 1000, 2 },
+    { 700, 20 },
+    { 64, 64 },
+    { 1, 6 },
+    { 129, 2 }
+};
+
+// The order they're freed in, chosen so that buddies come free at different times.
+static const int kFreeOrder[] = { 7, 2, 10, 0, 5, 11, 3, 9, 1, 6, 4, 8 };
+
+static const int kNumAllocs = SDL_arraysize(kAllocs);
+
+static int failures = 0;
+
+static void Check(bool condition, const char* what, Uint32 got, Uint32 expected)
+{
+    if (!condition) {
+        SDL_LogError(SDL_LOG_CATEGORY_TEST, "%s: got %u, expected %u", what, got, expected);
+        failures++;
+    }
+}
+
+static void CheckCount(const char* what, Uint32 got, Uint32 expected)
+{
+    Check(got == expected, what, got, expected);
+}
+
+static Uint32 BlockStart(const GBE_BufferRange* range)
+{
+    return range->block * GBE_ARENA_MIN_BLOCK_SIZE;
+}
+
+static Uint32 BlockEnd(const GBE_BufferArena* arena, const GBE_BufferRange* range)
+{
+    return BlockStart(range) + ((Uint32)GBE_ARENA_MIN_BLOCK_SIZE << arena->blockOrder[range->block]);
+}
+
+// Checks a range is where its stride says it can be, inside its own block.
+static void CheckRange(const GBE_BufferArena* arena, const GBE_BufferRange* range)
+{
+    Check(range->offset % range->stride == 0, "offset's distance past a multiple of the stride", range->offset % range->stride, 0);
+    CheckCount("first element", range->firstElement, range->offset / range->stride);
+    Check(range->offset >= BlockStart(range), "offset before its block", range->offset, BlockStart(range));
+    Check(range->offset + range->size <= BlockEnd(arena, range), "end past its block", range->offset + range->size, BlockEnd(arena, range));
+}
+
+// No two live blocks overlap.
+static void CheckNoOverlaps(const GBE_BufferArena* arena, const GBE_BufferRange* ranges, const bool* live, int count)
+{
+    for (int i = 0; i < count; i++) {
+        for (int j = i + 1; j < count; j++) {
+            if (!live[i] || !live[j]) {
+                continue;
+            }
+            bool apart = BlockEnd(arena, &ranges[i]) <= BlockStart(&ranges[j]) ||
+                BlockEnd(arena, &ranges[j]) <= BlockStart(&ranges[i]);
+            Check(apart, "block overlapping another at", BlockStart(&ranges[j]), BlockStart(&ranges[i]));
+        }
+    }
+}
+
+// With nothing allocated, the whole arena should be one free block again.
+static void CheckMergedBack(const GBE_BufferArena* arena)
+{
+    CheckCount("bytes in use", arena->bytesInUse, 0);
+    CheckCount("allocations", arena->numAllocations, 0);
+    for (int order = 0; order < arena->maxOrder; order++) {
+        Check(arena->freeLists[order] < 0, "free blocks left unmerged of order", (Uint32)order, (Uint32)arena->maxOrder);
+    }
+    CheckCount("start of the free whole-arena block", (Uint32)arena->freeLists[arena->maxOrder], 0);
+}
+
+int main(int argc, char* argv[])
+{
+    GBE_BufferArena arena;
+    if (!GBE_CreateBufferArenaBlocks(ARENA_CAPACITY, &arena)) {
+        return 1;
+    }
+    CheckCount("capacity", arena.capacity, ARENA_CAPACITY);
+
+    GBE_BufferRange ranges[MAX_RANGES];
+    bool live[MAX_RANGES] = {0};
+    Uint32 bytesInUse = 0;
+    for (int i = 0; i < kNumAllocs; i++) {
+        live[i] = GBE_BufferArenaAlloc(&arena, kAllocs[i].count, kAllocs[i].stride, &ranges[i]);
+        Check(live[i], "allocation failed, count", kAllocs[i].count, kAllocs[i].stride);
+        if (live[i]) {
+            CheckCount("range size", ranges[i].size, kAllocs[i].count * kAllocs[i].stride);
+            CheckRange(&arena, &ranges[i]);
+            bytesInUse += BlockEnd(&arena, &ranges[i]) - BlockStart(&ranges[i]);
+        }
+    }
+    CheckCount("bytes in use", arena.bytesInUse, bytesInUse);
+    CheckNoOverlaps(&arena, ranges, live, kNumAllocs);
+
+    // Nothing bigger than the arena fits, and with most of it in use, neither does a
+    // request for all of it.
+    GBE_BufferRange tooBig;
+    Check(!GBE_BufferArenaAlloc(&arena, ARENA_CAPACITY + 1, 1, &tooBig), "allocated more than the capacity", ARENA_CAPACITY + 1, 0);
+    Check(!GBE_BufferArenaAlloc(&arena, ARENA_CAPACITY, 1, &tooBig), "allocated the whole arena while in use", ARENA_CAPACITY, 0);
+
+    for (int i = 0; i < kNumAllocs; i++) {
+        int index = kFreeOrder[i];
+        if (live[index]) {
+            GBE_BufferArenaFree(&arena, &ranges[index]);
+            live[index] = false;
+        }
+    }
+    CheckMergedBack(&arena);
+
+    // Then again with sizes, strides and lifetimes all over the place: free a random live
+    // range every so often, and everything that's left at the end.
+    Uint32 seed = 12345;
+    for (int i = 0; i < 2000; i++) {
+        seed = seed * 1664525 + 1013904223;
+        int slot = (int)((seed >> 8) % MAX_RANGES);
+        if (live[slot]) {
+            GBE_BufferArenaFree(&arena, &ranges[slot]);
+            live[slot] = false;
+            continue;
+        }
+
+        seed = seed * 1664525 + 1013904223;
+        Uint32 stride = 1 + (seed >> 8) % 64;
+        seed = seed * 1664525 + 1013904223;
+        Uint32 count = 1 + (seed >> 8) % (2048 / stride + 1);
+        live[slot] = GBE_BufferArenaAlloc(&arena, count, stride, &ranges[slot]);
+        if (live[slot]) {
+            CheckRange(&arena, &ranges[slot]);
+        }
+    }
+    CheckNoOverlaps(&arena, ranges, live, MAX_RANGES);
+    for (int i = MAX_RANGES - 1; i >= 0; i--) {
+        if (live[i]) {
+            GBE_BufferArenaFree(&arena, &ranges[i]);
+        }
+    }
+    CheckMergedBack(&arena);
+
+    // Merged back, the whole arena can be handed out in one go.
+    GBE_BufferRange whole;
+    Check(GBE_BufferArenaAlloc(&arena, ARENA_CAPACITY, 1, &whole), "couldn't allocate the whole arena after freeing, capacity", ARENA_CAPACITY, 0);
+
+    GBE_DestroyBufferArena(&arena);
+
+    if (failures > 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_TEST, "%d buffer arena checks failed.", failures);
+        return 1;
+    }
+
+    SDL_Log("Buffer arena checks passed.");
+    return 0;
+}
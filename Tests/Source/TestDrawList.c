@@ -0,0 +1,131 @@
+//
+//  TestDrawList.c
+//  GBECommon tests
+//
+//  Sorts a known set of draws and checks how many pipeline and buffer binds
+//  baking it leaves. Nothing's drawn, so the pipelines and buffers are just
+//  made up pointers for the list to compare.
+//
+
+#include <SDL3/SDL.h>
+#include <GBECommon/GBE_DrawList.h>
+
+typedef struct TestDraw {
+    Uint32 pipeline;
+    Uint32 vertexBuffer;
+    float depth;
+    Sint32 vertexOffset;
+} TestDraw;
+
+// Added in this order. Sorted, they go pipeline, then vertex buffer (the material), then
+// nearest first; the two draws with the same key stay in the order they were added.
+static const TestDraw kDraws[] = {
+    { 1, 1, 4.0f, 0 },
+    { 0, 0, 2.0f, 0 },
+    { 1, 0, 1.0f, 0 },
+    { 0, 1, 3.0f, 0 },
+    { 0, 0, 1.0f, 0 },
+    { 1, 1, 2.0f, 0 },
+    { 0, 1, 1.0f, 0 },
+    { 1, 0, 3.0f, 0 },
+    { 0, 0, 3.0f, 0 },
+    { 1, 1, 1.0f, 0 },
+    { 0, 1, 2.0f, 0 },
+    { 1, 0, 2.0f, 0 },
+    { 0, 0, 2.0f, 1 }
+};
+
+static const Uint32 kNumDraws = SDL_arraysize(kDraws);
+
+static int failures = 0;
+
+static void Check(bool condition, const char* what, Uint32 got, Uint32 expected)
+{
+    if (!condition) {
+        SDL_LogError(SDL_LOG_CATEGORY_TEST, "%s: got %u, expected %u", what, got, expected);
+        failures++;
+    }
+}
+
+static void CheckCount(const char* what, Uint32 got, Uint32 expected)
+{
+    Check(got == expected, what, got, expected);
+}
+
+static Uint32 CountCommands(const GBE_DrawList* list, GBE_DrawCommandType type)
+{
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < list->numCommands; i++) {
+        if (list->commands[i].type == type) {
+            count++;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char* argv[])
+{
+    GBE_DrawList list;
+    if (!GBE_CreateDrawList(4, 0, &list)) {
+        return 1;
+    }
+
+    // Starting with room for 4 means adding these has to grow the list.
+    for (Uint32 i = 0; i < kNumDraws; i++) {
+        const TestDraw* draw = &kDraws[i];
+        GBE_DrawPacket packet = {
+            .key = GBE_MakeDrawKey(0, draw->pipeline, draw->vertexBuffer, draw->depth, false),
+            .pipeline = (SDL_GPUGraphicsPipeline*)(uintptr_t)(0x1000 + draw->pipeline * 0x100),
+            .vertexBuffer = { .buffer = (SDL_GPUBuffer*)(uintptr_t)(0x2000 + draw->vertexBuffer * 0x100) },
+            .indexBuffer = { .buffer = (SDL_GPUBuffer*)(uintptr_t)0x3000 },
+            .indexElementSize = SDL_GPU_INDEXELEMENTSIZE_16BIT,
+            .count = 36,
+            .numInstances = 1,
+            .vertexOffset = draw->vertexOffset
+        };
+        if (!GBE_AddDraw(&list, &packet, NULL, 0)) {
+            GBE_DestroyDrawList(&list);
+            return 1;
+        }
+    }
+    CheckCount("packets", list.numPackets, kNumDraws);
+
+    GBE_SortDrawList(&list);
+    const TestDraw* previous = NULL;
+    for (Uint32 i = 0; i < list.numPackets; i++) {
+        const TestDraw* draw = &kDraws[list.order[i].packet];
+        if (previous != NULL) {
+            bool inOrder = previous->pipeline < draw->pipeline ||
+                (previous->pipeline == draw->pipeline && previous->vertexBuffer < draw->vertexBuffer) ||
+                (previous->pipeline == draw->pipeline && previous->vertexBuffer == draw->vertexBuffer && previous->depth < draw->depth) ||
+                (previous->pipeline == draw->pipeline && previous->vertexBuffer == draw->vertexBuffer && previous->depth == draw->depth &&
+                 previous->vertexOffset < draw->vertexOffset);
+            Check(inOrder, "sorted position of packet", list.order[i].packet, i);
+        }
+        previous = draw;
+    }
+
+    // Four runs of draws sharing a pipeline and vertex buffer, in two runs sharing a
+    // pipeline, and one index buffer throughout.
+    if (!GBE_BakeDrawList(&list)) {
+        GBE_DestroyDrawList(&list);
+        return 1;
+    }
+    CheckCount("pipeline binds", CountCommands(&list, GBE_DRAW_COMMAND_BIND_PIPELINE), 2);
+    CheckCount("vertex buffer binds", CountCommands(&list, GBE_DRAW_COMMAND_BIND_VERTEX_BUFFER), 4);
+    CheckCount("index buffer binds", CountCommands(&list, GBE_DRAW_COMMAND_BIND_INDEX_BUFFER), 1);
+    CheckCount("storage buffer binds", CountCommands(&list, GBE_DRAW_COMMAND_BIND_STORAGE_BUFFER), 0);
+    CheckCount("uniform pushes", CountCommands(&list, GBE_DRAW_COMMAND_PUSH_UNIFORMS), 0);
+    CheckCount("draws", CountCommands(&list, GBE_DRAW_COMMAND_DRAW), kNumDraws);
+    CheckCount("binds skipped", list.bakedSkipped, (kNumDraws - 2) + (kNumDraws - 4) + (kNumDraws - 1));
+
+    GBE_DestroyDrawList(&list);
+
+    if (failures > 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_TEST, "%d draw list checks failed.", failures);
+        return 1;
+    }
+
+    SDL_Log("Draw list checks passed.");
+    return 0;
+}
@@ -0,0 +1,180 @@
+//
+//  TestFrameArena.c
+//  GBECommon tests
+//
+//  Checks that every thread's arena in GBE_JobArenas starts on a cache line of
+//  its own, then logs how long SDL_malloc and SDL_free take against frame
+//  arenas for the same blocks, on one thread and on the job system's threads.
+//  Fails if any allocation doesn't fit.
+//
+//  Takes the number of job threads as its argument: 0, the default, for one
+//  per core.
+//
+
+#include <SDL3/SDL.h>
+#include <GBECommon/GBE_FrameArena.h>
+
+// Each frame allocates this many blocks of 16 to 528 bytes, the way per-frame scratch
+// data might, and writes to both ends of each one.
+#define ARENA_BENCHMARK_BLOCKS 4096
+#define ARENA_BENCHMARK_MAX_BLOCK 528
+
+// Where AllocateBlocks gets its memory from: the calling thread's job arena, one frame
+// arena, or (with neither) SDL_malloc.
+typedef struct ArenaBenchmark {
+    GBE_JobArenas* jobArenas;
+    GBE_FrameArena* arena;
+    void** blocks;
+    SDL_AtomicInt failures;
+} ArenaBenchmark;
+
+static void AllocateBlocks(void* data, Uint32 begin, Uint32 end)
+{
+    ArenaBenchmark* benchmark = data;
+    for (Uint32 i = begin; i < end; i++) {
+        // Each block's size only depends on its index, so every run allocates the same.
+        Uint32 hash = i * 2654435761u;
+        hash ^= hash >> 16;
+        size_t size = 16 + hash % (ARENA_BENCHMARK_MAX_BLOCK - 15);
+
+        Uint8* block;
+        if (benchmark->jobArenas != NULL) {
+            block = GBE_JobArenaAlloc(benchmark->jobArenas, size, 16);
+        }
+        else if (benchmark->arena != NULL) {
+            block = GBE_FrameArenaAlloc(benchmark->arena, size, 16);
+        }
+        else {
+            block = SDL_malloc(size);
+        }
+        if (block == NULL) {
+            SDL_AddAtomicInt(&benchmark->failures, 1);
+        }
+        else {
+            block[0] = (Uint8)i;
+            block[size - 1] = (Uint8)i;
+        }
+        benchmark->blocks[i] = block;
+    }
+}
+
+static void FreeBlocks(void* data, Uint32 begin, Uint32 end)
+{
+    ArenaBenchmark* benchmark = data;
+    for (Uint32 i = begin; i < end; i++) {
+        SDL_free(benchmark->blocks[i]);
+    }
+}
+
+// Nanoseconds per block for `frames` frames' worth of allocations, freeing them one at a
+// time if they came from SDL_malloc, or resetting the arenas at the start of every frame.
+static double TimeAllocations(ArenaBenchmark* benchmark, GBE_JobSystem* jobs, int frames)
+{
+    Uint64 began = SDL_GetTicksNS();
+    for (int frame = 0; frame < frames; frame++) {
+        if (benchmark->arena != NULL) {
+            GBE_ResetFrameArena(benchmark->arena, (Uint64)frame);
+        }
+        if (benchmark->jobArenas != NULL) {
+            GBE_ResetJobArenas(benchmark->jobArenas, (Uint64)frame);
+        }
+
+        bool fromHeap = benchmark->arena == NULL && benchmark->jobArenas == NULL;
+        if (jobs != NULL) {
+            GBE_ParallelFor(jobs, ARENA_BENCHMARK_BLOCKS, 256, AllocateBlocks, benchmark);
+            if (fromHeap) {
+                GBE_ParallelFor(jobs, ARENA_BENCHMARK_BLOCKS, 256, FreeBlocks, benchmark);
+            }
+        }
+        else {
+            AllocateBlocks(benchmark, 0, ARENA_BENCHMARK_BLOCKS);
+            if (fromHeap) {
+                FreeBlocks(benchmark, 0, ARENA_BENCHMARK_BLOCKS);
+            }
+        }
+    }
+    return (double)(SDL_GetTicksNS() - began) / ((double)frames * ARENA_BENCHMARK_BLOCKS);
+}
+
+// Logs how long SDL_malloc and SDL_free take against a frame arena for the same blocks,
+// and again spread over the job system's threads, where the heap has to be shared and
+// each thread's arena doesn't.
+static bool BenchmarkArena(GBE_JobSystem* jobs)
+{
+    const int kFrames = 1000;
+    const size_t kArenaSize = ARENA_BENCHMARK_BLOCKS * (ARENA_BENCHMARK_MAX_BLOCK + 16);
+
+    ArenaBenchmark benchmark;
+    SDL_zero(benchmark);
+    GBE_FrameArena arena;
+    GBE_JobArenas jobArenas;
+    SDL_zero(jobArenas);
+    benchmark.blocks = SDL_malloc(sizeof(void*) * ARENA_BENCHMARK_BLOCKS);
+    bool created = GBE_CreateFrameArena(kArenaSize, 2, &arena) && benchmark.blocks != NULL &&
+        GBE_CreateJobArenas(jobs, kArenaSize, 1, &jobArenas);
+    if (!created) {
+        GBE_DestroyFrameArena(&arena);
+        SDL_free(benchmark.blocks);
+        return false;
+    }
+
+    double heapNS = TimeAllocations(&benchmark, NULL, kFrames);
+    benchmark.arena = &arena;
+    double arenaNS = TimeAllocations(&benchmark, NULL, kFrames);
+    benchmark.arena = NULL;
+
+    double threadedHeapNS = TimeAllocations(&benchmark, jobs, kFrames);
+    benchmark.jobArenas = &jobArenas;
+    double threadedArenaNS = TimeAllocations(&benchmark, jobs, kFrames);
+
+    bool passed = SDL_GetAtomicInt(&benchmark.failures) == 0;
+    SDL_Log("Arena: %.1f ns per SDL_malloc and SDL_free, %.1f ns per arena allocation (%zu bytes high-water); "
+        "on %d job threads, %.1f ns per block from the heap and %.1f ns from their arenas (%zu bytes high-water)%s",
+        heapNS, arenaNS, arena.highWaterMark, jobs->numThreads, threadedHeapNS, threadedArenaNS,
+        GBE_GetJobArenasHighWaterMark(&jobArenas), passed ? "" : ", some allocations FAILED");
+
+    GBE_DestroyJobArenas(&jobArenas);
+
+    GBE_DestroyFrameArena(&arena);
+    SDL_free(benchmark.blocks);
+    return passed;
+}
+
+// No two threads' arenas may share a cache line, or threads allocating at the same time
+// keep taking the line away from each other.
+static bool CheckJobArenaLayout(GBE_JobSystem* jobs)
+{
+    GBE_JobArenas jobArenas;
+    if (!GBE_CreateJobArenas(jobs, 1024, 1, &jobArenas)) {
+        return false;
+    }
+
+    bool passed = sizeof(GBE_JobArena) % GBE_CACHE_LINE_SIZE == 0;
+    for (int i = 0; i < jobArenas.numArenas; i++) {
+        uintptr_t address = (uintptr_t)&jobArenas.arenas[i];
+        passed = passed && address % GBE_CACHE_LINE_SIZE == 0;
+    }
+    if (!passed) {
+        SDL_LogError(SDL_LOG_CATEGORY_TEST, "Job arenas of %zu bytes at %p aren't each on cache lines of their own.",
+            sizeof(GBE_JobArena), (void*)jobArenas.arenas);
+    }
+
+    GBE_DestroyJobArenas(&jobArenas);
+    return passed;
+}
+
+int main(int argc, char* argv[])
+{
+    int numThreads = argc > 1 ? SDL_clamp(SDL_atoi(argv[1]), 0, GBE_MAX_JOB_THREADS) : 0;
+
+    // Jobs can only be started from the job system's own threads, and this one becomes
+    // one by creating it.
+    GBE_JobSystem jobs;
+    if (!GBE_CreateJobSystem(numThreads, &jobs)) {
+        return 1;
+    }
+
+    bool passed = CheckJobArenaLayout(&jobs) && BenchmarkArena(&jobs);
+    GBE_DestroyJobSystem(&jobs);
+    return passed ? 0 : 1;
+}
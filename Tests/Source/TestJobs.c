@@ -0,0 +1,125 @@
+//
+//  TestJobs.c
+//  GBECommon tests
+//
+//  Logs how many empty jobs a second the job system gets through and how long
+//  a fork and join of one item per thread takes, then checks it under load:
+//  every item of a big parallel for has to be run exactly once, and every leaf
+//  of a deep job tree has to run. The tests are built with ThreadSanitizer
+//  where the compiler has it, so this checks for data races at the same time.
+//
+//  Takes the number of threads as its argument: 0, the default, for one per
+//  core.
+//
+
+#include <SDL3/SDL.h>
+#include <GBECommon/GBE_Jobs.h>
+
+// Jobs that do nothing, a range that marks off every item it's given, and a tree of jobs
+// each waiting on 4 children, which counts its leaves.
+static void EmptyJob(void* data)
+{
+    (void)data;
+}
+
+static void MarkRange(void* data, Uint32 begin, Uint32 end)
+{
+    Uint8* marks = data;
+    for (Uint32 i = begin; i < end; i++) {
+        marks[i]++;
+    }
+}
+
+typedef struct JobTreeNode {
+    GBE_JobSystem* jobs;
+    SDL_AtomicInt* leaves;
+    int depth;
+} JobTreeNode;
+
+static void RunJobTree(void* data)
+{
+    JobTreeNode* node = data;
+    if (node->depth == 0) {
+        SDL_AddAtomicInt(node->leaves, 1);
+        return;
+    }
+
+    // The children live on this job's stack, which is fine since it waits for them.
+    JobTreeNode children[4];
+    GBE_JobCounter counter;
+    SDL_SetAtomicInt(&counter.pending, 0);
+    for (int i = 0; i < 4; i++) {
+        children[i] = (JobTreeNode) { node->jobs, node->leaves, node->depth - 1 };
+        GBE_RunJob(node->jobs, RunJobTree, &children[i], &counter);
+    }
+    GBE_WaitForCounter(node->jobs, &counter);
+}
+
+static bool BenchmarkJobs(GBE_JobSystem* jobs)
+{
+    const Uint32 kEmptyJobs = 1000000;
+    const Uint32 kForkJoins = 10000;
+    const Uint32 kMarks = 1000003;
+    const int kTreeDepth = 6;
+
+    GBE_JobCounter counter;
+    SDL_SetAtomicInt(&counter.pending, 0);
+    Uint64 began = SDL_GetTicksNS();
+    for (Uint32 i = 0; i < kEmptyJobs; i++) {
+        GBE_RunJob(jobs, EmptyJob, NULL, &counter);
+    }
+    GBE_WaitForCounter(jobs, &counter);
+    double emptySeconds = (double)(SDL_GetTicksNS() - began) / SDL_NS_PER_SECOND;
+
+    Uint8 forkJoinMarks[GBE_MAX_JOB_THREADS] = {0};
+    began = SDL_GetTicksNS();
+    for (Uint32 i = 0; i < kForkJoins; i++) {
+        GBE_ParallelFor(jobs, (Uint32)jobs->numThreads, 1, MarkRange, forkJoinMarks);
+    }
+    double forkJoinUS = (double)(SDL_GetTicksNS() - began) / SDL_NS_PER_US / kForkJoins;
+
+    Uint8* marks = SDL_calloc(kMarks, 1);
+    if (marks == NULL) {
+        return false;
+    }
+    bool passed = true;
+    for (int round = 0; round < 20 && passed; round++) {
+        SDL_memset(marks, 0, kMarks);
+        GBE_ParallelFor(jobs, kMarks, 1, MarkRange, marks);
+        for (Uint32 i = 0; i < kMarks && passed; i++) {
+            passed = marks[i] == 1;
+        }
+
+        SDL_AtomicInt leaves;
+        SDL_SetAtomicInt(&leaves, 0);
+        JobTreeNode root = { jobs, &leaves, kTreeDepth };
+        RunJobTree(&root);
+        passed = passed && SDL_GetAtomicInt(&leaves) == 1 << (2 * kTreeDepth);
+    }
+    SDL_free(marks);
+
+    Uint64 executed = 0, stolen = 0, ranInline = 0;
+    for (int i = 0; i < jobs->numThreads; i++) {
+        executed += jobs->threads[i].executed;
+        stolen += jobs->threads[i].stolen;
+        ranInline += jobs->threads[i].ranInline;
+    }
+    SDL_Log("Jobs: %d threads, %.0f empty jobs/s, %.2f us per fork-join, %llu jobs run (%llu stolen, %llu run inline), stress test %s",
+        jobs->numThreads, kEmptyJobs / emptySeconds, forkJoinUS, (unsigned long long)executed, (unsigned long long)stolen,
+        (unsigned long long)ranInline, passed ? "passed" : "FAILED");
+    return passed;
+}
+
+int main(int argc, char* argv[])
+{
+    int numThreads = argc > 1 ? SDL_clamp(SDL_atoi(argv[1]), 0, GBE_MAX_JOB_THREADS) : 0;
+
+    GBE_JobSystem jobs;
+    if (!GBE_CreateJobSystem(numThreads, &jobs)) {
+        return 1;
+    }
+
+    bool passed = BenchmarkJobs(&jobs);
+    GBE_DestroyJobSystem(&jobs);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# benchmark-cubes.sh
+#
+# Runs Example 3 headless at increasing cube counts, once for each way of
+# getting the cubes' transforms to the GPU, and prints the summary line each
+# run logs on exit. Run it from the directory the example was built in (the
+# one with the shaders copied into it), e.g.
+#
+#     Tools/benchmark-cubes.sh ./gbe-example3-uniforms
+#
+# FRAMES, COUNTS and MODES can be set in the environment to change what's run.
+# Pushing uniforms means one draw per cube, so it skips counts bigger than
+# 100000 (or PUSH_LIMIT).
+
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 path/to/gbe-example3-uniforms [extra example options...]" >&2
+    exit 1
+fi
+
+example="$1"
+shift
+
+frames=${FRAMES:-300}
+counts=${COUNTS:-"1 10 100 1000 10000 100000 1000000"}
+modes=${MODES:-"push storage instanced gpu-culled"}
+pushLimit=${PUSH_LIMIT:-100000}
+
+for mode in $modes; do
+    for count in $counts; do
+        if [ "$mode" = push ] && [ "$count" -gt "$pushLimit" ]; then
+            continue
+        fi
+
+        summary=$("$example" --headless --no-debug --frames "$frames" --cubes "$count" --transforms "$mode" "$@" 2>&1 \
+            | grep "Summary:" | sed 's/.*Summary: //')
+        if [ -z "$summary" ]; then
+            echo "$count cubes with --transforms $mode didn't finish; run it by hand to see why." >&2
+            exit 1
+        fi
+
+        echo "$summary"
+    done
+done
@@ -0,0 +1,46 @@
+#!/bin/sh
+#
+# benchmark-fill.sh
+#
+# Runs Example 3 headless with its cubes stacked one behind the other, each
+# covering most of the screen, so nearly all the GPU's time goes into shading
+# pixels. Every layer count is run once per blend preset: opaque cubes test and
+# write depth, so the GPU can skip shading the layers hidden behind the first,
+# while blended ones have to shade and blend every layer. Run it from the
+# directory the example was built in, e.g.
+#
+#     Tools/benchmark-fill.sh ./gbe-example3-uniforms
+#
+# FRAMES, LAYERS, BLENDS, TRANSFORMS and SIZE can be set in the environment to
+# change what's run. TRANSFORMS defaults to storage, which reads every cube's
+# transform from a storage buffer and draws them all with a single draw call,
+# to keep per-draw costs out of the numbers.
+
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 path/to/gbe-example3-uniforms [extra example options...]" >&2
+    exit 1
+fi
+
+example="$1"
+shift
+
+frames=${FRAMES:-300}
+layers=${LAYERS:-"1 2 4 8 16 32 64"}
+blends=${BLENDS:-"opaque alpha additive"}
+transforms=${TRANSFORMS:-storage}
+size=${SIZE:-1920x1080}
+
+for blend in $blends; do
+    for count in $layers; do
+        summary=$("$example" --headless --no-debug --frames "$frames" --size "$size" --stacked --cubes "$count" \
+            --transforms "$transforms" --blend "$blend" "$@" 2>&1 \
+            | grep "Summary:" | sed 's/.*Summary: //')
+        if [ -z "$summary" ]; then
+            echo "$count $blend layers with --transforms $transforms didn't finish; run it by hand to see why." >&2
+            exit 1
+        fi
+        echo "$summary"
+    done
+done
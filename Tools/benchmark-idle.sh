@@ -0,0 +1,49 @@
+#!/bin/sh
+#
+# benchmark-idle.sh
+#
+# Runs an example for a while with each frame policy: drawing every frame,
+# drawing on demand while SDL waits for events in between, and drawing on
+# demand while still iterating at a low idle rate. For each one it prints how
+# much CPU time the run used, as a stand-in for power use, which there's no
+# portable way to read. Run it from the directory the example was built in,
+# e.g.
+#
+#     Tools/benchmark-idle.sh ./gbe-example2-drawing-primitives
+#
+# SECONDS_PER_RUN, IDLE_RATE and HEADLESS can be set in the environment to
+# change what's run. Runs are headless by default; set HEADLESS=0 to run in a
+# window and see what vsync and the compositor do to the numbers. Anything
+# after the example is passed along to it.
+
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 path/to/example [extra example options...]" >&2
+    exit 1
+fi
+
+example="$1"
+shift
+
+seconds=${SECONDS_PER_RUN:-10}
+idleRate=${IDLE_RATE:-10}
+headless=${HEADLESS:-1}
+
+if [ "$headless" = 1 ]; then
+    set -- --headless "$@"
+fi
+
+for policy in "--continuous" "--on-demand --idle-rate 0" "--on-demand --idle-rate $idleRate"; do
+    # time -p prints "real", "user" and "sys" lines in seconds on stderr, along with
+    # whatever the example logs.
+    /usr/bin/time -p "$example" --no-debug --run-for "$seconds" $policy "$@" 2>&1 >/dev/null \
+        | awk -v policy="$policy" '
+            /^real / { real = $2 }
+            /^user / { user = $2 }
+            /^sys /  { sys = $2 }
+            END {
+                printf "%s: %.2f s CPU (%.2f user, %.2f sys) over %.2f s, %.1f%% of a core\n",
+                    policy, user + sys, user, sys, real, real > 0 ? (user + sys) / real * 100 : 0
+            }'
+done
@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# benchmark-threads.sh
+#
+# Runs Example 3 headless in push mode, one draw per cube, recording the draws
+# on more and more threads at once, and prints the summary line each run logs
+# on exit. The CPU recording time per frame is the number to watch as the
+# thread count goes up. Run it from the directory the example was built in,
+# e.g.
+#
+#     Tools/benchmark-threads.sh ./gbe-example3-uniforms
+#
+# FRAMES, COUNTS and THREADS can be set in the environment to change what's run.
+# Extra options (like --draw-list) are passed along to the example.
+
+set -e
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 path/to/gbe-example3-uniforms [extra example options...]" >&2
+    exit 1
+fi
+
+example="$1"
+shift
+
+frames=${FRAMES:-300}
+counts=${COUNTS:-"10000 100000"}
+threads=${THREADS:-"1 2 4 8"}
+
+for count in $counts; do
+    for threadCount in $threads; do
+        summary=$("$example" --headless --no-debug --frames "$frames" --cubes "$count" --transforms push \
+            --record-threads "$threadCount" "$@" 2>&1 \
+            | grep "Summary:" | sed 's/.*Summary: //')
+        if [ -z "$summary" ]; then
+            echo "$count cubes on $threadCount recording threads didn't finish; run it by hand to see why." >&2
+            exit 1
+        fi
+
+        echo "$summary"
+    done
+done
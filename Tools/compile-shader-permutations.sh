@@ -0,0 +1,71 @@
+#!/bin/sh
+#
+# compile-shader-permutations.sh
+#
+# Compiles every variant listed in a shader's permutation manifest. Give it the
+# HLSL source of a shader, e.g.
+#
+#     Tools/compile-shader-permutations.sh Example3-Uniforms/Resources/SpinningCube.vert.hlsl
+#
+# and it reads SpinningCube.vert.permutations from the same directory. For each
+# `variant <mask>` line it turns on the defines named by the matching `feature`
+# lines and writes SpinningCube-<mask>.vert.dxil and .spv next to the source, or
+# into the directory given as a second argument. If spirv-cross is on the PATH it
+# also writes the Metal version (.msl); otherwise the .msl variants have to be
+# written by hand like the rest of our Metal shaders. DXC can be set to the dxc
+# to use, if it isn't on the PATH.
+#
+# The plain shader (variant 0) isn't touched; compile it the usual way.
+
+set -e
+
+if [ $# -lt 1 ] || [ $# -gt 2 ]; then
+    echo "usage: $0 path/to/Shader.<vert|frag>.hlsl [output directory]" >&2
+    exit 1
+fi
+
+source="$1"
+directory=$(dirname "$source")
+outputDirectory=${2:-$directory}
+dxc=${DXC:-dxc}
+name=$(basename "$source" .hlsl)   # e.g. SpinningCube.vert
+shader=${name%.*}                  # SpinningCube
+stage=${name##*.}                  # vert
+manifest="$directory/$name.permutations"
+
+case "$stage" in
+    vert) profile=vs_6_0; mslEntryPoint=vertex_main ;;
+    frag) profile=ps_6_0; mslEntryPoint=fragment_main ;;
+    *) echo "Don't know how to compile a '$stage' shader" >&2; exit 1 ;;
+esac
+
+if [ ! -f "$manifest" ]; then
+    echo "$manifest doesn't exist; nothing to do." >&2
+    exit 1
+fi
+
+# Collect the names of the feature bits first, so variant lines can appear anywhere.
+features=$(awk '$1 == "feature" { print $2 ":" $3 }' "$manifest")
+
+for mask in $(awk '$1 == "variant" { print $2 }' "$manifest"); do
+    value=$(printf '%d' "$mask")
+    defines=""
+    for feature in $features; do
+        bit=${feature%%:*}
+        define=${feature#*:}
+        if [ $(( (value >> bit) & 1 )) -eq 1 ]; then
+            defines="$defines -D $define=1"
+        fi
+    done
+
+    output="$outputDirectory/$shader-$(printf '%x' "$value").$stage"
+    echo "$output:$defines"
+
+    "$dxc" -T $profile $defines "$source" -Fo "$output.dxil"
+    "$dxc" -spirv -T $profile $defines "$source" -Fo "$output.spv"
+
+    if command -v spirv-cross > /dev/null; then
+        spirv-cross "$output.spv" --msl --msl-version 20100 \
+            --rename-entry-point main $mslEntryPoint $stage --output "$output.msl"
+    fi
+done